@@ -0,0 +1,524 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+/* --- Banc d'essai : microbenchmarks des files et simulations completes a grande echelle --- */
+// Usage : bench [--quick] [--micro | --e2e] [--threads N] [--output fichier] [--baseline fichier] [--tolerance %]
+// Chaque resultat est une ligne JSON ; avec --baseline, les resultats sont compares a une
+// execution precedente et le programme sort en erreur si une mesure regresse au-dela de la tolerance.
+
+// Compte les allocations faites par les bibliotheques (les en-tetes sont inclus apres les macros)
+atomic_long benchAllocations;
+
+void* countedMalloc(size_t size) {
+    atomic_fetch_add_explicit(&benchAllocations, 1, memory_order_relaxed);
+    return malloc(size);
+}
+
+void* countedRealloc(void* p, size_t size) {
+    atomic_fetch_add_explicit(&benchAllocations, 1, memory_order_relaxed);
+    return realloc(p, size);
+}
+
+#define malloc(size) countedMalloc(size)
+#define realloc(p, size) countedRealloc(p, size)
+
+#include "../libraries/parallel.h"
+#include "../libraries/montecarlo.h"
+#include "../libraries/meso.h"
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define BENCH_REGRESSION_TOLERANCE 10.0 // Ecart tolere par rapport a la reference (%), par defaut
+#define BENCH_LOG_PATH "bench_log.bin"  // Journal temporaire du benchmark de logQueueState
+#define BENCH_MAX_RESULTS 64
+#define BENCH_LANE_STATE_INTERSECTIONS 32768 // 131072 voies pour le noyau de l'etat des voies
+#define BENCH_DEMAND_PATH "bench_demand"     // Demandes temporaires (.csv et .bin) du benchmark de relecture
+#define BENCH_DEMAND_INTERSECTIONS 100
+#define BENCH_ROUTE_GRID 64                  // Grille de 64 x 64 intersections pour la table de routage
+
+// Scenario de bout en bout : un corridor de "intersections" files de capacite "capacity"
+typedef struct {
+    int intersections;
+    int capacity;
+    int ticks;
+} EndToEndCase;
+
+static const EndToEndCase endToEndCases[] = {
+    {1, 4, 36000},
+    {1, 10000, 36000},
+    {100, 4, 3600},
+    {100, 100, 3600},
+    {100, 10000, 3600},
+    {10000, 4, 600},
+    {10000, 100, 600}
+};
+
+// Resultat memorise pour la comparaison avec la reference
+typedef struct {
+    char name[64];
+    double value;      // ns_per_op (micro) ou ticks_per_sec (bout en bout)
+    int higherIsBetter;
+} BenchResult;
+
+BenchResult benchResults[BENCH_MAX_RESULTS];
+int benchResultCount = 0;
+
+// Horloge monotone en secondes
+double benchNow() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+// Pic de memoire residente du processus (Ko)
+long peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#endif
+}
+
+void recordResult(const char* name, double value, int higherIsBetter) {
+    if (benchResultCount == BENCH_MAX_RESULTS) return;
+    BenchResult* r = &benchResults[benchResultCount++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->value = value;
+    r->higherIsBetter = higherIsBetter;
+}
+
+// Ecrit le resultat d'un microbenchmark
+void reportMicro(FILE* out, const char* name, long ops, double seconds, long extra) {
+    double nsPerOp = 1e9 * seconds / (double)ops;
+    fprintf(out, "{\"suite\":\"micro\",\"name\":\"%s\",\"ops\":%ld,\"seconds\":%.6f,\"ns_per_op\":%.3f,\"dropped\":%ld}\n",
+            name, ops, seconds, nsPerOp, extra);
+    fflush(out);
+    recordResult(name, nsPerOp, 0);
+}
+
+// Cree "count" vehicules dans le pool (le tableau est fourni par l'appelant)
+void createBenchVehicles(MemoryPool* pool, Vehicule** vehicles, int count) {
+    for (int i = 0; i < count; i++) {
+        vehicles[i] = createVehicule(pool, i + 1, (VehiculeType)(i % 3), 0, NORTH, (TurnDirection)(i % 3));
+    }
+}
+
+void releaseBenchVehicles(MemoryPool* pool, Vehicule** vehicles, int count) {
+    for (int i = 0; i < count; i++) {
+        releaseVehicule(pool, vehicles[i]);
+    }
+}
+
+// enqueue/dequeue : remplit puis vide une file de 1024 places
+void benchEnqueueDequeue(FILE* out, long ops) {
+    const int size = 1024;
+    MemoryPool pool;
+    initPool(&pool, sizeof(Vehicule), VEHICLE_POOL_CHUNK);
+    Vehicule* vehicles[1024];
+    createBenchVehicles(&pool, vehicles, size);
+    Queue* q = createQueue(size, 1, NORTH);
+
+    long rounds = ops / (2 * size) + 1;
+    double start = benchNow();
+    for (long r = 0; r < rounds; r++) {
+        for (int i = 0; i < size; i++) enqueue(q, vehicles[i], NULL, NULL);
+        for (int i = 0; i < size; i++) dequeue(q, NULL);
+    }
+    double elapsed = benchNow() - start;
+    reportMicro(out, "enqueue_dequeue", rounds * 2 * size, elapsed, 0);
+
+    freeQueue(q);
+    releaseBenchVehicles(&pool, vehicles, size);
+    destroyPool(&pool);
+}
+
+// processQueue : passage au vert d'une file pleine vers les voies de retour
+// (batch : tout le credit d'un coup, lots de DISCHARGE_BATCH_MAX ; sinon un vehicule par etage)
+void benchProcessQueue(FILE* out, long ops, int batch) {
+    const int size = 1024;
+    MemoryPool pool;
+    initPool(&pool, sizeof(Vehicule), VEHICLE_POOL_CHUNK);
+    Vehicule* vehicles[1024];
+    createBenchVehicles(&pool, vehicles, size);
+    lane lanes[4];
+    lane* lanePtrs[4];
+    for (int i = 0; i < 4; i++) {
+        Createlane(&lanes[i], size, i + 1, (Direction)i);
+        lanePtrs[i] = &lanes[i];
+    }
+    Queue* aller = lanes[NORTH].aller;
+    aller->lightState = GREEN;
+    LaneMetrics metrics;
+    memset(&metrics, 0, sizeof(metrics));
+
+    long rounds = ops / size + 1;
+    double elapsed = 0.0;
+    for (long r = 0; r < rounds; r++) {
+        for (int i = 0; i < size; i++) enqueue(aller, vehicles[i], NULL, NULL);
+        double start = benchNow();
+        unsigned long stage = 0;
+        while (!isEmpty(aller)) {
+            int credit = batch ? DISCHARGE_BATCH_MAX * 100 : vehicleHeadway(queueFront(aller), aller->config);
+            processQueue(aller, NULL, NULL, stage++, lanePtrs, 4, &metrics, &credit, 0);
+        }
+        elapsed += benchNow() - start;
+        for (int d = 0; d < 4; d++) {
+            while (!isEmpty(lanes[d].retour)) dequeue(lanes[d].retour, NULL);
+        }
+    }
+    reportMicro(out, batch ? "processQueue_batch" : "processQueue", rounds * size, elapsed, 0);
+
+    for (int i = 0; i < 4; i++) {
+        freeQueue(lanes[i].aller);
+        freeQueue(lanes[i].retour);
+    }
+    releaseBenchVehicles(&pool, vehicles, size);
+    destroyPool(&pool);
+}
+
+// detectTrafficJam et adjustLightDurationsForPair sur des files de remplissages varies
+void benchJamDetection(FILE* out, long ops) {
+    MemoryPool pool;
+    initPool(&pool, sizeof(Vehicule), VEHICLE_POOL_CHUNK);
+    Vehicule* vehicles[16];
+    createBenchVehicles(&pool, vehicles, 16);
+    Queue* queues[4];
+    for (int i = 0; i < 4; i++) {
+        queues[i] = createQueue(QUEUE_CAPACITY, i + 1, (Direction)i);
+        for (int k = 0; k < i && k < QUEUE_CAPACITY; k++) enqueue(queues[i], vehicles[i * 4 + k], NULL, NULL);
+    }
+
+    volatile int sink = 0;
+    double start = benchNow();
+    for (long i = 0; i < ops; i++) {
+        sink += detectTrafficJam(queues[i & 3]);
+        sink += adjustLightDurationsForPair(queues[i & 3], queues[(i + 1) & 3]).greenDuration;
+    }
+    double elapsed = benchNow() - start;
+    reportMicro(out, "jam_detection_adjust", ops, elapsed, 0);
+
+    for (int i = 0; i < 4; i++) freeQueue(queues[i]);
+    releaseBenchVehicles(&pool, vehicles, 16);
+    destroyPool(&pool);
+}
+
+// updateLaneState : passage d'un pas de temps sur l'etat de BENCH_LANE_STATE_INTERSECTIONS * 4 voies
+// (une mesure = une voie : un pas complet dure ns_per_op * 4 * BENCH_LANE_STATE_INTERSECTIONS)
+void benchLaneStateKernel(FILE* out, long ops) {
+    LaneState lanes;
+    if (!initLaneState(&lanes, BENCH_LANE_STATE_INTERSECTIONS, &activeScenario)) return;
+    long laneCount = 4L * BENCH_LANE_STATE_INTERSECTIONS;
+    for (long l = 0; l < 4L * lanes.stride; l++) {
+        lanes.size[l] = (int)(l % (QUEUE_CAPACITY + 1)); // remplissages varies
+    }
+    long ticks = (ops + laneCount - 1) / laneCount;
+    double start = benchNow();
+    for (long t = 0; t < ticks; t++) {
+        updateLaneState(&lanes, 0, BENCH_LANE_STATE_INTERSECTIONS);
+    }
+    double elapsed = benchNow() - start;
+    reportMicro(out, "lane_state_kernel", ticks * laneCount, elapsed, 0);
+    freeLaneState(&lanes);
+}
+
+// pushToTrafficHistory : historique en memoire seulement (sans fichier persistant)
+void benchHistoryPush(FILE* out, long ops) {
+    TrafficHistoryStack history;
+    initTrafficHistory(&history, (size_t)activeScenario.historyMemoryLimit);
+    const int size = 4096;
+    Vehicule* vehicles[4096];
+    createBenchVehicles(&history.vehicles, vehicles, size);
+    for (int i = 0; i < size; i++) vehicles[i]->queueTime = (unsigned int)i; // cumuls de plusieurs minutes
+
+    long rounds = ops / size + 1;
+    double elapsed = 0.0;
+    for (long r = 0; r < rounds; r++) {
+        double start = benchNow();
+        for (int i = 0; i < size; i++) pushToTrafficHistory(&history, vehicles[i]);
+        elapsed += benchNow() - start;
+    }
+    reportMicro(out, "pushToTrafficHistory", rounds * size, elapsed, 0);
+
+    releaseBenchVehicles(&history.vehicles, vehicles, size);
+    freeTrafficHistory(&history);
+}
+
+// logQueueState : cout cote simulation de la publication des enregistrements
+// "keyframe" : file pleine decrite entierement a chaque appel ; sinon un pas typique des
+// differences : un vehicule sort, un autre entre (deux enregistrements), puis l'appel du pas
+void benchLogQueueState(FILE* out, long ops, int keyframe) {
+    TrafficLog* log = openTrafficLog(BENCH_LOG_PATH, TRAFFIC_LOG_CAPACITY);
+    if (log == NULL) {
+        fprintf(stderr, "Impossible de creer %s\n", BENCH_LOG_PATH);
+        return;
+    }
+    MemoryPool pool;
+    initPool(&pool, sizeof(Vehicule), VEHICLE_POOL_CHUNK);
+    Vehicule* vehicles[QUEUE_CAPACITY];
+    createBenchVehicles(&pool, vehicles, QUEUE_CAPACITY);
+    Queue* q = createQueue(QUEUE_CAPACITY, 1, NORTH);
+    for (int i = 0; i < QUEUE_CAPACITY; i++) enqueue(q, vehicles[i], NULL, NULL);
+
+    // Par lots bien plus petits que l'anneau : le thread d'ecriture le vide entre deux lots
+    // (attente non mesuree), si bien qu'on mesure la publication et non les pertes
+    long batch = TRAFFIC_LOG_CAPACITY / 8 / (QUEUE_CAPACITY + 2);
+    double elapsed = 0.0;
+    for (long done = 0; done < ops; done += batch) {
+        double start = benchNow();
+        for (long i = 0; i < batch; i++) {
+            if (!keyframe) enqueue(q, dequeue(q, log), log, NULL);
+            logQueueState(q, log, keyframe);
+        }
+        elapsed += benchNow() - start;
+        usleep(5000);
+    }
+    ops = (ops + batch - 1) / batch * batch;
+    long dropped = (long)atomic_load(&log->dropped);
+    closeTrafficLog(log);
+    remove(BENCH_LOG_PATH);
+    reportMicro(out, keyframe ? "logQueueState" : "logQueueState_delta", ops, elapsed, dropped);
+
+    freeQueue(q);
+    releaseBenchVehicles(&pool, vehicles, QUEUE_CAPACITY);
+    destroyPool(&pool);
+}
+
+// Relecture d'une demande enregistree : lecture et repartition de chaque arrivee (stageDemand),
+// depuis un CSV puis depuis le binaire equivalent (une mesure = une arrivee)
+void benchDemandIngest(FILE* out, long ops) {
+    char csvPath[64], binPath[64];
+    snprintf(csvPath, sizeof(csvPath), "%s.csv", BENCH_DEMAND_PATH);
+    snprintf(binPath, sizeof(binPath), "%s.bin", BENCH_DEMAND_PATH);
+    FILE* csv = fopen(csvPath, "w");
+    FILE* bin = fopen(binPath, "wb");
+    if (csv == NULL || bin == NULL) {
+        fprintf(stderr, "Impossible de creer %s\n", BENCH_DEMAND_PATH);
+        if (csv != NULL) fclose(csv);
+        if (bin != NULL) fclose(bin);
+        return;
+    }
+    static const char* origins[] = {"NORD", "SUD", "EST", "OUEST"};
+    static const char* types[] = {"CAR", "BUS", "BIKE", "EMERGENCY"};
+    static const char* turns[] = {"LEFT", "RIGHT", "STRAIGHT"};
+    DemandFileHeader header = {DEMAND_MAGIC, DEMAND_VERSION, sizeof(DemandRecord), 0};
+    fwrite(&header, sizeof(header), 1, bin);
+    fprintf(csv, "time,origin,type,turn,intersection\n");
+    for (long i = 0; i < ops; i++) {
+        DemandRecord r;
+        r.time = (unsigned int)(i / BENCH_DEMAND_INTERSECTIONS);
+        r.intersection = (unsigned short)(i % BENCH_DEMAND_INTERSECTIONS);
+        r.origin = (unsigned char)(i % 4);
+        r.typeTurn = (unsigned char)((i / 4) % 4 | ((i / 16) % 3) << 4);
+        fprintf(csv, "%u,%s,%s,%s,%u\n", r.time, origins[r.origin], types[demandType(&r)],
+                turns[demandTurn(&r)], r.intersection);
+        fwrite(&r, sizeof(r), 1, bin);
+    }
+    fclose(csv);
+    fclose(bin);
+
+    const char* paths[] = {csvPath, binPath};
+    const char* names[] = {"demand_ingest_csv", "demand_ingest_binary"};
+    DemandBatch batches[BENCH_DEMAND_INTERSECTIONS];
+    memset(batches, 0, sizeof(batches));
+    for (int f = 0; f < 2; f++) {
+        DemandStream stream;
+        if (!openDemandStream(&stream, paths[f])) continue;
+        unsigned long ticks = (unsigned long)(ops / BENCH_DEMAND_INTERSECTIONS) + 1;
+        double start = benchNow();
+        for (unsigned long t = 0; t < ticks; t++) {
+            stageDemand(&stream, batches, BENCH_DEMAND_INTERSECTIONS, t);
+            for (int i = 0; i < BENCH_DEMAND_INTERSECTIONS; i++) batches[i].count = 0;
+        }
+        double elapsed = benchNow() - start;
+        reportMicro(out, names[f], (long)stream.records, elapsed, (long)stream.invalid);
+        closeDemandStream(&stream);
+    }
+    for (int i = 0; i < BENCH_DEMAND_INTERSECTIONS; i++) free(batches[i].records);
+    remove(csvPath);
+    remove(binPath);
+}
+
+// Table des prochains sauts d'une grille de "side" x "side" intersections sur "threads" threads
+// (une mesure = une paire origine-destination)
+void benchRouteTable(FILE* out, int side, int threads) {
+    RoadGraph g;
+    RouteTable t;
+    if (!buildGridGraph(&g, side, side, LINK_TRAVEL_TIME)) return;
+    double start = benchNow();
+    int built = buildRouteTable(&t, &g, threads);
+    double elapsed = benchNow() - start;
+    if (built) {
+        reportMicro(out, "route_table_build", (long)g.count * g.count, elapsed, 0);
+        freeRouteTable(&t);
+    }
+    freeRoadGraph(&g);
+}
+
+// Simulation complete d'un corridor : debit en pas de temps et en vehicules par seconde
+void benchEndToEnd(FILE* out, const EndToEndCase* c, int ticks, int threads) {
+    ScenarioConfig config = activeScenario;
+    config.queueCapacity = c->capacity;
+    long allocationsBefore = atomic_load(&benchAllocations);
+
+    RoadNetwork net;
+    buildCorridor(&net, c->intersections, &config, config.seed);
+    double start = benchNow();
+    runNetworkParallel(&net, 0, (unsigned long)ticks, threads);
+    double elapsed = benchNow() - start;
+
+    unsigned long long vehicles = 0;
+    long poolChunks = 0;
+    for (int i = 0; i < net.count; i++) {
+        for (int d = 0; d < 4; d++) {
+            for (int t = 0; t < VEHICLE_TYPE_COUNT; t++) {
+                vehicles += net.nodes[i].metrics.lanes[d].served[t] + net.nodes[i].metrics.lanes[d].lost[t];
+            }
+        }
+        poolChunks += net.pools[i].chunkCount;
+    }
+    long allocations = atomic_load(&benchAllocations) - allocationsBefore;
+    freeRoadNetwork(&net);
+
+    char name[64];
+    snprintf(name, sizeof(name), "corridor_%dx%d", c->intersections, c->capacity);
+    double ticksPerSec = (double)ticks / elapsed;
+    fprintf(out, "{\"suite\":\"e2e\",\"name\":\"%s\",\"intersections\":%d,\"capacity\":%d,\"ticks\":%d,"
+                 "\"threads\":%d,\"seconds\":%.6f,\"ticks_per_sec\":%.1f,\"intersection_ticks_per_sec\":%.1f,"
+                 "\"vehicles_per_sec\":%.1f,\"allocations\":%ld,\"pool_chunks\":%ld,\"peak_rss_kb\":%ld}\n",
+            name, c->intersections, c->capacity, ticks, threads, elapsed, ticksPerSec,
+            ticksPerSec * c->intersections, (double)vehicles / elapsed, allocations, poolChunks, peakRssKb());
+    fflush(out);
+    recordResult(name, ticksPerSec, 1);
+}
+
+// Meme corridor avec le moteur mesoscopique (cellules) : comparaison directe avec benchEndToEnd
+void benchMesoEndToEnd(FILE* out, const EndToEndCase* c, int ticks) {
+    ScenarioConfig config = activeScenario;
+    config.queueCapacity = c->capacity;
+    long allocationsBefore = atomic_load(&benchAllocations);
+
+    RoadGraph g;
+    MesoNetwork meso;
+    if (!buildGridGraph(&g, 1, c->intersections, config.linkTravelTime)) return;
+    int built = buildMesoNetwork(&meso, &g, &config);
+    freeRoadGraph(&g);
+    if (!built) return;
+    double start = benchNow();
+    runMesoNetwork(&meso, 0, (unsigned long)ticks);
+    double elapsed = benchNow() - start;
+    double served, refused, present;
+    mesoTotals(&meso, &served, &refused, &present);
+    long allocations = atomic_load(&benchAllocations) - allocationsBefore;
+    freeMesoNetwork(&meso);
+
+    char name[64];
+    snprintf(name, sizeof(name), "meso_%dx%d", c->intersections, c->capacity);
+    double ticksPerSec = (double)ticks / elapsed;
+    fprintf(out, "{\"suite\":\"e2e\",\"name\":\"%s\",\"intersections\":%d,\"capacity\":%d,\"ticks\":%d,"
+                 "\"threads\":1,\"seconds\":%.6f,\"ticks_per_sec\":%.1f,\"intersection_ticks_per_sec\":%.1f,"
+                 "\"vehicles_per_sec\":%.1f,\"allocations\":%ld,\"pool_chunks\":0,\"peak_rss_kb\":%ld}\n",
+            name, c->intersections, c->capacity, ticks, elapsed, ticksPerSec,
+            ticksPerSec * c->intersections, served / elapsed, allocations, peakRssKb());
+    fflush(out);
+    recordResult(name, ticksPerSec, 1);
+}
+
+// Compare les resultats a un fichier de reference ; retourne le nombre de regressions
+int compareWithBaseline(const char* path, double tolerance) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Reference introuvable : %s\n", path);
+        return 1;
+    }
+    char line[1024];
+    int regressions = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char name[64];
+        char* field = strstr(line, "\"name\":\"");
+        if (field == NULL || sscanf(field + 8, "%63[^\"]", name) != 1) continue;
+        for (int i = 0; i < benchResultCount; i++) {
+            BenchResult* r = &benchResults[i];
+            if (strcmp(r->name, name) != 0) continue;
+            const char* key = r->higherIsBetter ? "\"ticks_per_sec\":" : "\"ns_per_op\":";
+            char* value = strstr(line, key);
+            if (value == NULL) break;
+            double reference = strtod(value + strlen(key), NULL);
+            double change = (reference > 0.0) ? (r->value - reference) / reference : 0.0;
+            if (r->higherIsBetter) change = -change;
+            int regressed = 100.0 * change > tolerance;
+            fprintf(stderr, "%-28s reference %12.3f  actuel %12.3f  %+6.1f%% %s\n", name, reference,
+                    r->value, 100.0 * (r->higherIsBetter ? -change : change), regressed ? "REGRESSION" : "");
+            regressions += regressed;
+            break;
+        }
+    }
+    fclose(file);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    int quick = 0, runMicro = 1, runEndToEnd = 1, threads = 0;
+    const char* outputPath = NULL;
+    const char* baselinePath = NULL;
+    double tolerance = BENCH_REGRESSION_TOLERANCE;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) quick = 1;
+        else if (strcmp(argv[i], "--micro") == 0) runEndToEnd = 0;
+        else if (strcmp(argv[i], "--e2e") == 0) runMicro = 0;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) outputPath = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baselinePath = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) tolerance = atof(argv[++i]);
+        else {
+            fprintf(stderr, "Usage : %s [--quick] [--micro | --e2e] [--threads N] [--output fichier] [--baseline fichier] [--tolerance %%]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (threads <= 0) threads = availableCores();
+    FILE* out = stdout;
+    if (outputPath != NULL && (out = fopen(outputPath, "w")) == NULL) {
+        perror("Erreur creation fichier de resultats");
+        return EXIT_FAILURE;
+    }
+    consoleOutput = 0;
+
+    long ops = quick ? 1000000L : 20000000L;
+    if (runMicro) {
+        benchEnqueueDequeue(out, ops);
+        benchProcessQueue(out, ops / 4, 0);
+        benchProcessQueue(out, ops / 4, 1);
+        benchJamDetection(out, ops);
+        benchLaneStateKernel(out, ops * 10);
+        benchHistoryPush(out, ops / 4);
+        benchLogQueueState(out, ops / 20, 1);
+        benchLogQueueState(out, ops / 20, 0);
+        benchDemandIngest(out, ops);
+        benchRouteTable(out, quick ? BENCH_ROUTE_GRID / 2 : BENCH_ROUTE_GRID, threads);
+    }
+    if (runEndToEnd) {
+        int cases = (int)(sizeof(endToEndCases) / sizeof(endToEndCases[0]));
+        for (int i = 0; i < cases; i++) {
+            int ticks = quick ? endToEndCases[i].ticks / 10 : endToEndCases[i].ticks;
+            benchEndToEnd(out, &endToEndCases[i], ticks, threads);
+            // Moteur mesoscopique sur les reseaux de plusieurs intersections
+            if (endToEndCases[i].intersections > 1) benchMesoEndToEnd(out, &endToEndCases[i], ticks);
+        }
+    }
+    if (out != stdout) fclose(out);
+
+    if (baselinePath != NULL && compareWithBaseline(baselinePath, tolerance) > 0) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
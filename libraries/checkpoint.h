@@ -0,0 +1,475 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "network.h"
+
+/* --- Sauvegarde et reprise de l'etat complet d'une simulation --- */
+// Un fichier contient une intersection isolee (avec l'historique en memoire) ou un reseau entier
+// (avec les vehicules en transit sur les liaisons) : vehicules de chaque file, anneau des phases,
+// evenements planifies, cle aleatoire, metriques et compteurs. La reprise continue exactement
+// la simulation interrompue ; changer de graine ou de controleur a la reprise en fait une variante
+// (les structures, capacite des files et taille du reseau, doivent etre celles de la sauvegarde).
+// Les structures sont ecrites telles quelles : le fichier se relit avec le meme programme.
+
+#define CHECKPOINT_MAGIC 0x4B435254u // "TRCK"
+#define CHECKPOINT_VERSION 7 // 2 : preemption des urgences, 3 : credit de passage, 4 : historique borne,
+                             // 5 : destination des vehicules et approche des liaisons,
+                             // 6 : parametres de l'optimiseur de feux dans le scenario,
+                             // 7 : memoire de l'historique (HISTORY_MEMORY_LIMIT) dans le scenario
+#define CHECKPOINT_MAX_PHASES 8
+#define CHECKPOINT_BUFFER_SIZE (1 << 20)
+
+// Contenu du fichier
+typedef enum {
+    CHECKPOINT_INTERSECTION, // Intersection isolee et historique en memoire
+    CHECKPOINT_NETWORK       // Reseau d'intersections et liaisons
+} CheckpointKind;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int kind;          // CheckpointKind
+    unsigned int count;         // Intersections sauvegardees
+    unsigned long long clock;   // Dernier pas simule
+    ScenarioConfig config;      // Scenario de la simulation sauvegardee
+} CheckpointHeader;
+
+// Compteurs et etat scalaire d'une intersection
+typedef struct {
+    int id;
+    int nextVehicleId;
+    int vehicleIdStride;
+    int spillback;
+    int lightEpoch[4];
+    int dischargePending[4];
+    int dischargeCredit[4];
+    unsigned int rngKey[2];
+    unsigned long long clock;
+    unsigned long long phaseStartTime;
+    unsigned long long phaseEndTime;
+    unsigned long long preemptRemaining;
+    unsigned long long lastArrival[4];
+    unsigned long long blockedDischarges;
+    unsigned long long receivedVehicles;
+    unsigned long long exitedVehicles;
+    unsigned long long arrivedVehicles;
+    unsigned long long rejectedArrivals;
+    unsigned long long nextEventSeq;
+    int phaseCount;             // Phases de l'anneau, a partir de phases.front
+    int currentPhase;           // Rang de la phase au vert dans l'anneau
+    int preemptedPhase;         // Rang de la phase interrompue par une preemption (-1 : aucune)
+    int preemptLane;
+    int phaseEpoch;
+    int eventCount;             // Evenements planifies (SimEvent) qui suivent
+} CheckpointIntersection;
+
+// Etat d'une file (suivi de ses "size" vehicules, de la tete a la queue)
+typedef struct {
+    int size;
+    int lightState;
+    int currentGreenDuration;
+    int currentRedDuration;
+} CheckpointQueue;
+
+typedef struct {
+    int phase;
+    int greenDuration;
+    int redDuration;
+} CheckpointPhase;
+
+// Fichier de sauvegarde ouvert ; "failed" retient la premiere erreur d'ecriture ou de lecture
+typedef struct {
+    FILE* file;
+    int failed;
+} CheckpointFile;
+
+void checkpointPut(CheckpointFile* f, const void* data, size_t size) {
+    if (!f->failed && size > 0 && fwrite(data, size, 1, f->file) != 1) f->failed = 1;
+}
+
+void checkpointGet(CheckpointFile* f, void* data, size_t size) {
+    if (!f->failed && size > 0 && fread(data, size, 1, f->file) != 1) f->failed = 1;
+}
+
+// Ouvre un fichier de sauvegarde avec un tampon large (ecriture et relecture en quelques appels)
+int openCheckpointFile(CheckpointFile* f, const char* path, const char* mode) {
+    f->failed = 0;
+    f->file = fopen(path, mode);
+    if (f->file == NULL) return 0;
+    setvbuf(f->file, NULL, _IOFBF, CHECKPOINT_BUFFER_SIZE);
+    return 1;
+}
+
+// Ferme le fichier ; retourne 1 si toutes les operations ont reussi
+int closeCheckpointFile(CheckpointFile* f) {
+    if (fclose(f->file) != 0) f->failed = 1;
+    return !f->failed;
+}
+
+void putCheckpointQueue(CheckpointFile* f, Queue* q) {
+    CheckpointQueue cq = {q->size, q->lightState, q->currentGreenDuration, q->currentRedDuration};
+    checkpointPut(f, &cq, sizeof(cq));
+    for (int i = 0; i < q->size; i++) {
+        checkpointPut(f, queueAt(q, i), sizeof(Vehicule));
+    }
+}
+
+// Ecrit l'etat d'une intersection entre deux pas de temps
+void putCheckpointIntersection(CheckpointFile* f, Intersection* x) {
+    CheckpointIntersection s;
+    memset(&s, 0, sizeof(s));
+    s.id = x->id;
+    s.nextVehicleId = x->nextVehicleId;
+    s.vehicleIdStride = x->vehicleIdStride;
+    s.spillback = x->spillback;
+    s.rngKey[0] = x->rng.key[0];
+    s.rngKey[1] = x->rng.key[1];
+    s.clock = x->clock;
+    s.phaseStartTime = x->phaseStartTime;
+    s.phaseEndTime = x->phaseEndTime;
+    s.preemptRemaining = x->preemptRemaining;
+    s.preemptLane = x->preemptLane;
+    s.phaseEpoch = x->phaseEpoch;
+    s.preemptedPhase = -1;
+    for (int i = 0; i < 4; i++) {
+        s.lightEpoch[i] = x->lightEpoch[i];
+        s.dischargePending[i] = x->dischargePending[i];
+        s.dischargeCredit[i] = x->dischargeCredit[i];
+        s.lastArrival[i] = x->lastArrival[i];
+    }
+    s.blockedDischarges = x->blockedDischarges;
+    s.receivedVehicles = x->receivedVehicles;
+    s.exitedVehicles = x->exitedVehicles;
+    s.arrivedVehicles = x->arrivedVehicles;
+    s.rejectedArrivals = x->rejectedArrivals;
+    s.nextEventSeq = x->events.nextSeq;
+    s.eventCount = x->events.size;
+
+    CheckpointPhase phases[CHECKPOINT_MAX_PHASES];
+    TrafficPhaseNode* node = x->phases.front;
+    do {
+        if (node == x->currentPhase) s.currentPhase = s.phaseCount;
+        if (node == x->preemptedPhase) s.preemptedPhase = s.phaseCount;
+        phases[s.phaseCount].phase = node->phase;
+        phases[s.phaseCount].greenDuration = node->greenDuration;
+        phases[s.phaseCount].redDuration = node->redDuration;
+        s.phaseCount++;
+        node = node->next;
+    } while (node != x->phases.front && s.phaseCount < CHECKPOINT_MAX_PHASES);
+
+    checkpointPut(f, &s, sizeof(s));
+    checkpointPut(f, phases, sizeof(CheckpointPhase) * s.phaseCount);
+    checkpointPut(f, x->events.heap, sizeof(SimEvent) * x->events.size); // l'ordre du tas est conserve
+    for (int d = 0; d < x->numLanes; d++) {
+        putCheckpointQueue(f, x->lanes[d].aller);
+        putCheckpointQueue(f, x->lanes[d].retour);
+    }
+    checkpointPut(f, &x->metrics, sizeof(x->metrics));
+}
+
+// Relit une file ; ses vehicules sont recrees dans le pool de la file
+void getCheckpointQueue(CheckpointFile* f, Queue* q) {
+    CheckpointQueue cq;
+    checkpointGet(f, &cq, sizeof(cq));
+    if (f->failed || cq.size < 0 || cq.size > q->Maxcapacity) {
+        f->failed = 1;
+        return;
+    }
+    for (int i = 0; i < cq.size && !f->failed; i++) {
+        Vehicule saved;
+        checkpointGet(f, &saved, sizeof(saved));
+        Vehicule* v = createVehicule(q->pool, saved.id, (VehiculeType)saved.type, saved.arrivalTime,
+                                     (Direction)saved.origin, (TurnDirection)saved.turn);
+        if (v == NULL) {
+            f->failed = 1;
+            return;
+        }
+        v->queueTime = saved.queueTime;
+        v->destination = saved.destination;
+        q->slots[q->size++] = v; // la file est vide : la tete est a la case 0
+    }
+    *q->sizeMirror = q->size;
+    q->lightState = (TrafficLightState)cq.lightState;
+    q->currentGreenDuration = cq.currentGreenDuration;
+    q->currentRedDuration = cq.currentRedDuration;
+    q->version++;
+}
+
+// Remplace l'etat d'une intersection fraichement initialisee (initIntersection) par l'etat sauvegarde
+void getCheckpointIntersection(CheckpointFile* f, Intersection* x, const CheckpointHeader* header) {
+    CheckpointIntersection s;
+    CheckpointPhase phases[CHECKPOINT_MAX_PHASES];
+    checkpointGet(f, &s, sizeof(s));
+    if (f->failed || s.phaseCount <= 0 || s.phaseCount > CHECKPOINT_MAX_PHASES ||
+        s.currentPhase < 0 || s.currentPhase >= s.phaseCount || s.eventCount < 0 ||
+        s.preemptedPhase >= s.phaseCount || s.preemptLane >= 4) {
+        f->failed = 1;
+        return;
+    }
+    checkpointGet(f, phases, sizeof(CheckpointPhase) * s.phaseCount);
+
+    // Anneau : meme suite de phases, tourne jusqu'a la phase de tete sauvegardee
+    int ringSize = 0;
+    TrafficPhaseNode* node = x->phases.front;
+    do {
+        ringSize++;
+        node = node->next;
+    } while (node != x->phases.front);
+    if (f->failed || ringSize != s.phaseCount) {
+        f->failed = 1;
+        return;
+    }
+    for (int r = 0; r < ringSize && x->phases.front->phase != (TrafficLightPhase)phases[0].phase; r++) {
+        dequeuePhase(&x->phases);
+    }
+    node = x->phases.front;
+    for (int p = 0; p < s.phaseCount; p++, node = node->next) {
+        if (node->phase != (TrafficLightPhase)phases[p].phase) f->failed = 1;
+        node->greenDuration = phases[p].greenDuration;
+        node->redDuration = phases[p].redDuration;
+        if (p == s.currentPhase) x->currentPhase = node;
+        if (p == s.preemptedPhase) x->preemptedPhase = node;
+    }
+
+    // Evenements : le tas est recopie tel quel (les evenements de l'initialisation sont retires)
+    if (s.eventCount > x->events.capacity) {
+        SimEvent* heap = (SimEvent*)realloc(x->events.heap, sizeof(SimEvent) * s.eventCount);
+        if (heap == NULL) {
+            f->failed = 1;
+            return;
+        }
+        x->events.heap = heap;
+        x->events.capacity = s.eventCount;
+    }
+    checkpointGet(f, x->events.heap, sizeof(SimEvent) * s.eventCount);
+    x->events.size = f->failed ? 0 : s.eventCount;
+    x->events.nextSeq = (unsigned long)s.nextEventSeq;
+
+    for (int d = 0; d < x->numLanes; d++) {
+        getCheckpointQueue(f, x->lanes[d].aller);
+        getCheckpointQueue(f, x->lanes[d].retour);
+    }
+    checkpointGet(f, &x->metrics, sizeof(x->metrics));
+
+    x->id = s.id;
+    x->nextVehicleId = s.nextVehicleId;
+    x->vehicleIdStride = s.vehicleIdStride;
+    x->spillback = s.spillback;
+    // La cle sauvegardee n'est reprise qu'avec la meme graine : une autre graine fait une variante
+    if (x->config->seed == header->config.seed) {
+        x->rng.key[0] = s.rngKey[0];
+        x->rng.key[1] = s.rngKey[1];
+    }
+    x->clock = (unsigned long)s.clock;
+    x->phaseStartTime = (unsigned long)s.phaseStartTime;
+    x->phaseEndTime = (unsigned long)s.phaseEndTime;
+    x->preemptRemaining = (unsigned long)s.preemptRemaining;
+    x->preemptLane = s.preemptLane;
+    x->phaseEpoch = s.phaseEpoch;
+    for (int i = 0; i < 4; i++) {
+        x->lightEpoch[i] = s.lightEpoch[i];
+        x->dischargePending[i] = s.dischargePending[i];
+        x->dischargeCredit[i] = s.dischargeCredit[i];
+        x->lastArrival[i] = (unsigned long)s.lastArrival[i];
+    }
+    x->blockedDischarges = (unsigned long)s.blockedDischarges;
+    x->receivedVehicles = (unsigned long)s.receivedVehicles;
+    x->exitedVehicles = (unsigned long)s.exitedVehicles;
+    x->arrivedVehicles = (unsigned long)s.arrivedVehicles;
+    x->rejectedArrivals = (unsigned long)s.rejectedArrivals;
+    // Etat des voies : tailles et feux recopies, embouteillages et durees recalcules
+    bindLaneState(x, x->laneState, x->laneSlot);
+}
+
+// Ecrit l'historique en memoire : enregistrements recents puis cumuls, du plus ancien au plus recent
+void putCheckpointHistory(CheckpointFile* f, TrafficHistoryStack* history) {
+    HistoryRetention empty;
+    memset(&empty, 0, sizeof(empty));
+    clearHistoryBucket(&empty.older);
+    const HistoryRetention* r = (history != NULL) ? &history->recent : &empty;
+    checkpointPut(f, &r->total, sizeof(r->total));
+    checkpointPut(f, &r->older, sizeof(r->older));
+    for (int l = HISTORY_ROLLUP_LEVELS - 1; l >= 0; l--) {
+        const BucketRing* ring = &r->levels[l];
+        checkpointPut(f, &ring->size, sizeof(ring->size));
+        for (int i = 0; i < ring->size; i++) checkpointPut(f, bucketAt(ring, i), sizeof(HistoryBucket));
+    }
+    checkpointPut(f, &r->rawSize, sizeof(r->rawSize));
+    for (int i = 0; i < r->rawSize; i++) checkpointPut(f, retainedRecordAt(r, i), sizeof(HistoryRecord));
+}
+
+// Remplace l'historique en memoire par celui de la sauvegarde (l'historique persistant n'est pas touche)
+// Les elements sont remis du plus ancien au plus recent : si la memoire fixee est plus petite qu'a la
+// sauvegarde, les plus anciens descendent dans les cumuls comme pendant la simulation
+void getCheckpointHistory(CheckpointFile* f, TrafficHistoryStack* history) {
+    HistoryRetention* r = (history != NULL) ? &history->recent : NULL;
+    unsigned long long total = 0;
+    HistoryBucket bucket;
+    checkpointGet(f, &total, sizeof(total));
+    checkpointGet(f, &bucket, sizeof(bucket));
+    if (r != NULL) {
+        resetHistoryRetention(r);
+        r->older = bucket;
+    }
+    for (int l = HISTORY_ROLLUP_LEVELS - 1; l >= 0 && !f->failed; l--) {
+        int count = 0;
+        checkpointGet(f, &count, sizeof(count));
+        if (count < 0) f->failed = 1;
+        for (int i = 0; i < count && !f->failed; i++) {
+            checkpointGet(f, &bucket, sizeof(bucket));
+            if (r != NULL && !f->failed) rollHistoryBucket(r, l, &bucket);
+        }
+    }
+    int count = 0;
+    checkpointGet(f, &count, sizeof(count));
+    if (count < 0) f->failed = 1;
+    for (int i = 0; i < count && !f->failed; i++) {
+        HistoryRecord record;
+        checkpointGet(f, &record, sizeof(record));
+        if (r != NULL && !f->failed) retainHistoryRecord(r, &record);
+    }
+    if (r != NULL) r->total = total;
+}
+
+void fillCheckpointHeader(CheckpointHeader* h, CheckpointKind kind, int count, unsigned long clock,
+                          const ScenarioConfig* config) {
+    memset(h, 0, sizeof(*h));
+    h->magic = CHECKPOINT_MAGIC;
+    h->version = CHECKPOINT_VERSION;
+    h->kind = kind;
+    h->count = (unsigned int)count;
+    h->clock = clock;
+    h->config = *config;
+}
+
+// Lit l'en-tete d'une sauvegarde ; retourne 0 si le fichier est absent ou n'est pas une sauvegarde
+int readCheckpointHeader(CheckpointFile* f, const char* path, CheckpointHeader* h) {
+    if (!openCheckpointFile(f, path, "rb")) return 0;
+    checkpointGet(f, h, sizeof(*h));
+    if (f->failed || h->magic != CHECKPOINT_MAGIC || h->version != CHECKPOINT_VERSION) {
+        fclose(f->file);
+        return 0;
+    }
+    return 1;
+}
+
+// Verifie que le scenario de reprise a les memes structures que la sauvegarde
+int checkpointCompatible(const CheckpointHeader* h, const ScenarioConfig* config) {
+    return h->config.queueCapacity == config->queueCapacity;
+}
+
+/* --- Intersection isolee --- */
+
+// Sauvegarde une intersection (entre deux pas de temps) et l'historique en memoire (NULL : aucun)
+int saveIntersectionCheckpoint(const char* path, Intersection* x, TrafficHistoryStack* history) {
+    CheckpointFile f;
+    if (!openCheckpointFile(&f, path, "wb")) return 0;
+    CheckpointHeader header;
+    fillCheckpointHeader(&header, CHECKPOINT_INTERSECTION, 1, x->clock, x->config);
+    checkpointPut(&f, &header, sizeof(header));
+    putCheckpointIntersection(&f, x);
+    putCheckpointHistory(&f, history);
+    return closeCheckpointFile(&f);
+}
+
+// Recree l'intersection sauvegardee avec le scenario "config" ; l'historique en memoire est remplace
+// Retourne 0 si le fichier est illisible ou incompatible (l'intersection n'est alors pas creee)
+int loadIntersectionCheckpoint(const char* path, Intersection* x, const ScenarioConfig* config,
+                               MemoryPool* pool, TrafficLog* trafficLog, TrafficHistoryStack* history) {
+    CheckpointFile f;
+    CheckpointHeader header;
+    if (!readCheckpointHeader(&f, path, &header)) return 0;
+    if (header.kind != CHECKPOINT_INTERSECTION || header.count != 1 || !checkpointCompatible(&header, config)) {
+        fclose(f.file);
+        return 0;
+    }
+    initIntersection(x, 1, config, config->seed, pool, trafficLog, history);
+    getCheckpointIntersection(&f, x, &header);
+    getCheckpointHistory(&f, history);
+    if (!closeCheckpointFile(&f)) {
+        freeIntersection(x);
+        return 0;
+    }
+    return 1;
+}
+
+/* --- Reseau --- */
+
+// Sauvegarde un reseau entre deux pas : intersections, liaisons et vehicules en transit
+int saveNetworkCheckpoint(const char* path, RoadNetwork* net) {
+    CheckpointFile f;
+    if (!openCheckpointFile(&f, path, "wb")) return 0;
+    CheckpointHeader header;
+    fillCheckpointHeader(&header, CHECKPOINT_NETWORK, net->count, net->clock, net->nodes[0].config);
+    checkpointPut(&f, &header, sizeof(header));
+    for (int i = 0; i < net->count; i++) {
+        putCheckpointIntersection(&f, &net->nodes[i]);
+    }
+    for (int i = 0; i < net->count; i++) {
+        for (int d = 0; d < 4; d++) {
+            RoadLink* link = &net->exits[i][d];
+            int inTransit = (link->handoff.slots != NULL) ? (int)spscSize(&link->handoff) : 0;
+            int fields[4] = {link->target, link->travelTime, inTransit, link->approach};
+            checkpointPut(&f, fields, sizeof(fields));
+            unsigned int head = atomic_load(&link->handoff.head);
+            for (int k = 0; k < inTransit; k++) {
+                checkpointPut(&f, link->handoff.slots[(head + k) & link->handoff.mask], sizeof(Vehicule));
+            }
+        }
+    }
+    return closeCheckpointFile(&f);
+}
+
+// Recree le reseau sauvegarde (meme taille et memes liaisons) avec le scenario "config"
+// Retourne 0 si le fichier est illisible ou incompatible (le reseau n'est alors pas cree)
+int loadNetworkCheckpoint(const char* path, RoadNetwork* net, const ScenarioConfig* config) {
+    CheckpointFile f;
+    CheckpointHeader header;
+    if (!readCheckpointHeader(&f, path, &header)) return 0;
+    if (header.kind != CHECKPOINT_NETWORK || header.count == 0 || !checkpointCompatible(&header, config)) {
+        fclose(f.file);
+        return 0;
+    }
+    createRoadNetwork(net, (int)header.count, config, config->seed);
+    net->clock = (unsigned long)header.clock;
+    for (int i = 0; i < net->count && !f.failed; i++) {
+        getCheckpointIntersection(&f, &net->nodes[i], &header);
+    }
+    for (int i = 0; i < net->count && !f.failed; i++) {
+        for (int d = 0; d < 4 && !f.failed; d++) {
+            int fields[4];
+            checkpointGet(&f, fields, sizeof(fields));
+            if (f.failed || fields[0] >= net->count || fields[2] < 0 || fields[2] > HANDOFF_CAPACITY
+                || fields[3] < 0 || fields[3] > 3) {
+                f.failed = 1;
+                break;
+            }
+            if (fields[0] >= 0) connectRoad(net, i, (Direction)d, fields[0], (Direction)fields[3], fields[1]);
+            net->exits[i][d].travelTime = fields[1];
+            for (int k = 0; k < fields[2] && !f.failed; k++) {
+                Vehicule saved;
+                checkpointGet(&f, &saved, sizeof(saved));
+                Vehicule* v = createVehicule(&net->pools[i], saved.id, (VehiculeType)saved.type,
+                                             saved.arrivalTime, (Direction)saved.origin, (TurnDirection)saved.turn);
+                if (v == NULL || net->exits[i][d].handoff.slots == NULL) {
+                    releaseVehicule(&net->pools[i], v);
+                    f.failed = 1;
+                    break;
+                }
+                v->queueTime = saved.queueTime;
+                v->destination = saved.destination;
+                spscPush(&net->exits[i][d].handoff, v);
+            }
+        }
+    }
+    if (!closeCheckpointFile(&f)) {
+        freeRoadNetwork(net);
+        return 0;
+    }
+    return 1;
+}
+
+#endif // CHECKPOINT_H
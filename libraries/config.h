@@ -1,7 +1,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#define SIMULATION_DURATION 6  // Simulation duration in seconds 
+#define SIMULATION_DURATION 6  // Simulation duration in seconds (virtual clock)
+#define SIMULATION_SEED 12345      // Seed used for reproducible runs
 #define QUEUE_CAPACITY 4           // Maximum capacity of each queue
 #define EMERGENCY_CHANCE 20        // 20% chance for an emergency vehicle
 #define VEHICLE_GEN_PROB 80     // 80% chance to generate a vehicle when light is red
@@ -10,7 +11,71 @@
 #define GREEN_BOOST 1            // Extra green time during traffic jam
 #define RED_REDUCTION 1           // Reduced red time during traffic jam
 #define TRAFFIC_JAM_THRESHOLD 0.75 // 75% of capacity considered as a traffic jam
+#define SIGNAL_CONTROLLER 0        // Signal policy: 0 fixed alternation, 1 actuated, 2 max-pressure
+#define ACTUATED_GAP 2             // Actuated: green ends once no vehicle waits or arrived for this many seconds
+#define ACTUATED_MAX_GREEN 8       // Actuated: longest green before the phase is forced to change
+#define EMERGENCY_PREEMPTION 1     // Emergency vehicles get an immediate green on their approach (0: wait for the cycle)
 #define TIME_INCREMENT 1           // Time increment for simulation (1 second)
 #define DURATION_FOR_VEHICULE_PASSATION 1  //durée que prend un véhicule pour passer au feu vert 
+#define HEADWAY_CAR 10             // Saturation flow headway of a car (tenths of a second)
+#define HEADWAY_BUS 20             // Saturation flow headway of a bus (tenths of a second)
+#define HEADWAY_BIKE 5             // Saturation flow headway of a motorbike (tenths of a second)
+#define HEADWAY_EMERGENCY 10       // Saturation flow headway of an emergency vehicle (tenths of a second)
+#define DISCHARGE_BATCH_MAX 64     // Most vehicles moved by one discharge stage
+#define NETWORK_SIZE 12            // Number of intersections in the corridor
+#define LINK_TRAVEL_TIME 5         // Travel time between two neighbouring intersections (seconds)
+#define GRID_ROWS 10               // Rows of the generated city grid (grid mode)
+#define GRID_COLS 10               // Columns of the generated city grid (grid mode)
+#define OD_ZONE_SIZE 5             // Side of an origin-destination zone (intersections)
+#define OD_DISTANCE_DECAY 8.0      // Gravity model: trips decay as exp(-distance / decay) (0: uniform demand)
+#define OD_MAX_ZONES 1024          // Largest origin-destination matrix side (zones grow to stay below)
+#define NETWORK_DURATION 3600      // Corridor simulation duration (virtual seconds)
+#define NETWORK_REPORT_INTERVAL 600 // Corridor status printed every N virtual seconds
+#define NETWORK_THREADS 4          // Worker threads used to step the corridor
+#define HANDOFF_CAPACITY 4         // Vehicles waiting at the end of a link before entering the next intersection
+#define VEHICLE_POOL_CHUNK 256     // Vehicles allocated per pool chunk
+#define HISTORY_MEMORY_LIMIT (1 << 20) // Default bytes kept by the in-memory history (recent records + rollups)
+#define HISTORY_MINUTE_BUCKETS 1440 // Per-minute rollups kept before they are merged into hours (one day)
+#define HISTORY_HOUR_BUCKETS 168   // Per-hour rollups kept before they are merged into one total (one week)
+#define HISTORY_MIN_RAW_RECORDS 64 // Recent records kept even when the memory limit is smaller
+#define HISTORY_STORE_PATH "traffic_history" // Persistent history files (.rec records, .idx indexes)
+#define HISTORY_QUERY_MAX_SHOWN 20 // Records printed by a history search
+#define TRAFFIC_LOG_PATH "traffic_simulation.bin" // Binary event log (decode with tools/logdecode)
+#define TRAFFIC_LOG_CAPACITY 65536 // Records buffered in memory before the writer thread flushes them
+#define LOG_KEYFRAME_INTERVAL 60   // Ticks between two full queue dumps in the log (deltas in between)
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0            // Tick stage tracing compiled in (build with -DTRACE_ENABLED=1)
+#endif
+#define TRACE_PATH "traffic_trace.json" // Chrome / Perfetto trace of the last traced run
+#define TRACE_BUFFER_CHUNK 4096    // Initial trace spans per thread (the buffer doubles when full)
+#define TRACE_BUFFER_MAX_EVENTS (1 << 22) // Trace spans kept per thread (later spans are dropped)
+#define VIEWER_FPS 10              // Frames per second drawn by the batch mode viewer (--view)
+#define VIEWER_MAX_ROWS 24         // Intersections drawn in each viewer frame
+#define METRICS_SNAPSHOT_PATH "traffic_metrics.jsonl" // Metrics snapshots (one JSON line per lane)
+#define CHECKPOINT_PATH "traffic_checkpoint.bin" // Final state of the last intersection run (resume with menu 9)
+#define CORRIDOR_CHECKPOINT_PATH "traffic_corridor_checkpoint.bin" // Final state of the last corridor run
+#define DEMAND_PATH "scenarios/demand.csv" // Recorded arrivals replayed by default (CSV or tools/demandpack binary)
+#define DEMAND_CSV_CHUNK (1 << 20) // Bytes read at once from a CSV demand file
+#define DEMAND_MAP_WINDOW (64u << 20) // Bytes of a binary demand file mapped at once (multiple of 64 KiB)
+#define MONTE_CARLO_REPLICATIONS 400 // Independent replications run by the Monte Carlo mode
+#define MONTE_CARLO_DURATION 3600  // Virtual duration of each replication (seconds)
+#define MONTE_CARLO_THREADS 0      // Worker threads for the replications (0: all available cores)
+#define OPTIMIZER_ROUNDS 20        // Signal optimizer: search rounds (each one scores a set of plan variants)
+#define OPTIMIZER_CANDIDATES 16    // Timing plan variants evaluated concurrently in each round
+#define OPTIMIZER_WARMUP 300       // Virtual seconds simulated once before the evaluations (warmed-up state)
+#define OPTIMIZER_HORIZON 900      // Virtual seconds simulated to score a timing plan
+#define OPTIMIZER_MAX_CYCLE 60     // Longest signal cycle considered (seconds)
+#define OPTIMIZER_THREADS 0        // Worker threads for the evaluations (0: all available cores)
+#define OPTIMIZER_SEGMENTS 4       // Points of an evaluation where a clearly worse plan is dropped
+#define OPTIMIZER_PRUNE_MARGIN 0.10 // A plan is dropped once its delay exceeds the best plan's by this share
+#define OPTIMIZER_MIN_GREEN 1      // Shortest green given to a phase by a timing plan (seconds)
+#define OPTIMIZER_REFUSED_PENALTY 60.0 // Delay charged per vehicle refused at entry or lost at the light (seconds)
+#define OPTIMIZER_WARM_PATH "traffic_optimizer_warm.bin" // Warmed-up corridor shared by the evaluations
+#define OPTIMIZER_PLAN_PATH "signal_plan.csv" // Best timing plan found by the optimizer
+#define SCENARIO_PATH "scenarios/default.cfg" // Scenario loaded at startup (overrides the values above)
+#define SWEEP_PATH "scenarios/sweep.cfg"      // Default parameter sweep file
+#define SWEEP_RESULTS_PATH "sweep_results.csv" // Full sweep results table
+#define SWEEP_MAX_POINTS 100000    // Largest Cartesian product accepted by a sweep
+#define SWEEP_MAX_SHOWN 40         // Sweep rows printed on the console
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -0,0 +1,268 @@
+#ifndef DEMAND_H
+#define DEMAND_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "mmapfile.h"
+
+/* --- Demande enregistree : relecture en flux d'arrivees de vehicules --- */
+// Deux formats, lus sans jamais charger le fichier entier :
+//   CSV     : "instant,origine,type,virage[,intersection]" par ligne, lu par blocs de DEMAND_CSV_CHUNK
+//             octets (valeurs numeriques ou noms : NORD/SUD/EST/OUEST, CAR/BUS/BIKE/EMERGENCY,
+//             LEFT/RIGHT/STRAIGHT ; lignes vides, commentaires # et en-tete ignores)
+//   binaire : en-tete DemandFileHeader puis enregistrements DemandRecord de 8 octets, projetes
+//             par fenetres de DEMAND_MAP_WINDOW octets (tools/demandpack convertit un CSV)
+// Les enregistrements doivent etre tries par instant ; un enregistrement en retard est injecte
+// au pas courant.
+
+#define DEMAND_MAGIC 0x4D445254u // "TRDM"
+#define DEMAND_VERSION 1
+
+// Arrivee enregistree (meme representation dans le fichier binaire)
+typedef struct {
+    unsigned int time;           // Instant d'arrivee (secondes simulees)
+    unsigned short intersection; // Intersection visee (0 : la premiere)
+    unsigned char origin;        // Voie d'arrivee (Direction)
+    unsigned char typeTurn;      // Type de vehicule (4 bits faibles) et virage (4 bits forts)
+} DemandRecord;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int recordSize;
+    unsigned int reserved;
+} DemandFileHeader;
+
+// Flux d'enregistrements d'un fichier de demande
+typedef struct {
+    int binary;
+    MappedFile map;                  // Binaire : fenetre projetee courante
+    unsigned long long fileSize;
+    unsigned long long windowOffset; // Debut de la fenetre dans le fichier
+    unsigned long long position;     // Prochain enregistrement (octets depuis le debut du fichier)
+    FILE* csv;                       // CSV : fichier lu par blocs
+    char* buffer;
+    size_t length;                   // Octets valides dans buffer
+    size_t cursor;                   // Debut de la prochaine ligne
+    int eof;
+    long line;
+    DemandRecord next;               // Prochain enregistrement, lu d'avance
+    int hasNext;
+    unsigned long long records;      // Enregistrements lus
+    unsigned long long invalid;      // Lignes ou enregistrements invalides (ignores)
+    unsigned long long skipped;      // Enregistrements visant une intersection absente
+} DemandStream;
+
+// Arrivees d'un pas a injecter dans une intersection
+typedef struct {
+    DemandRecord* records;
+    int count;
+    int capacity;
+} DemandBatch;
+
+int demandType(const DemandRecord* r) { return r->typeTurn & 0x0F; }
+int demandTurn(const DemandRecord* r) { return r->typeTurn >> 4; }
+
+// Decoupe le champ CSV commencant a "*cursor" (le curseur passe apres le separateur)
+size_t nextDemandField(char** cursor, char** text) {
+    char* end = *text = *cursor;
+    while (*end != '\0' && *end != ',' && *end != ';' && *end != '\r') end++;
+    *cursor = (*end == ',' || *end == ';') ? end + 1 : end;
+    return (size_t)(end - *text);
+}
+
+// Valeur numerique d'un champ dans [0, limit) ; -1 sinon
+long parseDemandNumber(const char* text, size_t length, long limit) {
+    long v = 0;
+    if (length == 0) return -1;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] < '0' || text[i] > '9' || v >= limit) return -1;
+        v = v * 10 + (text[i] - '0');
+    }
+    return (v < limit) ? v : -1;
+}
+
+// Champ CSV suivant : nombre dans [0, count) ou l'un des noms (deux orthographes par valeur)
+int parseDemandField(char** cursor, const char* const* names, int count) {
+    char* text;
+    size_t length = nextDemandField(cursor, &text);
+    if (length > 0 && *text >= '0' && *text <= '9') return (int)parseDemandNumber(text, length, count);
+    for (int i = 0; i < 2 * count; i++) {
+        if (names[i][0] == text[0] && strncmp(text, names[i], length) == 0 && names[i][length] == '\0')
+            return i % count;
+    }
+    return -1;
+}
+
+// Decode une ligne CSV ; retourne 1 (enregistrement), 0 (ligne ignoree) ou -1 (ligne invalide)
+int parseDemandLine(char* line, DemandRecord* r) {
+    static const char* const origins[] = {"NORD", "SUD", "EST", "OUEST", "NORTH", "SOUTH", "EAST", "WEST"};
+    static const char* const types[] = {"CAR", "BUS", "BIKE", "EMERGENCY", "VOITURE", "BUS", "MOTO", "URGENCE"};
+    static const char* const turns[] = {"LEFT", "RIGHT", "STRAIGHT", "GAUCHE", "DROITE", "TOUT_DROIT"};
+    while (*line == ' ' || *line == '\t') line++;
+    if (*line == '\0' || *line == '#' || *line == '\r') return 0;
+    if (*line < '0' || *line > '9') return 0; // en-tete
+
+    char* cursor = line;
+    char* text;
+    size_t length = nextDemandField(&cursor, &text);
+    long time = parseDemandNumber(text, length, 0x7FFFFFFFL);
+    int origin = parseDemandField(&cursor, origins, 4);
+    int type = parseDemandField(&cursor, types, 4);
+    int turn = parseDemandField(&cursor, turns, 3);
+    // Intersection facultative (0 par defaut)
+    length = nextDemandField(&cursor, &text);
+    long intersection = (length == 0) ? 0 : parseDemandNumber(text, length, 0x10000);
+    if (time < 0 || origin < 0 || type < 0 || turn < 0 || intersection < 0) return -1;
+    r->time = (unsigned int)time;
+    r->intersection = (unsigned short)intersection;
+    r->origin = (unsigned char)origin;
+    r->typeTurn = (unsigned char)(type | (turn << 4));
+    return 1;
+}
+
+// Ligne CSV suivante (terminee par '\0' dans le tampon) ; NULL en fin de fichier
+char* nextDemandLine(DemandStream* s) {
+    while (1) {
+        char* start = s->buffer + s->cursor;
+        char* newline = memchr(start, '\n', s->length - s->cursor);
+        if (newline != NULL) {
+            *newline = '\0';
+            s->cursor = (size_t)(newline - s->buffer) + 1;
+            s->line++;
+            return start;
+        }
+        if (s->eof) {
+            if (s->cursor == s->length) return NULL;
+            s->buffer[s->length] = '\0'; // derniere ligne sans retour a la ligne
+            s->cursor = s->length;
+            s->line++;
+            return start;
+        }
+        // Ligne incomplete : elle est ramenee au debut du tampon, puis le bloc suivant est lu
+        size_t rest = s->length - s->cursor;
+        if (rest == DEMAND_CSV_CHUNK) {
+            s->cursor = s->length = 0; // ligne demesuree : ignoree
+            s->invalid++;
+            rest = 0;
+        }
+        memmove(s->buffer, start, rest);
+        s->cursor = 0;
+        s->length = rest + fread(s->buffer + rest, 1, DEMAND_CSV_CHUNK - rest, s->csv);
+        if (s->length < DEMAND_CSV_CHUNK) s->eof = 1;
+    }
+}
+
+// Enregistrement binaire suivant ; la fenetre projetee avance quand elle est epuisee
+int readBinaryDemand(DemandStream* s, DemandRecord* r) {
+    if (s->position + sizeof(DemandRecord) > s->fileSize) return 0;
+    if (s->position + sizeof(DemandRecord) > s->windowOffset + s->map.size) {
+        unmapOpenedFile(&s->map);
+        s->windowOffset = s->position / MAPPED_FILE_GRANULARITY * MAPPED_FILE_GRANULARITY;
+        unsigned long long size = s->fileSize - s->windowOffset;
+        if (size > DEMAND_MAP_WINDOW) size = DEMAND_MAP_WINDOW;
+        if (!mapOpenedFileRange(&s->map, s->windowOffset, (size_t)size)) return 0;
+    }
+    memcpy(r, (const char*)s->map.data + (s->position - s->windowOffset), sizeof(DemandRecord));
+    s->position += sizeof(DemandRecord);
+    return 1;
+}
+
+// Un enregistrement binaire n'a pas ete verifie a la lecture comme une ligne CSV
+int validDemandRecord(const DemandRecord* r) {
+    return r->origin < 4 && demandType(r) < 4 && demandTurn(r) < 3;
+}
+
+// Lit l'enregistrement suivant ; retourne 0 en fin de fichier
+int readDemandRecord(DemandStream* s, DemandRecord* r) {
+    if (s->binary) {
+        while (readBinaryDemand(s, r)) {
+            if (validDemandRecord(r)) {
+                s->records++;
+                return 1;
+            }
+            s->invalid++;
+        }
+        return 0;
+    }
+    char* line;
+    while ((line = nextDemandLine(s)) != NULL) {
+        int parsed = parseDemandLine(line, r);
+        if (parsed > 0) {
+            s->records++;
+            return 1;
+        }
+        if (parsed < 0) s->invalid++;
+    }
+    return 0;
+}
+
+// Ouvre un fichier de demande (binaire reconnu a son en-tete, CSV sinon) ; retourne 0 en cas d'echec
+int openDemandStream(DemandStream* s, const char* path) {
+    memset(s, 0, sizeof(*s));
+    long long size = openMappedFile(&s->map, path, 0);
+    if (size < 0) {
+        closeMappedFile(&s->map);
+        return 0;
+    }
+    DemandFileHeader header;
+    s->fileSize = (unsigned long long)size;
+    if (s->fileSize >= sizeof(header)) {
+        size_t first = (s->fileSize < DEMAND_MAP_WINDOW) ? (size_t)s->fileSize : DEMAND_MAP_WINDOW;
+        if (!mapOpenedFileRange(&s->map, 0, first)) {
+            closeMappedFile(&s->map);
+            return 0;
+        }
+        memcpy(&header, s->map.data, sizeof(header));
+        if (header.magic == DEMAND_MAGIC) {
+            if (header.version != DEMAND_VERSION || header.recordSize != sizeof(DemandRecord)) {
+                closeMappedFile(&s->map);
+                return 0;
+            }
+            s->binary = 1;
+            s->position = sizeof(header);
+            return 1;
+        }
+    }
+    closeMappedFile(&s->map);
+    s->csv = fopen(path, "rb");
+    s->buffer = (char*)malloc(DEMAND_CSV_CHUNK + 1);
+    if (s->csv == NULL || s->buffer == NULL) {
+        if (s->csv != NULL) fclose(s->csv);
+        free(s->buffer);
+        return 0;
+    }
+    return 1;
+}
+
+void closeDemandStream(DemandStream* s) {
+    if (s->binary) {
+        closeMappedFile(&s->map);
+    } else {
+        fclose(s->csv);
+        free(s->buffer);
+    }
+}
+
+// Ajoute un enregistrement aux arrivees d'un pas
+void pushDemandBatch(DemandBatch* b, const DemandRecord* r) {
+    if (b->count == b->capacity) {
+        b->capacity = (b->capacity == 0) ? 8 : b->capacity * 2;
+        b->records = (DemandRecord*)realloc(b->records, sizeof(DemandRecord) * b->capacity);
+    }
+    b->records[b->count++] = *r;
+}
+
+// Repartit entre les "count" intersections les enregistrements dates au plus tard a "now"
+void stageDemand(DemandStream* s, DemandBatch* batches, int count, unsigned long now) {
+    while (s->hasNext || (s->hasNext = readDemandRecord(s, &s->next))) {
+        if (s->next.time > now) return;
+        if (s->next.intersection < count) pushDemandBatch(&batches[s->next.intersection], &s->next);
+        else s->skipped++;
+        s->hasNext = 0;
+    }
+}
+
+#endif // DEMAND_H
@@ -0,0 +1,582 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "queue.h"
+#include "events.h"
+#include "trace.h"
+#include "lanestate.h"
+#include "demand.h"
+#include "oddemand.h"
+
+/* --- Moteur a evenements discrets pilote par une horloge virtuelle --- */
+
+struct Intersection;
+
+// Decision d'un controleur de feux
+typedef struct {
+    TrafficPhaseNode* phase; // Phase a mettre au vert (la phase courante : elle est prolongee)
+    int duration;            // Secondes avant la prochaine decision
+} SignalDecision;
+
+// Controleur de feux : appele a chaque fin de vert (EVENT_PHASE_SWITCH) pour choisir la suite
+typedef struct {
+    const char* name;
+    SignalDecision (*decide)(struct Intersection* x, unsigned long now);
+} SignalController;
+
+// Plan de feux a temps fixe d'une intersection (secondes) : Nord-Sud au vert pendant les "green"
+// premieres secondes du cycle, Est-Ouest ensuite ; le cycle commence "offset" secondes apres
+// chaque multiple de "cycle" (decalages successifs le long d'un corridor : onde verte)
+typedef struct {
+    int cycle;
+    int green;
+    int offset;
+} SignalTiming;
+
+// Intersection a quatre voies simulee par evenements (arrivees, changements de phase, passages)
+typedef struct Intersection {
+    int id;                         // Identifiant de l'intersection
+    lane lanes[4];                  // Voies Nord, Sud, Est, Ouest
+    lane* lanePtrs[4];              // Pointeurs vers les voies (format attendu par processQueue)
+    int numLanes;                   // Nombre de voies
+    LLCircular phases;              // Anneau des phases de feux
+    TrafficPhaseNode* currentPhase; // Phase actuellement au vert
+    unsigned long phaseStartTime;   // Debut de la phase courante (horloge virtuelle)
+    unsigned long phaseEndTime;     // Prochaine decision du controleur (EVENT_PHASE_SWITCH planifie)
+    int phaseEpoch;                 // Generation des decisions planifiees (une preemption annule la derniere)
+    int preemptLane;                // Voie aller dont l'urgence tient le vert (-1 : pas de preemption)
+    TrafficPhaseNode* preemptedPhase; // Phase interrompue par la preemption, remise au vert ensuite
+    unsigned long preemptRemaining; // Vert qu'il restait a la phase interrompue
+    const SignalController* controller; // Politique de choix des phases (SIGNAL_CONTROLLER)
+    const SignalTiming* timing;     // Plan de feux impose (NULL : controleur du scenario)
+    unsigned long lastArrival[4];   // Derniere arrivee sur chaque voie aller (detecteur de l'actionne)
+    unsigned long clock;            // Horloge virtuelle de l'intersection
+    EventQueue events;              // Evenements planifies
+    int lightEpoch[4];              // Generation du feu de chaque voie (invalide les anciens passages)
+    int dischargePending[4];        // Un passage est deja planifie pour la voie
+    int dischargeCredit[4];         // Vert accumule et pas encore paye par un vehicule (dixiemes de seconde)
+    TrafficLog* trafficLog;         // Journal binaire (NULL : desactive)
+    TrafficHistoryStack* history;   // Historique du trafic
+    MemoryPool* pool;               // Pool des vehicules (fourni par l'appelant, qui le detruit)
+    int spillback;                  // Bloque le passage si la voie de retour visee est pleine (mode reseau)
+    unsigned long blockedDischarges; // Passages bloques par une voie de retour pleine
+    SimRandom rng;                  // Cle aleatoire propre a l'intersection (tirages a compteur)
+    int nextVehicleId;              // Prochain identifiant de vehicule
+    int vehicleIdStride;            // Pas entre deux identifiants (unicite dans un reseau)
+    unsigned long receivedVehicles; // Vehicules recus des intersections voisines (mode reseau)
+    unsigned long exitedVehicles;   // Vehicules sortis du reseau par cette intersection (reseau, replications)
+    const ScenarioConfig* config;   // Parametres du scenario simule
+    IntersectionMetrics metrics;    // Attentes, longueurs de file, passages et pertes par voie
+    LaneState ownLanes;             // Etat des voies d'une intersection isolee
+    LaneState* laneState;           // Etat des voies utilise (ownLanes, ou celui du reseau)
+    int laneSlot;                   // Indice de l'intersection dans laneState
+    unsigned long laneTick;         // Dernier pas pour lequel ownLanes a ete mis a jour
+    DemandBatch* replay;            // Arrivees enregistrees a injecter (NULL : arrivees aleatoires)
+    unsigned long rejectedArrivals; // Arrivees refusees (voie aller pleine)
+    const RouteTable* routes;       // Table de routage du reseau (NULL : virages au hasard)
+    const OdDemand* od;             // Demande origine-destination (NULL : arrivees sans destination)
+    int node;                       // Indice de l'intersection dans le graphe routier
+    unsigned long arrivedVehicles;  // Vehicules arrives a destination (demande origine-destination)
+} Intersection;
+
+// Verifie si une voie (index 0..3) est au vert pour une phase donnee
+int laneIsGreen(TrafficLightPhase phase, int laneIndex) {
+    Direction dir = (Direction)laneIndex;
+    if (phase == NORTH_SOUTH_GREEN) return dir == NORTH || dir == SOUTH;
+    return dir == EAST || dir == WEST;
+}
+
+// Planifie le prochain passage d'une voie si elle est au vert et non vide
+void scheduleDischarge(Intersection* x, int laneIndex, unsigned long now) {
+    Queue* q = x->lanes[laneIndex].aller;
+    if (x->dischargePending[laneIndex] || q->lightState != GREEN || isEmpty(q)) return;
+    scheduleEvent(&x->events, now + x->config->passageDuration, EVENT_DISCHARGE,
+                  laneIndex, x->lightEpoch[laneIndex]);
+    x->dischargePending[laneIndex] = 1;
+}
+
+// Rattache les voies aller de l'intersection a la case "slot" de "s" (remplace ownLanes)
+void bindLaneState(Intersection* x, LaneState* s, int slot) {
+    for (int d = 0; d < x->numLanes; d++) {
+        Queue* q = x->lanes[d].aller;
+        int l = laneStateIndex(s, slot, d);
+        s->size[l] = q->size;
+        s->light[l] = q->lightState;
+        q->sizeMirror = &s->size[l];
+    }
+    if (x->laneState == &x->ownLanes && s != &x->ownLanes) {
+        freeLaneState(&x->ownLanes);
+    }
+    x->laneState = s;
+    x->laneSlot = slot;
+    updateLaneState(s, slot, slot + 1);
+}
+
+// Durees de base ou allongees (embouteillage) d'une phase, calculees au debut du pas
+LightDurations phaseDurations(Intersection* x, TrafficLightPhase phase) {
+    int l = laneStateIndex(x->laneState, x->laneSlot, (phase == NORTH_SOUTH_GREEN) ? NORTH : EAST);
+    LightDurations durations = {x->laneState->green[l], x->laneState->red[l]};
+    return durations;
+}
+
+// Met "node" au vert pour "green" secondes : met a jour les feux et l'anneau
+void startPhase(Intersection* x, TrafficPhaseNode* node, int green, unsigned long now) {
+    LightDurations adjusted = phaseDurations(x, node->phase);
+    while (x->phases.front != node) {
+        dequeuePhase(&x->phases); // rotation jusqu'a la phase choisie (les autres sont sautees)
+    }
+    x->currentPhase = node;
+    node->greenDuration = green;
+    node->redDuration = adjusted.redDuration;
+    x->phaseStartTime = now;
+
+    for (int i = 0; i < x->numLanes; i++) {
+        Queue* q = x->lanes[i].aller;
+        q->lightState = laneIsGreen(node->phase, i) ? GREEN : RED;
+        x->laneState->light[laneStateIndex(x->laneState, x->laneSlot, i)] = q->lightState;
+        q->currentGreenDuration = green;
+        q->currentRedDuration = adjusted.redDuration;
+        q->version++;
+        x->lightEpoch[i]++;
+        x->dischargePending[i] = 0;
+        x->dischargeCredit[i] = 0;
+        scheduleDischarge(x, i, now);
+    }
+}
+
+// Planifie la prochaine decision du controleur de feux
+void schedulePhaseSwitch(Intersection* x, unsigned long at) {
+    x->phaseEndTime = at;
+    scheduleEvent(&x->events, at, EVENT_PHASE_SWITCH, -1, x->phaseEpoch);
+}
+
+/* --- Preemption par les vehicules d'urgence --- */
+// Une urgence entre toujours en tete de sa voie aller. Si la voie est au rouge, la phase
+// en conflit est interrompue et la phase qui sert la voie passe au vert ; dans tous les cas,
+// la decision suivante du controleur est annulee et le vert tient jusqu'au passage de l'urgence.
+// Les urgences en attente sur d'autres voies sont ensuite servies tour a tour, puis la phase
+// interrompue reprend le vert qu'il lui restait et le cycle normal continue.
+
+// Vrai si une urgence attend en tete de la voie aller
+int emergencyWaiting(Intersection* x, int laneIndex) {
+    Vehicule* head = queueFront(x->lanes[laneIndex].aller);
+    return head != NULL && head->type == Emergency;
+}
+
+// Phase de l'anneau qui met la voie au vert
+TrafficPhaseNode* phaseServing(Intersection* x, int laneIndex) {
+    TrafficPhaseNode* node = x->currentPhase;
+    do {
+        if (laneIsGreen(node->phase, laneIndex)) return node;
+        node = node->next;
+    } while (node != x->currentPhase);
+    return x->currentPhase;
+}
+
+// Donne le vert a une urgence en tete de la voie (sans effet si une preemption est en cours)
+void requestPreemption(Intersection* x, int laneIndex, unsigned long now) {
+    if (!x->config->emergencyPreemption || x->preemptLane >= 0 || !emergencyWaiting(x, laneIndex)) return;
+    if (x->preemptedPhase == NULL) {
+        x->preemptedPhase = x->currentPhase;
+        x->preemptRemaining = (x->phaseEndTime > now) ? x->phaseEndTime - now : 0;
+    }
+    x->preemptLane = laneIndex;
+    x->phaseEpoch++; // la decision planifiee est ignoree : le vert tient jusqu'au passage
+    x->metrics.lanes[laneIndex].preemptions++;
+    if (!laneIsGreen(x->currentPhase->phase, laneIndex)) {
+        TrafficPhaseNode* node = phaseServing(x, laneIndex);
+        startPhase(x, node, phaseDurations(x, node->phase).greenDuration, now);
+    }
+    logWithTimestamp(x->trafficLog, MSG_PREEMPTION);
+}
+
+// Apres le passage de l'urgence : urgence suivante, sinon reprise de la phase interrompue
+void releasePreemption(Intersection* x, unsigned long now) {
+    x->preemptLane = -1;
+    for (int i = 0; i < x->numLanes && x->preemptLane < 0; i++) {
+        requestPreemption(x, i, now);
+    }
+    if (x->preemptLane >= 0) return;
+
+    TrafficPhaseNode* restored = x->preemptedPhase;
+    unsigned long green = x->preemptRemaining;
+    x->preemptedPhase = NULL;
+    // Une phase interrompue a la fin de son vert n'est pas reprise : le controleur decide au pas suivant
+    if (restored != x->currentPhase && green > 0) {
+        startPhase(x, restored, (int)green, now);
+    }
+    schedulePhaseSwitch(x, now + ((green > TIME_INCREMENT) ? green : TIME_INCREMENT));
+    logWithTimestamp(x->trafficLog, MSG_PREEMPTION_END);
+}
+
+/* --- Controleurs de feux --- */
+
+// Vehicules en attente sur les voies aller d'une phase
+int phaseQueued(Intersection* x, TrafficLightPhase phase) {
+    int queued = 0;
+    for (int i = 0; i < x->numLanes; i++) {
+        if (laneIsGreen(phase, i)) queued += x->lanes[i].aller->size;
+    }
+    return queued;
+}
+
+// Fixe : alternance des phases de l'anneau, vert allonge de GREEN_BOOST en cas d'embouteillage
+SignalDecision decideFixed(Intersection* x, unsigned long now) {
+    (void)now;
+    SignalDecision d;
+    d.phase = x->currentPhase->next;
+    d.duration = phaseDurations(x, d.phase->phase).greenDuration;
+    return d;
+}
+
+// Actionne : vert minimal BASE_GREEN_DURATION, prolonge seconde par seconde tant qu'un vehicule
+// attend ou est arrive depuis moins de ACTUATED_GAP s (gap-out), jusqu'a ACTUATED_MAX_GREEN (max-out).
+// Les phases sans vehicule en attente sont sautees ; sans demande ailleurs, le vert est conserve.
+SignalDecision decideActuated(Intersection* x, unsigned long now) {
+    const ScenarioConfig* c = x->config;
+    TrafficPhaseNode* current = x->currentPhase;
+    unsigned long elapsed = now - x->phaseStartTime;
+    SignalDecision d = {current, TIME_INCREMENT};
+
+    int demand = 0;
+    for (int i = 0; i < x->numLanes; i++) {
+        if (!laneIsGreen(current->phase, i)) continue;
+        if (!isEmpty(x->lanes[i].aller) || now - x->lastArrival[i] < (unsigned long)c->actuatedGap) demand = 1;
+    }
+    if (demand && elapsed < (unsigned long)c->actuatedMaxGreen) {
+        if (elapsed + TIME_INCREMENT > (unsigned long)c->actuatedMaxGreen) d.duration = c->actuatedMaxGreen - (int)elapsed;
+        return d;
+    }
+    for (TrafficPhaseNode* next = current->next; next != current; next = next->next) {
+        if (phaseQueued(x, next->phase) > 0) {
+            d.phase = next;
+            d.duration = c->baseGreenDuration;
+            return d;
+        }
+    }
+    return d;
+}
+
+// Pression d'une phase : pour chaque mouvement ouvert (voie aller -> voie de retour visee),
+// vehicules en attente moins occupation de la voie de retour
+int phasePressure(Intersection* x, TrafficLightPhase phase) {
+    int pressure = 0;
+    for (int i = 0; i < x->numLanes; i++) {
+        if (!laneIsGreen(phase, i)) continue;
+        Queue* q = x->lanes[i].aller;
+        int movements[4] = {0, 0, 0, 0};
+        for (int k = 0; k < q->size; k++) {
+            movements[exitDirection(q->direction, queueAt(q, k)->turn)]++;
+        }
+        for (int d = 0; d < 4; d++) {
+            if (movements[d] > 0) pressure += movements[d] - x->lanes[d].retour->size;
+        }
+    }
+    return pressure;
+}
+
+// Max-pressure : toutes les BASE_GREEN_DURATION s, met au vert la phase de plus forte pression
+// (a egalite la phase courante est gardee, les autres phases sont sautees)
+SignalDecision decideMaxPressure(Intersection* x, unsigned long now) {
+    (void)now;
+    SignalDecision d = {x->currentPhase, x->config->baseGreenDuration};
+    int best = phasePressure(x, x->currentPhase->phase);
+    for (TrafficPhaseNode* node = x->currentPhase->next; node != x->currentPhase; node = node->next) {
+        int pressure = phasePressure(x, node->phase);
+        if (pressure > best) {
+            best = pressure;
+            d.phase = node;
+        }
+    }
+    return d;
+}
+
+// Controleurs disponibles, dans l'ordre des valeurs de SIGNAL_CONTROLLER
+const SignalController signalControllers[SIGNAL_CONTROLLER_COUNT] = {
+    {"fixe", decideFixed},
+    {"actionne", decideActuated},
+    {"max-pressure", decideMaxPressure}
+};
+
+// Plan : phase du cycle de x->timing a l'instant "now", au vert jusqu'a la fin de sa part du cycle
+SignalDecision decidePlan(Intersection* x, unsigned long now) {
+    const SignalTiming* t = x->timing;
+    unsigned long cycle = (unsigned long)t->cycle;
+    int position = (int)((now + cycle - (unsigned long)t->offset % cycle) % cycle);
+    int northSouth = position < t->green;
+    SignalDecision d;
+    d.phase = phaseServing(x, northSouth ? NORTH : EAST);
+    d.duration = northSouth ? t->green - position : t->cycle - position;
+    return d;
+}
+
+// Controleur des plans a temps fixe (impose par applySignalTiming, hors SIGNAL_CONTROLLER)
+const SignalController planController = {"plan", decidePlan};
+
+// Remplace le controleur par le plan "timing" (garde par l'appelant) a partir de "now" : la phase
+// du plan a cet instant passe au vert. Une preemption en cours garde la main ; le plan reprend
+// a la decision qui la suit
+void applySignalTiming(Intersection* x, const SignalTiming* timing, unsigned long now) {
+    x->timing = timing;
+    x->controller = &planController;
+    if (x->preemptLane >= 0) return;
+    x->phaseEpoch++; // la decision planifiee par l'ancien controleur est ignoree
+    SignalDecision d = decidePlan(x, now);
+    if (d.phase != x->currentPhase) startPhase(x, d.phase, d.duration, now);
+    schedulePhaseSwitch(x, now + (unsigned long)d.duration);
+}
+
+// Initialise une intersection selon le scenario "config" : voies, anneau des phases et premiers evenements
+// "config" doit rester valide pendant toute la vie de l'intersection
+void initIntersection(Intersection* x, int id, const ScenarioConfig* config, unsigned long long seed, MemoryPool* pool, TrafficLog* trafficLog, TrafficHistoryStack* history) {
+    x->id = id;
+    x->numLanes = 4;
+    x->config = config;
+    Direction dirs[] = {NORTH, SOUTH, EAST, WEST};
+    for (int i = 0; i < x->numLanes; i++) {
+        Createlane(&x->lanes[i], config->queueCapacity, i + 1, dirs[i]);
+        Queue* queues[] = {x->lanes[i].aller, x->lanes[i].retour};
+        for (int k = 0; k < 2; k++) {
+            queues[k]->pool = pool;
+            queues[k]->config = config;
+            queues[k]->baseGreenDuration = config->baseGreenDuration;
+            queues[k]->baseRedDuration = config->baseRedDuration;
+            queues[k]->currentGreenDuration = config->baseGreenDuration;
+            queues[k]->currentRedDuration = config->baseRedDuration;
+        }
+        x->lanePtrs[i] = &x->lanes[i];
+        x->lightEpoch[i] = 0;
+        x->dischargePending[i] = 0;
+        x->dischargeCredit[i] = 0;
+    }
+    x->trafficLog = trafficLog;
+    x->history = history;
+    x->pool = pool;
+    x->clock = 0;
+    x->spillback = 0;
+    x->blockedDischarges = 0;
+    seedRandom(&x->rng, seed, (unsigned long long)id);
+    x->nextVehicleId = 1;
+    x->vehicleIdStride = 1;
+    x->receivedVehicles = 0;
+    x->exitedVehicles = 0;
+    memset(&x->metrics, 0, sizeof(x->metrics));
+    memset(x->lastArrival, 0, sizeof(x->lastArrival));
+    x->controller = &signalControllers[config->signalController];
+    x->timing = NULL;
+    x->laneState = NULL;
+    initLaneState(&x->ownLanes, 1, config);
+    bindLaneState(x, &x->ownLanes, 0);
+    x->laneTick = (unsigned long)-1;
+    x->replay = NULL;
+    x->rejectedArrivals = 0;
+    x->routes = NULL;
+    x->od = NULL;
+    x->node = 0;
+    x->arrivedVehicles = 0;
+    x->phaseEpoch = 0;
+    x->preemptLane = -1;
+    x->preemptedPhase = NULL;
+    x->preemptRemaining = 0;
+
+    initLLCircular(&x->phases);
+    enqueuePhase(&x->phases, NORTH_SOUTH_GREEN, config->baseGreenDuration, config->baseRedDuration);
+    enqueuePhase(&x->phases, EAST_WEST_GREEN, config->baseGreenDuration, config->baseRedDuration);
+    x->currentPhase = x->phases.front;
+
+    initEventQueue(&x->events);
+    // Premiere phase : Nord-Sud, avec les durees de base (files vides)
+    startPhase(x, x->currentPhase, phaseDurations(x, x->currentPhase->phase).greenDuration, 0);
+    schedulePhaseSwitch(x, (unsigned long)x->currentPhase->greenDuration);
+    scheduleEvent(&x->events, 0, EVENT_ARRIVAL, -1, 0);
+}
+
+// Libere les files, l'anneau des phases et les evenements ; les vehicules retournent au pool
+void freeIntersection(Intersection* x) {
+    for (int i = 0; i < x->numLanes; i++) {
+        Queue* queues[] = {x->lanes[i].aller, x->lanes[i].retour};
+        for (int k = 0; k < 2; k++) {
+            while (!isEmpty(queues[k])) {
+                releaseVehicule(x->pool, dequeue(queues[k], NULL));
+            }
+            freeQueue(queues[k]);
+        }
+    }
+    TrafficPhaseNode* node = x->phases.front;
+    if (node != NULL) {
+        x->phases.rear->next = NULL;
+        while (node != NULL) {
+            TrafficPhaseNode* next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+    x->phases.front = x->phases.rear = NULL;
+    freeEventQueue(&x->events);
+    if (x->laneState == &x->ownLanes) freeLaneState(&x->ownLanes);
+}
+
+// Echantillonne la longueur et l'embouteillage des voies aller (une fois par pas de temps)
+void sampleLaneMetrics(Intersection* x) {
+    x->metrics.samples++;
+    for (int i = 0; i < x->numLanes; i++) {
+        Queue* q = x->lanes[i].aller;
+        recordLogHistogram(&x->metrics.lanes[i].queueLength, (unsigned int)q->size);
+        x->metrics.lanes[i].jamSamples += x->laneState->jam[laneStateIndex(x->laneState, x->laneSlot, i)];
+    }
+}
+
+// Fait entrer les arrivees enregistrees du pas (deposees par stageDemand) dans leurs voies aller
+void replayArrivals(Intersection* x, unsigned long now) {
+    DemandBatch* b = x->replay;
+    for (int r = 0; r < b->count; r++) {
+        const DemandRecord* rec = &b->records[r];
+        int laneIndex = rec->origin;
+        if (admitVehicle(x->lanes[laneIndex].aller, x->trafficLog, (unsigned int)now, x->history,
+                         x->nextVehicleId, (VehiculeType)demandType(rec), (TurnDirection)demandTurn(rec),
+                         VEHICLE_NO_DESTINATION)) {
+            x->nextVehicleId += x->vehicleIdStride;
+            x->lastArrival[laneIndex] = now;
+        } else {
+            x->rejectedArrivals++;
+        }
+        requestPreemption(x, laneIndex, now);
+        scheduleDischarge(x, laneIndex, now);
+    }
+    b->count = 0;
+}
+
+// Arrivee d'un trajet origine-destination : tirage de Bernoulli a la probabilite de l'intersection,
+// puis destination ; le vehicule entre par l'approche d'ou il repart tout droit vers le prochain saut
+void routedArrival(Intersection* x, unsigned long now) {
+    RandomBlock draw = randomDraw(&x->rng, now, RANDOM_ANY_LANE, RANDOM_ARRIVAL, 0);
+    if (draw.v[0] >= x->od->arrivalThreshold[x->node]) return;
+    int destination = sampleOdDestination(x->od, x->node, draw.v[1], draw.v[2]);
+    if (destination < 0) return;
+    int laneIndex = oppositeDirection(routeExit(x->routes, destination, x->node));
+    Queue* q = x->lanes[laneIndex].aller;
+    VehiculeType type = drawVehiculeType(randomDraw(&x->rng, now, laneIndex, RANDOM_VEHICLE, 0), x->config);
+    if (admitVehicle(q, x->trafficLog, (unsigned int)now, x->history, x->nextVehicleId, type, STRAIGHT, destination)) {
+        x->nextVehicleId += x->vehicleIdStride;
+        x->lastArrival[laneIndex] = now;
+    } else {
+        x->rejectedArrivals++;
+    }
+    requestPreemption(x, laneIndex, now);
+    scheduleDischarge(x, laneIndex, now);
+}
+
+// Virage d'un vehicule entrant par "approach" : vers le prochain saut de sa route, tout droit a destination
+TurnDirection routedTurn(Intersection* x, Direction approach, int destination) {
+    if (destination == x->node) return STRAIGHT;
+    return routeTurn(approach, routeExit(x->routes, destination, x->node));
+}
+
+// Arrivee : arrivees enregistrees du pas en relecture, trajets origine-destination dans un reseau
+// route, sinon tirage de Bernoulli sur une voie aleatoire
+void handleArrival(Intersection* x, unsigned long now) {
+    if (x->replay != NULL) {
+        replayArrivals(x, now);
+        scheduleEvent(&x->events, now + TIME_INCREMENT, EVENT_ARRIVAL, -1, 0);
+        return;
+    }
+    if (x->od != NULL) {
+        routedArrival(x, now);
+        scheduleEvent(&x->events, now + TIME_INCREMENT, EVENT_ARRIVAL, -1, 0);
+        return;
+    }
+    RandomBlock draw = randomDraw(&x->rng, now, RANDOM_ANY_LANE, RANDOM_ARRIVAL, 0);
+    if (randomBelow(draw.v[0], 100) < x->config->vehicleGenProb) {
+        int laneIndex = randomBelow(draw.v[1], x->numLanes);
+        if (generateRandomVehicle(x->lanes[laneIndex].aller, x->trafficLog, now, x->history,
+                                  &x->rng, x->nextVehicleId)) {
+            x->nextVehicleId += x->vehicleIdStride;
+            x->lastArrival[laneIndex] = now;
+        } else {
+            x->rejectedArrivals++;
+        }
+        requestPreemption(x, laneIndex, now);
+        scheduleDischarge(x, laneIndex, now);
+    }
+    scheduleEvent(&x->events, now + TIME_INCREMENT, EVENT_ARRIVAL, -1, 0);
+}
+
+// Fin du vert : le controleur choisit la phase suivante ou prolonge la phase courante
+// (decision ignoree si une preemption l'a annulee depuis sa planification)
+void handlePhaseSwitch(Intersection* x, SimEvent* ev, unsigned long now) {
+    if (ev->epoch != x->phaseEpoch) return;
+    SignalDecision d = x->controller->decide(x, now);
+    if (d.phase != x->currentPhase) {
+        startPhase(x, d.phase, d.duration, now);
+        logWithTimestamp(x->trafficLog, MSG_PHASE_CHANGE);
+    }
+    schedulePhaseSwitch(x, now + (unsigned long)d.duration);
+}
+
+// Etage de passage d'une voie : ignore si le feu a change depuis la planification
+// Chaque etage ajoute passageDuration secondes de vert au credit de la voie ; processQueue fait
+// passer d'un bloc les vehicules que ce credit couvre au debit de saturation
+void handleDischarge(Intersection* x, SimEvent* ev, unsigned long now) {
+    if (ev->epoch != x->lightEpoch[ev->laneIndex]) return;
+    x->dischargePending[ev->laneIndex] = 0;
+
+    // En mode reseau, la tete attend si sa voie de retour est saturee (remontee de file)
+    Queue* q = x->lanes[ev->laneIndex].aller;
+    int* credit = &x->dischargeCredit[ev->laneIndex];
+    *credit += x->config->passageDuration * 10;
+    DischargeResult result = processQueue(q, x->trafficLog, x->history, now, x->lanePtrs, x->numLanes,
+                                          &x->metrics.lanes[ev->laneIndex], credit, x->spillback);
+    if (result.blocked) x->blockedDischarges++;
+    if (ev->laneIndex == x->preemptLane && !emergencyWaiting(x, ev->laneIndex)) {
+        releasePreemption(x, now);
+    }
+    scheduleDischarge(x, ev->laneIndex, now);
+}
+
+// Traite tous les evenements dates au plus tard a "until", puis avance l'horloge
+void advanceIntersection(Intersection* x, unsigned long until) {
+    while (hasEventUntil(&x->events, until)) {
+        SimEvent ev = popEvent(&x->events);
+        // Etat des voies d'une intersection isolee, mis a jour avant le premier evenement du pas
+        // (dans un reseau, le passage est fait pour toutes les intersections a la fois)
+        if (ev.time != x->laneTick && x->laneState == &x->ownLanes) {
+            updateLaneState(&x->ownLanes, 0, 1);
+            x->laneTick = ev.time;
+        }
+        x->clock = ev.time;
+        setTrafficLogTime(x->trafficLog, ev.time);
+        TRACE_BEGIN(span);
+        switch (ev.type) {
+            case EVENT_ARRIVAL:
+                sampleLaneMetrics(x);
+                handleArrival(x, ev.time);
+                TRACE_END(span, "arrival");
+                break;
+            case EVENT_PHASE_SWITCH:
+                handlePhaseSwitch(x, &ev, ev.time);
+                TRACE_END(span, "signal");
+                break;
+            case EVENT_DISCHARGE:
+                handleDischarge(x, &ev, ev.time);
+                TRACE_END(span, "discharge");
+                break;
+        }
+    }
+    x->clock = until;
+    setTrafficLogTime(x->trafficLog, until);
+}
+
+// Fait sortir les vehicules arrives au bout de leur voie de retour ("travel" secondes apres y etre
+// entres), comme une liaison sans voisine en mode reseau ; sans cela, une intersection isolee perd
+// tout vehicule des que ses voies de retour sont pleines
+void drainExitLanes(Intersection* x, unsigned long now, unsigned long travel) {
+    for (int d = 0; d < x->numLanes; d++) {
+        Queue* exit = x->lanes[d].retour;
+        while (!isEmpty(exit) && (unsigned long)queueFront(exit)->queueTime + travel <= now) {
+            releaseVehicule(x->pool, dequeue(exit, NULL));
+            x->exitedVehicles++;
+        }
+    }
+}
+
+#endif // ENGINE_H
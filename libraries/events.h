@@ -0,0 +1,92 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdlib.h>
+
+/* --- File d'evenements du moteur a evenements discrets --- */
+
+// Types d'evenements planifies sur l'horloge virtuelle
+typedef enum {
+    EVENT_ARRIVAL,      // Tirage d'une arrivee de vehicule
+    EVENT_PHASE_SWITCH, // Fin de la phase verte courante
+    EVENT_DISCHARGE     // Passage d'un vehicule au feu vert
+} EventType;
+
+// Evenement date sur l'horloge virtuelle
+typedef struct {
+    unsigned long time; // Date de l'evenement (en secondes simulees)
+    unsigned long seq;  // Ordre de planification, departage les evenements simultanes
+    EventType type;     // Nature de l'evenement
+    int laneIndex;      // Voie concernee (-1 si aucune)
+    int epoch;          // Generation du feu de la voie au moment de la planification
+} SimEvent;
+
+// Tas binaire (min) des evenements, trie par date puis par ordre de planification
+typedef struct {
+    SimEvent* heap;
+    int size;
+    int capacity;
+    unsigned long nextSeq;
+} EventQueue;
+
+// Initialise une file d'evenements vide
+void initEventQueue(EventQueue* eq) {
+    eq->capacity = 16;
+    eq->size = 0;
+    eq->nextSeq = 0;
+    eq->heap = (SimEvent*)malloc(sizeof(SimEvent) * eq->capacity);
+}
+
+// Libere la memoire de la file d'evenements
+void freeEventQueue(EventQueue* eq) {
+    free(eq->heap);
+    eq->heap = NULL;
+    eq->size = eq->capacity = 0;
+}
+
+// Compare deux evenements : vrai si a doit etre traite avant b
+int eventBefore(const SimEvent* a, const SimEvent* b) {
+    if (a->time != b->time) return a->time < b->time;
+    return a->seq < b->seq;
+}
+
+// Planifie un evenement a la date donnee
+void scheduleEvent(EventQueue* eq, unsigned long time, EventType type, int laneIndex, int epoch) {
+    if (eq->size == eq->capacity) {
+        eq->capacity *= 2;
+        eq->heap = (SimEvent*)realloc(eq->heap, sizeof(SimEvent) * eq->capacity);
+    }
+    SimEvent ev = { time, eq->nextSeq++, type, laneIndex, epoch };
+    int i = eq->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!eventBefore(&ev, &eq->heap[parent])) break;
+        eq->heap[i] = eq->heap[parent];
+        i = parent;
+    }
+    eq->heap[i] = ev;
+}
+
+// Verifie s'il reste un evenement date au plus tard a "until"
+int hasEventUntil(EventQueue* eq, unsigned long until) {
+    return eq->size > 0 && eq->heap[0].time <= until;
+}
+
+// Retire et retourne le prochain evenement (la file ne doit pas etre vide)
+SimEvent popEvent(EventQueue* eq) {
+    SimEvent top = eq->heap[0];
+    SimEvent last = eq->heap[--eq->size];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= eq->size) break;
+        if (child + 1 < eq->size && eventBefore(&eq->heap[child + 1], &eq->heap[child])) child++;
+        if (!eventBefore(&eq->heap[child], &last)) break;
+        eq->heap[i] = eq->heap[child];
+        i = child;
+    }
+    if (eq->size > 0) eq->heap[i] = last;
+    return top;
+}
+
+#endif // EVENTS_H
@@ -0,0 +1,242 @@
+#ifndef HISTORYRETENTION_H
+#define HISTORYRETENTION_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "historystore.h"
+
+/* --- Historique en memoire a taille bornee : enregistrements recents et cumuls par periode --- */
+// Les enregistrements les plus recents sont gardes tels quels dans un anneau de taille fixe.
+// Un enregistrement chasse de l'anneau est ajoute au cumul de sa minute ; une minute chassee de
+// son anneau est ajoutee au cumul de son heure ; une heure chassee rejoint le cumul "older".
+// Rien n'est alloue apres l'initialisation : la memoire reste celle fixee au depart.
+
+#define HISTORY_ROLLUP_LEVELS 2 // Cumuls par minute, puis par heure
+
+// Cumul d'une periode : vehicules par Direction et par VehiculeType
+typedef struct {
+    unsigned int start;        // Premiere seconde couverte
+    unsigned int end;          // Derniere seconde couverte
+    unsigned int counts[4][4]; // [origine][type]
+} HistoryBucket;
+
+// Anneau de cumuls d'une meme duree, du plus ancien (head) au plus recent
+typedef struct {
+    HistoryBucket* buckets;
+    int capacity;
+    int head;
+    int size;
+    unsigned int width; // Duree d'un cumul (secondes)
+} BucketRing;
+
+typedef struct {
+    HistoryRecord* raw;  // Anneau des enregistrements recents, du plus ancien (rawHead) au plus recent
+    int rawCapacity;
+    int rawHead;
+    int rawSize;
+    BucketRing levels[HISTORY_ROLLUP_LEVELS]; // Minutes, heures
+    HistoryBucket older;                      // Tout ce qui est sorti des heures conservees
+    unsigned long long total;                 // Enregistrements recus depuis l'initialisation
+} HistoryRetention;
+
+// Resultat d'une interrogation de l'historique en memoire
+typedef struct {
+    unsigned long long counts[4][4]; // [origine][type]
+    unsigned long long raw;          // Vehicules comptes depuis les enregistrements recents
+    unsigned long long rolled;       // Vehicules comptes depuis les cumuls
+    unsigned int firstTime;          // Periode couverte par les donnees retenues
+    unsigned int lastTime;
+    unsigned int resolution;         // Duree du plus gros cumul utilise (0 : enregistrements seuls)
+} HistorySummary;
+
+// Memoire occupee par les anneaux de cumuls
+size_t historyRollupBytes(int minutes, int hours) {
+    return sizeof(HistoryBucket) * (size_t)(minutes + hours);
+}
+
+void initBucketRing(BucketRing* ring, int capacity, unsigned int width) {
+    ring->buckets = (HistoryBucket*)malloc(sizeof(HistoryBucket) * (size_t)capacity);
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->size = 0;
+    ring->width = width;
+}
+
+HistoryBucket* bucketAt(const BucketRing* ring, int i) {
+    int slot = ring->head + i;
+    if (slot >= ring->capacity) slot -= ring->capacity;
+    return &ring->buckets[slot];
+}
+
+void clearHistoryBucket(HistoryBucket* b) {
+    memset(b, 0, sizeof(*b));
+    b->start = UINT_MAX;
+}
+
+// Vide l'historique en memoire (les anneaux gardent leur taille)
+void resetHistoryRetention(HistoryRetention* r) {
+    r->rawHead = r->rawSize = 0;
+    for (int l = 0; l < HISTORY_ROLLUP_LEVELS; l++) {
+        r->levels[l].head = r->levels[l].size = 0;
+    }
+    clearHistoryBucket(&r->older);
+    r->total = 0;
+}
+
+// Repartit "memoryBytes" : cumuls de HISTORY_MINUTE_BUCKETS minutes et HISTORY_HOUR_BUCKETS heures,
+// le reste pour les enregistrements recents (au moins HISTORY_MIN_RAW_RECORDS)
+void initHistoryRetention(HistoryRetention* r, size_t memoryBytes) {
+    size_t rollups = historyRollupBytes(HISTORY_MINUTE_BUCKETS, HISTORY_HOUR_BUCKETS);
+    size_t raw = (memoryBytes > rollups) ? (memoryBytes - rollups) / sizeof(HistoryRecord) : 0;
+    if (raw < HISTORY_MIN_RAW_RECORDS) raw = HISTORY_MIN_RAW_RECORDS;
+    if (raw > INT_MAX) raw = INT_MAX;
+    r->rawCapacity = (int)raw;
+    r->raw = (HistoryRecord*)malloc(sizeof(HistoryRecord) * raw);
+    initBucketRing(&r->levels[0], HISTORY_MINUTE_BUCKETS, 60);
+    initBucketRing(&r->levels[1], HISTORY_HOUR_BUCKETS, 3600);
+    resetHistoryRetention(r);
+}
+
+void freeHistoryRetention(HistoryRetention* r) {
+    free(r->raw);
+    r->raw = NULL;
+    r->rawCapacity = r->rawSize = 0;
+    for (int l = 0; l < HISTORY_ROLLUP_LEVELS; l++) {
+        free(r->levels[l].buckets);
+        r->levels[l].buckets = NULL;
+        r->levels[l].capacity = r->levels[l].size = 0;
+    }
+}
+
+// Change la memoire fixee a l'historique en memoire (nouveau scenario) ; son contenu est perdu
+void resizeHistoryRetention(HistoryRetention* r, size_t memoryBytes) {
+    freeHistoryRetention(r);
+    initHistoryRetention(r, memoryBytes);
+}
+
+// Memoire reservee par l'historique en memoire
+size_t historyRetentionBytes(const HistoryRetention* r) {
+    return sizeof(HistoryRecord) * (size_t)r->rawCapacity
+         + historyRollupBytes(r->levels[0].capacity, r->levels[1].capacity);
+}
+
+// Ajoute les compteurs de "src" a "dst" et elargit sa periode
+void mergeHistoryBucket(HistoryBucket* dst, const HistoryBucket* src) {
+    for (int o = 0; o < 4; o++) {
+        for (int t = 0; t < 4; t++) dst->counts[o][t] += src->counts[o][t];
+    }
+    if (src->start < dst->start) dst->start = src->start;
+    if (src->end > dst->end) dst->end = src->end;
+}
+
+// Ajoute un cumul au niveau "level" : fusionne avec le plus recent s'il couvre la meme periode,
+// sinon en ouvre un nouveau ; le plus ancien, chasse si l'anneau est plein, monte d'un niveau
+void rollHistoryBucket(HistoryRetention* r, int level, const HistoryBucket* src) {
+    if (level == HISTORY_ROLLUP_LEVELS) {
+        mergeHistoryBucket(&r->older, src);
+        return;
+    }
+    BucketRing* ring = &r->levels[level];
+    unsigned int start = src->start - src->start % ring->width;
+    if (ring->size > 0) {
+        HistoryBucket* newest = bucketAt(ring, ring->size - 1);
+        if (newest->start == start) {
+            mergeHistoryBucket(newest, src);
+            return;
+        }
+    }
+    if (ring->size == ring->capacity) {
+        HistoryBucket evicted = *bucketAt(ring, 0);
+        ring->head = (ring->head + 1 == ring->capacity) ? 0 : ring->head + 1;
+        ring->size--;
+        rollHistoryBucket(r, level + 1, &evicted);
+    }
+    HistoryBucket* b = bucketAt(ring, ring->size++);
+    *b = *src;
+    b->start = start;
+    b->end = start + ring->width - 1;
+}
+
+// Cumul d'un seul enregistrement
+void recordHistoryBucket(HistoryBucket* b, const HistoryRecord* record) {
+    memset(b, 0, sizeof(*b));
+    b->start = b->end = record->time;
+    b->counts[record->origin & 3][record->type & 3] = 1;
+}
+
+// Garde un enregistrement ; le plus ancien, si l'anneau est plein, passe dans le cumul de sa minute
+void retainHistoryRecord(HistoryRetention* r, const HistoryRecord* record) {
+    if (r->rawSize == r->rawCapacity) {
+        HistoryBucket b;
+        recordHistoryBucket(&b, &r->raw[r->rawHead]);
+        rollHistoryBucket(r, 0, &b);
+        r->rawHead = (r->rawHead + 1 == r->rawCapacity) ? 0 : r->rawHead + 1;
+        r->rawSize--;
+    }
+    int slot = r->rawHead + r->rawSize;
+    if (slot >= r->rawCapacity) slot -= r->rawCapacity;
+    r->raw[slot] = *record;
+    r->rawSize++;
+    r->total++;
+}
+
+// Enregistrement recent de rang "i" (0 : le plus ancien)
+const HistoryRecord* retainedRecordAt(const HistoryRetention* r, int i) {
+    int slot = r->rawHead + i;
+    if (slot >= r->rawCapacity) slot -= r->rawCapacity;
+    return &r->raw[slot];
+}
+
+void widenHistorySummary(HistorySummary* s, unsigned int start, unsigned int end) {
+    if (start < s->firstTime) s->firstTime = start;
+    if (end > s->lastTime) s->lastTime = end;
+}
+
+// Ajoute a "s" un cumul dont la periode recoupe [fromTime, toTime] (compte en entier : precision de sa duree)
+void summarizeHistoryBucket(HistorySummary* s, const HistoryBucket* b, unsigned int width,
+                            unsigned int fromTime, unsigned int toTime) {
+    if (b->start > b->end || b->end < fromTime || b->start > toTime) return;
+    unsigned long long n = 0;
+    for (int o = 0; o < 4; o++) {
+        for (int t = 0; t < 4; t++) {
+            s->counts[o][t] += b->counts[o][t];
+            n += b->counts[o][t];
+        }
+    }
+    if (n == 0) return;
+    s->rolled += n;
+    if (width > s->resolution) s->resolution = width;
+    widenHistorySummary(s, b->start, b->end);
+}
+
+// Compte les vehicules entres dans une file entre "fromTime" et "toTime" (inclus), par origine et type :
+// les enregistrements recents sont exacts, les plus anciens sont lus dans les cumuls
+HistorySummary summarizeHistoryRetention(const HistoryRetention* r, unsigned int fromTime, unsigned int toTime) {
+    HistorySummary s;
+    memset(&s, 0, sizeof(s));
+    s.firstTime = UINT_MAX;
+    for (int i = 0; i < r->rawSize; i++) {
+        const HistoryRecord* record = retainedRecordAt(r, i);
+        if (record->time < fromTime || record->time > toTime) continue;
+        s.counts[record->origin & 3][record->type & 3]++;
+        s.raw++;
+        widenHistorySummary(&s, record->time, record->time);
+    }
+    for (int l = 0; l < HISTORY_ROLLUP_LEVELS; l++) {
+        const BucketRing* ring = &r->levels[l];
+        for (int i = 0; i < ring->size; i++) {
+            summarizeHistoryBucket(&s, bucketAt(ring, i), ring->width, fromTime, toTime);
+        }
+    }
+    summarizeHistoryBucket(&s, &r->older, r->older.end - r->older.start + 1, fromTime, toTime);
+    if (s.firstTime == UINT_MAX) s.firstTime = 0;
+    return s;
+}
+
+// Debit moyen (vehicules par minute) d'un compte sur la periode couverte par le resume
+double historyRatePerMinute(const HistorySummary* s, unsigned long long count) {
+    if (s->raw + s->rolled == 0) return 0.0;
+    return 60.0 * (double)count / (double)(s->lastTime - s->firstTime + 1);
+}
+
+#endif // HISTORYRETENTION_H
@@ -0,0 +1,352 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "mmapfile.h"
+
+/* --- Historique persistant : journal binaire en ajout seul, projete en memoire --- */
+// Deux fichiers : "<base>.rec" (en-tete + enregistrements de 16 octets) et
+// "<base>.idx" (blocs de 4 Ko de listes de postings, un fil de blocs par cle d'index).
+// A la reouverture, un historique d'une autre version ou d'une autre taille d'enregistrement est
+// refuse ; un index absent, tronque ou d'une autre taille de bloc est reconstruit depuis les enregistrements.
+
+#define HISTORY_STORE_MAGIC 0x31534854u // "THS1"
+#define HISTORY_STORE_VERSION 2         // 2 : tailles d'enregistrement et de bloc dans l'en-tete
+#define POSTING_BLOCK_SIZE 4096
+#define HISTORY_ID_BUCKETS 64
+#define HISTORY_COMPOSITE_KEYS 16                             // origine x type
+#define HISTORY_INDEX_KEYS (HISTORY_COMPOSITE_KEYS + HISTORY_ID_BUCKETS)
+
+// Enregistrement d'un vehicule entrant dans une file
+typedef struct {
+    int vehicleId;            // Identifiant du vehicule
+    unsigned int time;        // Pas d'entree dans la file enregistree (cle des recherches par date)
+    unsigned int arrivalTime; // Pas d'arrivee du vehicule dans la simulation
+    unsigned char type;       // VehiculeType
+    unsigned char origin;     // Direction
+    unsigned char turn;       // TurnDirection
+    unsigned char run;        // Numero de simulation (modulo 256)
+} HistoryRecord;
+
+// En-tete du fichier d'enregistrements (64 octets)
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long recordCount; // Enregistrements valides
+    unsigned int blockCount;        // Blocs d'index utilises dans "<base>.idx"
+    unsigned int runCount;          // Simulations enregistrees
+    unsigned int recordSize;        // sizeof(HistoryRecord) a la creation
+    unsigned int blockSize;         // POSTING_BLOCK_SIZE de "<base>.idx"
+    unsigned int reserved[8];
+} HistoryFileHeader;
+
+// Entree d'une liste de postings
+typedef struct {
+    unsigned int record; // Rang de l'enregistrement
+    unsigned int time;   // Copie de la date (filtrage sans lire l'enregistrement)
+    int vehicleId;       // Copie de l'identifiant
+} PostingEntry;
+
+// En-tete d'un bloc de postings : bornes de dates et d'identifiants des entrees du bloc
+typedef struct {
+    unsigned short key;
+    unsigned short count;
+    unsigned int minTime, maxTime;
+    int minId, maxId;
+    unsigned int reserved;
+} PostingBlockHeader;
+
+#define POSTING_ENTRIES ((POSTING_BLOCK_SIZE - sizeof(PostingBlockHeader)) / sizeof(PostingEntry))
+
+// Resume d'un bloc garde en memoire (evite de toucher les blocs hors intervalle)
+typedef struct {
+    unsigned int block;
+    unsigned int minTime, maxTime;
+    int minId, maxId;
+} BlockSummary;
+
+// Blocs d'une cle d'index, dans l'ordre d'ajout
+typedef struct {
+    BlockSummary* blocks;
+    int count;
+    int capacity;
+} KeyDirectory;
+
+// Historique ouvert
+typedef struct HistoryStore {
+    MappedFile records;          // "<base>.rec"
+    MappedFile index;            // "<base>.idx"
+    unsigned long long recordCapacity;
+    unsigned int blockCapacity;
+    KeyDirectory keys[HISTORY_INDEX_KEYS];
+    unsigned char currentRun;
+} HistoryStore;
+
+// Critere de recherche ; -1 signifie "tous"
+typedef struct {
+    int vehicleId;
+    int origin;
+    int type;
+    unsigned int fromTime; // Intervalle de dates inclus
+    unsigned int toTime;
+} HistoryQuery;
+
+typedef void (*HistoryVisitor)(const HistoryRecord* record, void* ctx);
+
+HistoryFileHeader* historyHeader(HistoryStore* s) {
+    return (HistoryFileHeader*)s->records.data;
+}
+
+HistoryRecord* historyRecordAt(HistoryStore* s, unsigned long long i) {
+    return (HistoryRecord*)((char*)s->records.data + sizeof(HistoryFileHeader)) + i;
+}
+
+PostingBlockHeader* postingBlockAt(HistoryStore* s, unsigned int block) {
+    return (PostingBlockHeader*)((char*)s->index.data + (size_t)block * POSTING_BLOCK_SIZE);
+}
+
+PostingEntry* postingEntries(PostingBlockHeader* b) {
+    return (PostingEntry*)(b + 1);
+}
+
+int compositeKey(int origin, int type) {
+    return origin * 4 + type;
+}
+
+int idBucketKey(int vehicleId) {
+    return HISTORY_COMPOSITE_KEYS + (int)((unsigned int)vehicleId % HISTORY_ID_BUCKETS);
+}
+
+// Ajoute le resume d'un bloc au repertoire de sa cle
+void addBlockSummary(KeyDirectory* dir, unsigned int block, PostingBlockHeader* b) {
+    if (dir->count == dir->capacity) {
+        dir->capacity = dir->capacity ? dir->capacity * 2 : 16;
+        dir->blocks = (BlockSummary*)realloc(dir->blocks, sizeof(BlockSummary) * dir->capacity);
+    }
+    BlockSummary* sum = &dir->blocks[dir->count++];
+    sum->block = block;
+    sum->minTime = b->minTime;
+    sum->maxTime = b->maxTime;
+    sum->minId = b->minId;
+    sum->maxId = b->maxId;
+}
+
+// Ajoute une entree a la liste de postings d'une cle (nouveau bloc si le dernier est plein)
+int addPosting(HistoryStore* s, int key, unsigned int record, unsigned int time, int vehicleId) {
+    KeyDirectory* dir = &s->keys[key];
+    PostingBlockHeader* block = NULL;
+    if (dir->count > 0) {
+        block = postingBlockAt(s, dir->blocks[dir->count - 1].block);
+        if (block->count >= POSTING_ENTRIES) block = NULL;
+    }
+    if (block == NULL) {
+        unsigned int b = historyHeader(s)->blockCount;
+        if (b == s->blockCapacity) {
+            if (!growMappedFile(&s->index, (size_t)s->blockCapacity * 2 * POSTING_BLOCK_SIZE)) return 0;
+            s->blockCapacity *= 2;
+        }
+        block = postingBlockAt(s, b);
+        block->key = (unsigned short)key;
+        block->count = 0;
+        block->minTime = UINT_MAX;
+        block->maxTime = 0;
+        block->minId = INT_MAX;
+        block->maxId = INT_MIN;
+        historyHeader(s)->blockCount = b + 1;
+        addBlockSummary(dir, b, block);
+    }
+    PostingEntry* e = &postingEntries(block)[block->count++];
+    e->record = record;
+    e->time = time;
+    e->vehicleId = vehicleId;
+    if (time < block->minTime) block->minTime = time;
+    if (time > block->maxTime) block->maxTime = time;
+    if (vehicleId < block->minId) block->minId = vehicleId;
+    if (vehicleId > block->maxId) block->maxId = vehicleId;
+
+    BlockSummary* sum = &dir->blocks[dir->count - 1];
+    sum->minTime = block->minTime;
+    sum->maxTime = block->maxTime;
+    sum->minId = block->minId;
+    sum->maxId = block->maxId;
+    return 1;
+}
+
+// Verifie l'index ouvert de "idxSize" octets : taille de bloc, blocs utilises presents, en-tetes
+// de blocs plausibles, deux postings par enregistrement valide et aucun posting au-dela de
+// recordCount (index plus recent que "<base>.rec"). Retourne 0 s'il doit etre reconstruit
+int historyIndexValid(HistoryStore* s, long long idxSize) {
+    HistoryFileHeader* h = historyHeader(s);
+    if (h->blockSize != POSTING_BLOCK_SIZE || idxSize % POSTING_BLOCK_SIZE != 0) return 0;
+    if (idxSize < (long long)h->blockCount * POSTING_BLOCK_SIZE || idxSize == 0) return 0;
+    unsigned long long postings = 0;
+    for (unsigned int b = 0; b < h->blockCount; b++) {
+        PostingBlockHeader* block = postingBlockAt(s, b);
+        if (block->key >= HISTORY_INDEX_KEYS || block->count > POSTING_ENTRIES) return 0;
+        PostingEntry* entries = postingEntries(block);
+        for (int e = 0; e < block->count; e++) {
+            if (entries[e].record >= h->recordCount) return 0;
+        }
+        postings += block->count;
+    }
+    return postings == 2 * h->recordCount;
+}
+
+// Reconstruit "<base>.idx" a partir des enregistrements valides. Retourne 1 si succes
+int rebuildHistoryIndex(HistoryStore* s) {
+    HistoryFileHeader* h = historyHeader(s);
+    for (int k = 0; k < HISTORY_INDEX_KEYS; k++) s->keys[k].count = 0;
+    h->blockCount = 0;
+    h->blockSize = POSTING_BLOCK_SIZE;
+    s->blockCapacity = 64;
+    if (!growMappedFile(&s->index, (size_t)s->blockCapacity * POSTING_BLOCK_SIZE)) return 0;
+    for (unsigned long long n = 0; n < h->recordCount; n++) {
+        HistoryRecord* r = historyRecordAt(s, n);
+        if (!addPosting(s, compositeKey(r->origin & 3, r->type & 3), (unsigned int)n, r->time, r->vehicleId)) return 0;
+        if (!addPosting(s, idBucketKey(r->vehicleId), (unsigned int)n, r->time, r->vehicleId)) return 0;
+    }
+    return 1;
+}
+
+// Ouvre (ou cree) l'historique "<base>.rec" / "<base>.idx". Retourne 1 si succes, 0 si les fichiers
+// ne peuvent pas etre ouverts ou si "<base>.rec" est d'un autre format (il n'est pas modifie)
+int openHistoryStore(HistoryStore* s, const char* base) {
+    char path[512];
+    memset(s, 0, sizeof(*s));
+
+    snprintf(path, sizeof(path), "%s.rec", base);
+    long long recSize = openMappedFile(&s->records, path, 1);
+    snprintf(path, sizeof(path), "%s.idx", base);
+    long long idxSize = openMappedFile(&s->index, path, 1);
+    if (recSize < 0 || idxSize < 0) return 0;
+
+    if (recSize < (long long)sizeof(HistoryFileHeader)) {
+        // Nouvel historique : en-tete et premiers blocs
+        recSize = sizeof(HistoryFileHeader) + sizeof(HistoryRecord) * 4096;
+        if (!growMappedFile(&s->records, (size_t)recSize)) return 0;
+        memset(s->records.data, 0, sizeof(HistoryFileHeader));
+        historyHeader(s)->magic = HISTORY_STORE_MAGIC;
+        historyHeader(s)->version = HISTORY_STORE_VERSION;
+        historyHeader(s)->recordSize = sizeof(HistoryRecord);
+        historyHeader(s)->blockSize = POSTING_BLOCK_SIZE;
+        idxSize = (long long)POSTING_BLOCK_SIZE * 64;
+        if (!growMappedFile(&s->index, (size_t)idxSize)) return 0;
+    } else {
+        if (!mapOpenedFile(&s->records, (size_t)recSize)) return 0;
+        if (!mapOpenedFile(&s->index, (size_t)idxSize)) return 0;
+        HistoryFileHeader* h = historyHeader(s);
+        if (h->magic == HISTORY_STORE_MAGIC && h->version == 1 && h->recordSize == 0) {
+            // Version 1 : meme disposition, tailles non enregistrees (16 octets, blocs de 4 Ko)
+            h->version = HISTORY_STORE_VERSION;
+            h->recordSize = 16;
+            h->blockSize = 4096;
+        }
+        if (h->magic != HISTORY_STORE_MAGIC || h->version != HISTORY_STORE_VERSION ||
+            h->recordSize != sizeof(HistoryRecord)) {
+            return 0;
+        }
+        if (h->recordCount > ((unsigned long long)recSize - sizeof(HistoryFileHeader)) / sizeof(HistoryRecord)) {
+            return 0; // Fichier d'enregistrements tronque
+        }
+    }
+    s->recordCapacity = ((unsigned long long)recSize - sizeof(HistoryFileHeader)) / sizeof(HistoryRecord);
+    s->blockCapacity = (unsigned int)(idxSize / POSTING_BLOCK_SIZE);
+    s->currentRun = (unsigned char)historyHeader(s)->runCount;
+    if (!historyIndexValid(s, idxSize)) return rebuildHistoryIndex(s);
+
+    // Reconstruction du repertoire des blocs a partir de leurs en-tetes
+    for (unsigned int b = 0; b < historyHeader(s)->blockCount; b++) {
+        PostingBlockHeader* block = postingBlockAt(s, b);
+        if (block->key < HISTORY_INDEX_KEYS) {
+            addBlockSummary(&s->keys[block->key], b, block);
+        }
+    }
+    return 1;
+}
+
+// Commence une nouvelle simulation : ses enregistrements portent un nouveau numero
+void beginHistoryRun(HistoryStore* s) {
+    s->currentRun = (unsigned char)(++historyHeader(s)->runCount);
+}
+
+// Ajoute un enregistrement et l'indexe par (origine, type) et par identifiant
+int appendHistoryRecord(HistoryStore* s, HistoryRecord* r) {
+    unsigned long long n = historyHeader(s)->recordCount;
+    if (n >= UINT_MAX) return 0;
+    if (n == s->recordCapacity) {
+        size_t size = sizeof(HistoryFileHeader) + sizeof(HistoryRecord) * (size_t)(s->recordCapacity * 2);
+        if (!growMappedFile(&s->records, size)) return 0;
+        s->recordCapacity *= 2;
+    }
+    r->run = s->currentRun;
+    *historyRecordAt(s, n) = *r;
+    // Compte d'abord l'enregistrement : un arret avant ses postings laisse un index incomplet,
+    // reconstruit a la reouverture, jamais un posting vers un enregistrement non compte
+    historyHeader(s)->recordCount = n + 1;
+    if (!addPosting(s, compositeKey(r->origin & 3, r->type & 3), (unsigned int)n, r->time, r->vehicleId)) return 0;
+    if (!addPosting(s, idBucketKey(r->vehicleId), (unsigned int)n, r->time, r->vehicleId)) return 0;
+    return 1;
+}
+
+// Parcourt les enregistrements repondant au critere ; retourne leur nombre
+// Seuls les blocs dont les bornes recouvrent l'intervalle (et l'identifiant) sont lus
+long long queryHistoryStore(HistoryStore* s, const HistoryQuery* q, HistoryVisitor visit, void* ctx) {
+    int keys[HISTORY_COMPOSITE_KEYS];
+    int numKeys = 0;
+    if (q->vehicleId >= 0) {
+        keys[numKeys++] = idBucketKey(q->vehicleId);
+    } else {
+        for (int o = 0; o < 4; o++) {
+            if (q->origin >= 0 && q->origin != o) continue;
+            for (int t = 0; t < 4; t++) {
+                if (q->type >= 0 && q->type != t) continue;
+                keys[numKeys++] = compositeKey(o, t);
+            }
+        }
+    }
+
+    long long matches = 0;
+    for (int k = 0; k < numKeys; k++) {
+        KeyDirectory* dir = &s->keys[keys[k]];
+        for (int i = 0; i < dir->count; i++) {
+            BlockSummary* sum = &dir->blocks[i];
+            if (sum->maxTime < q->fromTime || sum->minTime > q->toTime) continue;
+            if (q->vehicleId >= 0 && (q->vehicleId < sum->minId || q->vehicleId > sum->maxId)) continue;
+            PostingBlockHeader* block = postingBlockAt(s, sum->block);
+            PostingEntry* entries = postingEntries(block);
+            for (int e = 0; e < block->count; e++) {
+                if (entries[e].time < q->fromTime || entries[e].time > q->toTime) continue;
+                if (q->vehicleId >= 0 && entries[e].vehicleId != q->vehicleId) continue;
+                HistoryRecord* r = historyRecordAt(s, entries[e].record);
+                if (q->origin >= 0 && r->origin != q->origin) continue;
+                if (q->type >= 0 && r->type != q->type) continue;
+                matches++;
+                if (visit != NULL) visit(r, ctx);
+            }
+        }
+    }
+    return matches;
+}
+
+// Nombre d'enregistrements de l'historique
+unsigned long long historyRecordCount(HistoryStore* s) {
+    return historyHeader(s)->recordCount;
+}
+
+// Ecrit les pages modifiees, ferme les fichiers et libere les repertoires
+void closeHistoryStore(HistoryStore* s) {
+    syncMappedFile(&s->records);
+    syncMappedFile(&s->index);
+    closeMappedFile(&s->records);
+    closeMappedFile(&s->index);
+    for (int k = 0; k < HISTORY_INDEX_KEYS; k++) {
+        free(s->keys[k].blocks);
+        s->keys[k].blocks = NULL;
+        s->keys[k].count = s->keys[k].capacity = 0;
+    }
+}
+
+#endif // HISTORYSTORE_H
@@ -0,0 +1,121 @@
+#ifndef LANESTATE_H
+#define LANESTATE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "scenario.h"
+
+/* --- Etat des voies aller en structure de tableaux --- */
+// Chaque champ est un tableau d'entiers contigu, range par direction : l'approche "d" de
+// l'intersection "i" est a l'indice d * stride + i. Le passage de chaque pas de temps
+// (embouteillage, seuil, durees de feux) est une suite de boucles sans branchement sur des
+// tableaux contigus, que le compilateur vectorise.
+// Les files restent la reference : elles recopient leur taille ici a chaque entree/sortie.
+
+#define LANE_STATE_ALIGN 16 // Bloc traite d'un seul tenant ; le stride en est un multiple
+#define LANE_STATE_FIELDS 7
+
+typedef struct {
+    int count;      // Intersections couvertes
+    int stride;     // Ecart entre deux directions (count arrondi a LANE_STATE_ALIGN)
+    int* size;      // Vehicules en attente (recopie par la file)
+    int* capacity;  // Capacite de la file
+    int* jamLevel;  // Taille a partir de laquelle la voie est embouteillee
+    int* light;     // Etat du feu (TrafficLightState)
+    int* jam;       // 1 si la voie est embouteillee (updateLaneState)
+    int* green;     // Duree du vert de la phase de la voie, allongee si la paire est embouteillee
+    int* red;       // Duree du rouge de la phase de la voie, reduite de meme
+    int baseGreen, baseRed, greenBoost, redReduction;
+} LaneState;
+
+// Indice de l'approche "d" de l'intersection "i"
+int laneStateIndex(const LaneState* s, int i, int d) {
+    return d * s->stride + i;
+}
+
+// Cree l'etat de "count" intersections aux files vides ; retourne 0 si la memoire manque
+int initLaneState(LaneState* s, int count, const ScenarioConfig* c) {
+    s->count = count;
+    s->stride = (count + LANE_STATE_ALIGN - 1) / LANE_STATE_ALIGN * LANE_STATE_ALIGN;
+    size_t lanes = (size_t)4 * s->stride;
+    int* block = (int*)malloc(sizeof(int) * lanes * LANE_STATE_FIELDS);
+    if (block == NULL) return 0;
+    int** fields[LANE_STATE_FIELDS] = {&s->size, &s->capacity, &s->jamLevel, &s->light, &s->jam, &s->green, &s->red};
+    for (int f = 0; f < LANE_STATE_FIELDS; f++) {
+        *fields[f] = block + lanes * f;
+    }
+    // "taille >= capacite * seuil" equivaut, en entiers, a "taille >= plafond(capacite * seuil)"
+    int jamLevel = (int)ceil((double)c->queueCapacity * c->trafficJamThreshold);
+    for (size_t l = 0; l < lanes; l++) {
+        s->size[l] = 0;
+        s->capacity[l] = c->queueCapacity;
+        s->jamLevel[l] = jamLevel;
+        s->light[l] = 0;
+        s->jam[l] = 0;
+        s->green[l] = c->baseGreenDuration;
+        s->red[l] = c->baseRedDuration;
+    }
+    s->baseGreen = c->baseGreenDuration;
+    s->baseRed = c->baseRedDuration;
+    s->greenBoost = c->greenBoost;
+    s->redReduction = c->redReduction;
+    return 1;
+}
+
+void freeLaneState(LaneState* s) {
+    free(s->size); // un seul bloc pour tous les champs
+    s->size = NULL;
+    s->count = s->stride = 0;
+}
+
+// Embouteillage d'un bloc de voies d'une meme direction
+void laneJamBlock(const int* restrict size, const int* restrict level, int* restrict jam) {
+    for (int i = 0; i < LANE_STATE_ALIGN; i++) {
+        jam[i] = size[i] >= level[i];
+    }
+}
+
+// Durees des feux d'un bloc de paires de voies (A, B) : allongees si l'une des deux est embouteillee
+void laneTimingBlock(const LaneState* s, const int* restrict jamA, const int* restrict jamB,
+                     int* restrict greenA, int* restrict greenB, int* restrict redA, int* restrict redB) {
+    int baseGreen = s->baseGreen, baseRed = s->baseRed;
+    int boost = s->greenBoost, reduction = s->redReduction;
+    for (int i = 0; i < LANE_STATE_ALIGN; i++) {
+        int boosted = jamA[i] | jamB[i];
+        int green = baseGreen + boosted * boost;
+        int red = baseRed - boosted * reduction;
+        greenA[i] = green;
+        greenB[i] = green;
+        redA[i] = red;
+        redB[i] = red;
+    }
+}
+
+// Passage d'un pas de temps sur les intersections [first, last) : embouteillage de chaque voie,
+// puis durees des feux de chaque paire (Nord-Sud, Est-Ouest) comme adjustLightDurationsForPair.
+// Le traitement se fait par blocs entiers de LANE_STATE_ALIGN intersections (boucles de longueur
+// fixe) : deux appels concurrents doivent porter sur des blocs distincts (cf. alignLaneBlock).
+void updateLaneState(LaneState* s, int first, int last) {
+    first = first / LANE_STATE_ALIGN * LANE_STATE_ALIGN;
+    for (int block = first; block < last; block += LANE_STATE_ALIGN) {
+        for (int d = 0; d < 4; d++) {
+            int l = d * s->stride + block;
+            laneJamBlock(s->size + l, s->jamLevel + l, s->jam + l);
+        }
+        for (int d = 0; d < 4; d += 2) {
+            int a = d * s->stride + block, b = a + s->stride;
+            laneTimingBlock(s, s->jam + a, s->jam + b, s->green + a, s->green + b, s->red + a, s->red + b);
+        }
+    }
+}
+
+// Arrondit une borne de partition au bloc de LANE_STATE_ALIGN intersections (sans depasser count ;
+// la borne finale reste count, sinon les dernieres intersections ne seraient confiees a aucun thread)
+int alignLaneBlock(int index, int count) {
+    if (index >= count) return count;
+    int aligned = (index + LANE_STATE_ALIGN / 2) / LANE_STATE_ALIGN * LANE_STATE_ALIGN;
+    return (aligned < count) ? aligned : count;
+}
+
+#endif // LANESTATE_H
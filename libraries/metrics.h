@@ -0,0 +1,145 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <string.h>
+
+/* --- Metriques de trafic : compteurs et histogrammes logarithmiques par voie et par type --- */
+// Une mise a jour coute quelques operations entieres (pas d'allocation, pas de verrou) :
+// chaque intersection possede ses metriques et n'est avancee que par un seul thread.
+
+// Histogramme a seaux logarithmiques (facon HDR) : les valeurs 0..15 sont exactes, puis chaque
+// puissance de deux est divisee en 8 seaux (erreur relative au plus 12.5%).
+#define LOG_HISTOGRAM_SUB_BITS 3
+#define LOG_HISTOGRAM_SUB_COUNT (1 << LOG_HISTOGRAM_SUB_BITS)
+#define LOG_HISTOGRAM_MAX_BIT 16  // Les valeurs >= 2^16 partagent le dernier seau (le max reste exact)
+#define LOG_HISTOGRAM_BUCKETS ((LOG_HISTOGRAM_MAX_BIT - LOG_HISTOGRAM_SUB_BITS + 1) * LOG_HISTOGRAM_SUB_COUNT)
+#define VEHICLE_TYPE_COUNT 4      // Voiture, bus, moto, urgence (VehiculeType)
+
+typedef struct {
+    unsigned int counts[LOG_HISTOGRAM_BUCKETS];
+    unsigned long long count; // Nombre de valeurs enregistrees
+    unsigned long long sum;   // Somme exacte des valeurs (pour la moyenne)
+    unsigned int max;         // Plus grande valeur enregistree
+} LogHistogram;
+
+// Metriques d'une voie aller
+typedef struct {
+    unsigned long served[VEHICLE_TYPE_COUNT];  // Vehicules passes dans une voie de retour, par type
+    unsigned long lost[VEHICLE_TYPE_COUNT];    // Vehicules perdus au feu (voie de retour pleine), par type
+    LogHistogram wait[VEHICLE_TYPE_COUNT];     // Attente de l'entree dans la voie au passage du feu (secondes), par type
+    LogHistogram queueLength;                  // Longueur de la file, echantillonnee a chaque pas
+    unsigned long jamSamples;                  // Pas de temps ou la voie etait embouteillee
+    LogHistogram clearance;                    // Degagement des urgences : entree dans la voie -> passage (s)
+    unsigned long preemptions;                 // Feux verts forces pour une urgence de la voie
+} LaneMetrics;
+
+// Metriques d'une intersection
+typedef struct {
+    LaneMetrics lanes[4];
+    unsigned long samples; // Pas de temps echantillonnes
+} IntersectionMetrics;
+
+// Seau d'une valeur
+int logHistogramBucket(unsigned int value) {
+    if (value >= (1u << LOG_HISTOGRAM_MAX_BIT)) return LOG_HISTOGRAM_BUCKETS - 1;
+    if (value < 2 * LOG_HISTOGRAM_SUB_COUNT) return (int)value;
+    int msb = 31 - __builtin_clz(value);
+    int shift = msb - LOG_HISTOGRAM_SUB_BITS;
+    return (shift + 1) * LOG_HISTOGRAM_SUB_COUNT + (int)((value >> shift) & (LOG_HISTOGRAM_SUB_COUNT - 1));
+}
+
+// Plus grande valeur d'un seau
+unsigned int logHistogramBucketHigh(int bucket) {
+    if (bucket < 2 * LOG_HISTOGRAM_SUB_COUNT) return (unsigned int)bucket;
+    int shift = bucket / LOG_HISTOGRAM_SUB_COUNT - 1;
+    unsigned int low = (unsigned int)(LOG_HISTOGRAM_SUB_COUNT + bucket % LOG_HISTOGRAM_SUB_COUNT) << shift;
+    return low + (1u << shift) - 1;
+}
+
+void recordLogHistogram(LogHistogram* h, unsigned int value) {
+    h->counts[logHistogramBucket(value)]++;
+    h->count++;
+    h->sum += value;
+    if (value > h->max) h->max = value;
+}
+
+// Ajoute les valeurs de "src" a "dst"
+void mergeLogHistogram(LogHistogram* dst, const LogHistogram* src) {
+    for (int b = 0; b < LOG_HISTOGRAM_BUCKETS; b++) {
+        dst->counts[b] += src->counts[b];
+    }
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+double logHistogramMean(const LogHistogram* h) {
+    return (h->count > 0) ? (double)h->sum / (double)h->count : 0.0;
+}
+
+// Valeur couvrant la fraction "q" des enregistrements (borne haute du seau, sans depasser le max)
+unsigned int logHistogramPercentile(const LogHistogram* h, double q) {
+    if (h->count == 0) return 0;
+    unsigned long long rank = (unsigned long long)(q * (double)h->count + 0.999999);
+    if (rank == 0) rank = 1;
+    unsigned long long seen = 0;
+    for (int b = 0; b < LOG_HISTOGRAM_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            unsigned int high = logHistogramBucketHigh(b);
+            return (high < h->max) ? high : h->max;
+        }
+    }
+    return h->max;
+}
+
+// Enregistre un vehicule sorti de la voie apres "wait" secondes (served : passe, sinon perdu)
+void recordLaneDischarge(LaneMetrics* m, int type, unsigned int wait, int served) {
+    if (served) m->served[type]++;
+    else m->lost[type]++;
+    recordLogHistogram(&m->wait[type], wait);
+}
+
+// Totaux d'une voie, tous types confondus
+void laneMetricTotals(const LaneMetrics* m, unsigned long* served, unsigned long* lost, LogHistogram* wait) {
+    *served = *lost = 0;
+    memset(wait, 0, sizeof(*wait));
+    for (int t = 0; t < VEHICLE_TYPE_COUNT; t++) {
+        *served += m->served[t];
+        *lost += m->lost[t];
+        mergeLogHistogram(wait, &m->wait[t]);
+    }
+}
+
+// Ecrit l'etat des metriques d'une intersection : une ligne JSON par voie
+void writeMetricsSnapshot(FILE* out, const IntersectionMetrics* m, int intersectionId, unsigned long simTime) {
+    static const char* laneNames[4] = {"N", "S", "E", "O"};
+    static const char* typeNames[VEHICLE_TYPE_COUNT] = {"CAR", "BUS", "BIKE", "EMERGENCY"};
+    for (int l = 0; l < 4; l++) {
+        const LaneMetrics* lm = &m->lanes[l];
+        unsigned long served, lost;
+        LogHistogram wait;
+        laneMetricTotals(lm, &served, &lost, &wait);
+        fprintf(out, "{\"t\":%lu,\"intersection\":%d,\"lane\":\"%s\",\"served\":%lu,\"lost\":%lu,"
+                     "\"wait_mean\":%.2f,\"wait_p50\":%u,\"wait_p95\":%u,\"wait_p99\":%u,\"wait_max\":%u,"
+                     "\"queue_mean\":%.2f,\"queue_p95\":%u,\"queue_max\":%u,\"jam_pct\":%.2f,"
+                     "\"preemptions\":%lu,\"clearance_count\":%llu,\"clearance_mean\":%.2f,"
+                     "\"clearance_p95\":%u,\"clearance_max\":%u,\"types\":{",
+                simTime, intersectionId, laneNames[l], served, lost,
+                logHistogramMean(&wait), logHistogramPercentile(&wait, 0.50),
+                logHistogramPercentile(&wait, 0.95), logHistogramPercentile(&wait, 0.99), wait.max,
+                logHistogramMean(&lm->queueLength), logHistogramPercentile(&lm->queueLength, 0.95),
+                lm->queueLength.max, (m->samples > 0) ? 100.0 * (double)lm->jamSamples / (double)m->samples : 0.0,
+                lm->preemptions, lm->clearance.count, logHistogramMean(&lm->clearance),
+                logHistogramPercentile(&lm->clearance, 0.95), lm->clearance.max);
+        for (int t = 0; t < VEHICLE_TYPE_COUNT; t++) {
+            fprintf(out, "%s\"%s\":{\"served\":%lu,\"lost\":%lu,\"wait_mean\":%.2f,\"wait_p95\":%u}",
+                    (t > 0) ? "," : "", typeNames[t], lm->served[t], lm->lost[t],
+                    logHistogramMean(&lm->wait[t]), logHistogramPercentile(&lm->wait[t], 0.95));
+        }
+        fprintf(out, "}}\n");
+    }
+}
+
+#endif // METRICS_H
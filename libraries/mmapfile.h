@@ -0,0 +1,172 @@
+#ifndef MMAPFILE_H
+#define MMAPFILE_H
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* --- Fichiers projetes en memoire (Windows et POSIX) --- */
+
+#define MAPPED_FILE_GRANULARITY 65536 // Alignement des fenetres projetees (granularite Windows)
+
+// Fichier projete : "data" couvre "size" octets du fichier
+typedef struct {
+    void* data;
+    size_t size;
+    int writable;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+#ifdef _WIN32
+
+// Projette "size" octets du fichier deja ouvert (Windows)
+int mapOpenedFile(MappedFile* m, size_t size) {
+    m->data = NULL;
+    m->mapping = NULL;
+    m->size = size;
+    if (size == 0) return 1;
+    DWORD protect = m->writable ? PAGE_READWRITE : PAGE_READONLY;
+    m->mapping = CreateFileMappingA(m->file, NULL, protect,
+                                    (DWORD)((unsigned long long)size >> 32), (DWORD)size, NULL);
+    if (m->mapping == NULL) return 0;
+    m->data = MapViewOfFile(m->mapping, m->writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    return m->data != NULL;
+}
+
+// Projette en lecture "size" octets a partir de "offset" (multiple de MAPPED_FILE_GRANULARITY) (Windows)
+int mapOpenedFileRange(MappedFile* m, unsigned long long offset, size_t size) {
+    m->data = NULL;
+    m->mapping = NULL;
+    m->size = size;
+    if (size == 0) return 1;
+    m->mapping = CreateFileMappingA(m->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m->mapping == NULL) return 0;
+    m->data = MapViewOfFile(m->mapping, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)offset, size);
+    return m->data != NULL;
+}
+
+// Retire la projection sans fermer le fichier (Windows)
+void unmapOpenedFile(MappedFile* m) {
+    if (m->data != NULL) UnmapViewOfFile(m->data);
+    if (m->mapping != NULL) CloseHandle(m->mapping);
+    m->data = NULL;
+    m->mapping = NULL;
+}
+
+// Ouvre un fichier ; en ecriture il est cree s'il n'existe pas. Retourne sa taille actuelle ou -1
+long long openMappedFile(MappedFile* m, const char* path, int writable) {
+    m->writable = writable;
+    m->data = NULL;
+    m->mapping = NULL;
+    m->size = 0;
+    m->file = CreateFileA(path, writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                          FILE_SHARE_READ, NULL, writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                          FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m->file == INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m->file, &size)) return -1;
+    return (long long)size.QuadPart;
+}
+
+// Fixe la taille du fichier (la projection doit etre retiree)
+int resizeOpenedFile(MappedFile* m, size_t size) {
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)size;
+    return SetFilePointerEx(m->file, pos, NULL, FILE_BEGIN) && SetEndOfFile(m->file);
+}
+
+// Force l'ecriture des pages modifiees sur le disque
+void syncMappedFile(MappedFile* m) {
+    if (m->data != NULL) FlushViewOfFile(m->data, 0);
+}
+
+// Ferme le fichier et sa projection
+void closeMappedFile(MappedFile* m) {
+    unmapOpenedFile(m);
+    if (m->file != INVALID_HANDLE_VALUE) CloseHandle(m->file);
+    m->file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+// Projette "size" octets du fichier deja ouvert (POSIX)
+int mapOpenedFile(MappedFile* m, size_t size) {
+    m->data = NULL;
+    m->size = size;
+    if (size == 0) return 1;
+    int prot = m->writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* data = mmap(NULL, size, prot, MAP_SHARED, m->fd, 0);
+    if (data == MAP_FAILED) return 0;
+    m->data = data;
+    return 1;
+}
+
+// Projette en lecture "size" octets a partir de "offset" (multiple de MAPPED_FILE_GRANULARITY) (POSIX)
+int mapOpenedFileRange(MappedFile* m, unsigned long long offset, size_t size) {
+    m->data = NULL;
+    m->size = size;
+    if (size == 0) return 1;
+    void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, m->fd, (off_t)offset);
+    if (data == MAP_FAILED) return 0;
+    madvise(data, size, MADV_SEQUENTIAL); // lecture en avant, pages relachees plus tot
+    m->data = data;
+    return 1;
+}
+
+// Retire la projection sans fermer le fichier (POSIX)
+void unmapOpenedFile(MappedFile* m) {
+    if (m->data != NULL) munmap(m->data, m->size);
+    m->data = NULL;
+}
+
+// Ouvre un fichier ; en ecriture il est cree s'il n'existe pas. Retourne sa taille actuelle ou -1
+long long openMappedFile(MappedFile* m, const char* path, int writable) {
+    m->writable = writable;
+    m->data = NULL;
+    m->size = 0;
+    m->fd = open(path, writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (m->fd < 0) return -1;
+    struct stat st;
+    if (fstat(m->fd, &st) != 0) return -1;
+    return (long long)st.st_size;
+}
+
+// Fixe la taille du fichier (la projection doit etre retiree)
+int resizeOpenedFile(MappedFile* m, size_t size) {
+    return ftruncate(m->fd, (off_t)size) == 0;
+}
+
+// Force l'ecriture des pages modifiees sur le disque
+void syncMappedFile(MappedFile* m) {
+    if (m->data != NULL) msync(m->data, m->size, MS_SYNC);
+}
+
+// Ferme le fichier et sa projection
+void closeMappedFile(MappedFile* m) {
+    unmapOpenedFile(m);
+    if (m->fd >= 0) close(m->fd);
+    m->fd = -1;
+}
+
+#endif
+
+// Agrandit un fichier projete en ecriture a "size" octets et le reprojette
+int growMappedFile(MappedFile* m, size_t size) {
+    unmapOpenedFile(m);
+    if (!resizeOpenedFile(m, size)) return 0;
+    return mapOpenedFile(m, size);
+}
+
+#endif // MMAPFILE_H
@@ -0,0 +1,206 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "engine.h"
+
+/* --- Replications Monte Carlo independantes d'une intersection --- */
+// Chaque replication possede son intersection, son pool et son flux aleatoire :
+// les threads ne partagent que le compteur de replications et le tableau des resultats.
+// Les voies de retour se vident apres LINK_TRAVEL_TIME (drainExitLanes) : le debit mesure est
+// celui des feux, pas la capacite des voies de retour.
+
+#define INTERSECTION_TOTAL 4 // Index de ReplicationResult.lanes resumant toute l'intersection
+
+// Mesures d'une voie pour une replication
+typedef struct {
+    double throughput;   // Vehicules passes par heure
+    double meanWait;     // Attente moyenne au feu (secondes)
+    double p95Wait;      // 95e centile de l'attente (secondes)
+    double jamFrequency; // Part des pas de temps embouteilles (%)
+    double lost;         // Vehicules perdus (voie de retour pleine)
+    double clearanceP95; // 95e centile du degagement des urgences (secondes)
+} LaneSample;
+
+// Mesures de LaneSample dans l'ordre des tableaux de resultats
+#define LANE_METRIC_COUNT 6
+const size_t laneMetricOffsets[LANE_METRIC_COUNT] = {
+    offsetof(LaneSample, throughput), offsetof(LaneSample, meanWait), offsetof(LaneSample, p95Wait),
+    offsetof(LaneSample, jamFrequency), offsetof(LaneSample, lost), offsetof(LaneSample, clearanceP95)
+};
+const char* laneMetricNames[LANE_METRIC_COUNT] = {
+    "Debit (veh/h)", "Attente moy (s)", "Attente p95 (s)", "Embouteillage (%)", "Perdus", "Urgence p95 (s)"
+};
+
+// Resultat d'une replication : les quatre voies, puis l'intersection entiere
+// (debit et pertes cumules, attentes sur tous les vehicules, embouteillage moyen des voies)
+typedef struct {
+    LaneSample lanes[5];
+} ReplicationResult;
+
+// Moyenne et demi-largeur de l'intervalle de confiance a 95%
+typedef struct {
+    double mean;
+    double halfWidth;
+} Estimate;
+
+// Travail partage par les threads de replication : "replications" replications de chaque scenario
+typedef struct {
+    atomic_int next;                // Prochaine replication a lancer (tous scenarios confondus)
+    int count;                      // Nombre total de replications
+    int replications;               // Replications par scenario
+    const ScenarioConfig* configs;  // Scenarios simules
+    ReplicationResult* results;     // results[scenario * replications + numero]
+} ReplicationBatch;
+
+// Nombre de coeurs disponibles
+int availableCores() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+#endif
+}
+
+// Graine d'une replication : ne depend que de la graine de base et du numero
+unsigned long long replicationSeed(unsigned long long seed, int index) {
+    return mixSeed(seed + (unsigned long long)index);
+}
+
+// Resume les totaux d'une voie (ou de l'intersection entiere)
+void summarizeLane(unsigned long served, unsigned long lost, const LogHistogram* wait, const LogHistogram* clearance,
+                   unsigned long jamSamples, unsigned long samples, unsigned long duration, LaneSample* l) {
+    l->throughput = 3600.0 * (double)served / (double)duration;
+    l->meanWait = logHistogramMean(wait);
+    l->p95Wait = (double)logHistogramPercentile(wait, 0.95);
+    l->jamFrequency = (samples > 0) ? 100.0 * (double)jamSamples / (double)samples : 0.0;
+    l->lost = (double)lost;
+    l->clearanceP95 = (double)logHistogramPercentile(clearance, 0.95);
+}
+
+// Simule une replication complete du scenario "config" et resume chaque voie
+// Les replications de meme numero partagent leur graine d'un scenario a l'autre
+void runReplication(const ScenarioConfig* config, int index, ReplicationResult* out) {
+    TRACE_BEGIN(span);
+    unsigned long duration = (unsigned long)config->replicationDuration;
+    MemoryPool pool;
+    initPool(&pool, sizeof(Vehicule), VEHICLE_POOL_CHUNK);
+    Intersection x;
+    initIntersection(&x, 1, config, replicationSeed(config->seed, index), &pool, NULL, NULL);
+    for (unsigned long t = 0; t < duration; t += TIME_INCREMENT) {
+        advanceIntersection(&x, t);
+        drainExitLanes(&x, t, (unsigned long)config->linkTravelTime);
+    }
+
+    unsigned long totalServed = 0, totalLost = 0, totalJam = 0;
+    LogHistogram totalWait, totalClearance;
+    memset(&totalWait, 0, sizeof(totalWait));
+    memset(&totalClearance, 0, sizeof(totalClearance));
+    for (int i = 0; i < 4; i++) {
+        const LaneMetrics* m = &x.metrics.lanes[i];
+        unsigned long served, lost;
+        LogHistogram wait;
+        laneMetricTotals(m, &served, &lost, &wait);
+        summarizeLane(served, lost, &wait, &m->clearance, m->jamSamples, x.metrics.samples, duration, &out->lanes[i]);
+        totalServed += served;
+        totalLost += lost;
+        totalJam += m->jamSamples;
+        mergeLogHistogram(&totalWait, &wait);
+        mergeLogHistogram(&totalClearance, &m->clearance);
+    }
+    summarizeLane(totalServed, totalLost, &totalWait, &totalClearance, totalJam, x.metrics.samples * 4, duration,
+                  &out->lanes[INTERSECTION_TOTAL]);
+    freeIntersection(&x);
+    destroyPool(&pool);
+    TRACE_END(span, "replication");
+}
+
+// Boucle d'un thread : prend la prochaine replication libre jusqu'a epuisement
+void* replicationWorker(void* arg) {
+    ReplicationBatch* batch = (ReplicationBatch*)arg;
+    while (1) {
+        int index = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+        if (index >= batch->count) break;
+        runReplication(&batch->configs[index / batch->replications], index % batch->replications,
+                       &batch->results[index]);
+    }
+    TRACE_THREAD_EXIT();
+    return NULL;
+}
+
+// Lance "replications" replications de chacun des "configCount" scenarios sur "threads" threads
+// (0 : tous les coeurs) ; les resultats ne dependent pas du nombre de threads
+void runReplicationBatch(const ScenarioConfig* configs, int configCount, int replications,
+                         ReplicationResult* results, int threads) {
+    int count = configCount * replications;
+    if (threads <= 0) threads = availableCores();
+    if (threads > count) threads = count;
+    ReplicationBatch batch;
+    atomic_init(&batch.next, 0);
+    batch.count = count;
+    batch.replications = replications;
+    batch.configs = configs;
+    batch.results = results;
+
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * (threads > 0 ? threads : 1));
+    for (int t = 1; t < threads; t++) {
+        pthread_create(&workers[t], NULL, replicationWorker, &batch);
+    }
+    replicationWorker(&batch); // le thread appelant participe
+    for (int t = 1; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    free(workers);
+}
+
+// Lance les replications d'un seul scenario (config->replications resultats)
+void runReplications(const ScenarioConfig* config, ReplicationResult* results, int threads) {
+    runReplicationBatch(config, 1, config->replications, results, threads);
+}
+
+// Quantile de Student a 97.5% (intervalle bilateral a 95%) pour "df" degres de liberte
+double studentQuantile95(int df) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df <= 0) return 0.0;
+    if (df <= 30) return table[df - 1];
+    if (df <= 60) return 2.000;
+    if (df <= 120) return 1.980;
+    return 1.960;
+}
+
+// Moyenne et intervalle de confiance d'une mesure sur toutes les replications
+// "offset" designe le champ de LaneSample (offsetof) pour la voie "laneIndex"
+Estimate estimateLaneMetric(const ReplicationResult* results, int count, int laneIndex, size_t offset) {
+    Estimate e = {0.0, 0.0};
+    if (count == 0) return e;
+    double sum = 0.0;
+    for (int r = 0; r < count; r++) {
+        sum += *(const double*)((const char*)&results[r].lanes[laneIndex] + offset);
+    }
+    e.mean = sum / count;
+    if (count < 2) return e;
+    double squares = 0.0;
+    for (int r = 0; r < count; r++) {
+        double d = *(const double*)((const char*)&results[r].lanes[laneIndex] + offset) - e.mean;
+        squares += d * d;
+    }
+    e.halfWidth = studentQuantile95(count - 1) * sqrt(squares / (count - 1) / count);
+    return e;
+}
+
+#endif // MONTECARLO_H
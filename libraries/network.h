@@ -0,0 +1,308 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include "engine.h"
+#include "spsc.h"
+#include "viewer.h"
+
+/* --- Reseau de plusieurs intersections reliees par des liaisons --- */
+
+// Liaison sortante : la voie de retour d'une intersection alimente la voie aller de sa voisine
+typedef struct {
+    int target;      // Intersection aval (-1 : sortie du reseau)
+    int approach;    // Approche de l'intersection aval alimentee par la liaison
+    int travelTime;  // Duree de parcours de la liaison (secondes)
+    SpscRing handoff; // Vehicules arrives au bout de la liaison, en attente d'entrer chez la voisine
+} RoadLink;
+
+// Reseau d'intersections partageant la meme horloge virtuelle
+typedef struct {
+    Intersection* nodes;  // Intersections du reseau
+    MemoryPool* pools;    // Un pool de vehicules par intersection (utilise par son seul thread)
+    int count;            // Nombre d'intersections
+    RoadLink (*exits)[4]; // exits[i][dir] : liaison quittant l'intersection i par dir
+    int (*upstream)[4];   // upstream[i][dir] : intersection alimentant l'approche dir de i (-1 : aucune)
+    int (*upstreamExit)[4]; // upstreamExit[i][dir] : sortie de l'intersection amont vers cette approche
+    unsigned long clock;  // Horloge virtuelle du reseau
+    LaneState lanes;      // Etat des voies aller de toutes les intersections (structure de tableaux)
+    DemandStream* demand; // Demande enregistree relue (NULL : arrivees aleatoires)
+    DemandBatch* replay;  // replay[i] : arrivees du pas courant pour l'intersection i
+    Viewer* viewer;       // Visualisation alimentee pendant la simulation (NULL : aucune)
+    int viewCapture;      // Le pas courant alimente une image (decide avant l'entree des vehicules)
+} RoadNetwork;
+
+// Cree un reseau de "count" intersections isolees (toutes les sorties quittent le reseau)
+void createRoadNetwork(RoadNetwork* net, int count, const ScenarioConfig* config, unsigned long long seed) {
+    int travelTime = config->linkTravelTime;
+    net->count = count;
+    net->nodes = (Intersection*)malloc(sizeof(Intersection) * count);
+    net->pools = (MemoryPool*)malloc(sizeof(MemoryPool) * count);
+    net->exits = malloc(sizeof(*net->exits) * count);
+    net->upstream = malloc(sizeof(*net->upstream) * count);
+    net->upstreamExit = malloc(sizeof(*net->upstreamExit) * count);
+    net->clock = 0;
+    net->demand = NULL;
+    net->replay = NULL;
+    net->viewer = NULL;
+    net->viewCapture = 0;
+    for (int i = 0; i < count; i++) {
+        initPool(&net->pools[i], sizeof(Vehicule), VEHICLE_POOL_CHUNK);
+        initIntersection(&net->nodes[i], i + 1, config, seed, &net->pools[i], NULL, NULL);
+        net->nodes[i].spillback = 1;
+        net->nodes[i].nextVehicleId = i + 1;
+        net->nodes[i].vehicleIdStride = count;
+        for (int d = 0; d < 4; d++) {
+            net->exits[i][d].target = -1;
+            net->exits[i][d].approach = oppositeDirection((Direction)d);
+            net->exits[i][d].travelTime = travelTime;
+            net->exits[i][d].handoff.slots = NULL;
+            net->upstream[i][d] = -1;
+            net->upstreamExit[i][d] = oppositeDirection((Direction)d);
+        }
+    }
+    initLaneState(&net->lanes, count, config);
+    for (int i = 0; i < count; i++) {
+        bindLaneState(&net->nodes[i], &net->lanes, i);
+    }
+}
+
+// Relie la sortie "dir" de l'intersection "from" a l'approche "approach" de l'intersection "to"
+void connectRoad(RoadNetwork* net, int from, Direction dir, int to, Direction approach, int travelTime) {
+    RoadLink* link = &net->exits[from][dir];
+    link->target = to;
+    link->approach = approach;
+    link->travelTime = travelTime;
+    if (link->handoff.slots == NULL) {
+        initSpscRing(&link->handoff, HANDOFF_CAPACITY);
+    }
+    net->upstream[to][approach] = from;
+    net->upstreamExit[to][approach] = dir;
+}
+
+// Relie la sortie "dir" de l'intersection "from" a l'approche opposee de l'intersection "to"
+void connectIntersections(RoadNetwork* net, int from, Direction dir, int to, int travelTime) {
+    connectRoad(net, from, dir, to, oppositeDirection(dir), travelTime);
+}
+
+// Construit un corridor Ouest-Est : chaque intersection est reliee a ses voisines Est et Ouest
+void buildCorridor(RoadNetwork* net, int count, const ScenarioConfig* config, unsigned long long seed) {
+    int travelTime = config->linkTravelTime;
+    createRoadNetwork(net, count, config, seed);
+    for (int i = 0; i + 1 < count; i++) {
+        connectIntersections(net, i, EAST, i + 1, travelTime);
+        connectIntersections(net, i + 1, WEST, i, travelTime);
+    }
+}
+
+// Construit le reseau des routes du graphe "g" (une intersection par noeud, memes numeros)
+void buildGraphNetwork(RoadNetwork* net, const RoadGraph* g, const ScenarioConfig* config, unsigned long long seed) {
+    createRoadNetwork(net, g->count, config, seed);
+    for (int i = 0; i < g->count; i++) {
+        for (int p = 0; p < 4; p++) {
+            if (g->neighbor[i][p] < 0) continue;
+            connectRoad(net, i, (Direction)p, g->neighbor[i][p], (Direction)g->approach[i][p], g->travel[i][p]);
+        }
+    }
+}
+
+// Remplace les arrivees aleatoires par les trajets de "od", guides par "routes" (tous deux restent
+// a l'appelant, qui les libere apres freeRoadNetwork)
+void attachRouting(RoadNetwork* net, const RouteTable* routes, const OdDemand* od) {
+    for (int i = 0; i < net->count; i++) {
+        net->nodes[i].routes = routes;
+        net->nodes[i].od = od;
+        net->nodes[i].node = i;
+    }
+}
+
+// Remplace les arrivees aleatoires de toutes les intersections par la demande enregistree "demand"
+// (le flux reste a l'appelant, qui le ferme apres freeRoadNetwork)
+void attachDemand(RoadNetwork* net, DemandStream* demand) {
+    net->demand = demand;
+    net->replay = (DemandBatch*)calloc(net->count, sizeof(DemandBatch));
+    for (int i = 0; i < net->count; i++) {
+        net->nodes[i].replay = &net->replay[i];
+    }
+}
+
+// Repartit les arrivees enregistrees du pas "now" (une seule lecture du flux pour tout le reseau)
+void stageNetworkDemand(RoadNetwork* net, unsigned long now) {
+    if (net->demand != NULL) stageDemand(net->demand, net->replay, net->count, now);
+}
+
+// Libere toutes les intersections du reseau, puis les pools de vehicules
+// (un vehicule a pu etre rendu au pool d'une autre intersection que celle qui l'a cree)
+void freeRoadNetwork(RoadNetwork* net) {
+    for (int i = 0; i < net->count; i++) {
+        freeIntersection(&net->nodes[i]);
+        for (int d = 0; d < 4; d++) {
+            freeSpscRing(&net->exits[i][d].handoff, &net->pools[i]);
+        }
+    }
+    for (int i = 0; i < net->count; i++) {
+        destroyPool(&net->pools[i]);
+    }
+    free(net->pools);
+    free(net->nodes);
+    free(net->exits);
+    free(net->upstream);
+    free(net->upstreamExit);
+    freeLaneState(&net->lanes);
+    if (net->replay != NULL) {
+        for (int i = 0; i < net->count; i++) {
+            free(net->replay[i].records);
+        }
+        free(net->replay);
+        net->replay = NULL;
+    }
+    net->nodes = NULL;
+    net->count = 0;
+}
+
+// Phase 1 d'un pas : l'intersection i fait entrer dans ses voies aller les vehicules
+// deposes par ses voisines dans les files de passage (cote consommateur)
+void ingestIncoming(RoadNetwork* net, int i, unsigned long now) {
+    Intersection* x = &net->nodes[i];
+    // Virages des vehicules entrants : un bloc par voie, tire en lot pour l'instant courant
+    RandomBlock turns[4];
+    randomLaneBlocks(&x->rng, now, RANDOM_REROUTE, 0, x->numLanes, turns);
+    for (int a = 0; a < x->numLanes; a++) {
+        int u = net->upstream[i][a];
+        if (u < 0) continue;
+        SpscRing* ring = &net->exits[u][net->upstreamExit[i][a]].handoff;
+        Queue* dst = x->lanes[a].aller;
+        unsigned int entered = 0;
+        while (!isFull(dst)) {
+            Vehicule* v = spscPop(ring);
+            if (v == NULL) break;
+            RandomBlock b = (entered < 4) ? turns[a] : randomDraw(&x->rng, now, a, RANDOM_REROUTE, entered / 4);
+            v->origin = (Direction)a;
+            v->turn = (v->destination != VEHICLE_NO_DESTINATION && x->routes != NULL)
+                    ? routedTurn(x, (Direction)a, v->destination)
+                    : (TurnDirection)randomBelow(b.v[entered % 4], 3);
+            entered++;
+            v->queueTime = (unsigned int)now;
+            enqueue(dst, v, NULL, NULL);
+            x->receivedVehicles++;
+            x->lastArrival[a] = now;
+        }
+        requestPreemption(x, a, now);
+        scheduleDischarge(x, a, now);
+    }
+}
+
+// Phase 2 d'un pas : evenements locaux de l'intersection i, puis depart des vehicules
+// arrives au bout de leur liaison (cote producteur)
+void advanceLocal(RoadNetwork* net, int i, unsigned long now) {
+    Intersection* x = &net->nodes[i];
+    advanceIntersection(x, now);
+    for (int d = 0; d < x->numLanes; d++) {
+        RoadLink* link = &net->exits[i][d];
+        Queue* src = x->lanes[d].retour;
+        unsigned long travel = (unsigned long)link->travelTime;
+        // La tete de la liaison bloque les suivants tant que la file de passage est pleine
+        while (!isEmpty(src) && (unsigned long)queueFront(src)->queueTime + travel <= now) {
+            if (queueFront(src)->destination == i) { // trajet termine
+                releaseVehicule(x->pool, dequeue(src, NULL));
+                x->arrivedVehicles++;
+            } else if (link->target < 0) {
+                releaseVehicule(x->pool, dequeue(src, NULL));
+                x->exitedVehicles++;
+            } else {
+                if (!spscPush(&link->handoff, queueFront(src))) break;
+                dequeue(src, NULL);
+            }
+        }
+    }
+}
+
+// Recopie les intersections [first, last) dans l'image en preparation (pas selectionne par viewCapture)
+void captureNetworkView(RoadNetwork* net, int first, int last) {
+    ViewerFrame* frame = viewerBackFrame(net->viewer);
+    for (int i = first; i < last && i < VIEWER_MAX_ROWS; i++) {
+        captureViewerRow(frame, i, &net->nodes[i]);
+    }
+}
+
+// Avance le reseau d'un pas (execution sequentielle, reference du moteur parallele)
+void stepNetwork(RoadNetwork* net, unsigned long now) {
+    TRACE_BEGIN(ingest);
+    net->viewCapture = viewerWantsFrame(net->viewer);
+    stageNetworkDemand(net, now);
+    for (int i = 0; i < net->count; i++) {
+        ingestIncoming(net, i, now);
+    }
+    TRACE_END(ingest, "ingest");
+    TRACE_BEGIN(advance);
+    updateLaneState(&net->lanes, 0, net->count);
+    for (int i = 0; i < net->count; i++) {
+        advanceLocal(net, i, now);
+    }
+    TRACE_END(advance, "advance");
+    if (net->viewCapture) {
+        captureNetworkView(net, 0, net->count);
+        viewerPublish(net->viewer, now);
+    }
+    net->clock = now;
+}
+
+// Totaux du reseau : vehicules sortis, transferes et passages bloques
+void networkTotals(RoadNetwork* net, unsigned long* exited, unsigned long* received, unsigned long* blocked) {
+    *exited = *received = *blocked = 0;
+    for (int i = 0; i < net->count; i++) {
+        *exited += net->nodes[i].exitedVehicles;
+        *received += net->nodes[i].receivedVehicles;
+        *blocked += net->nodes[i].blockedDischarges;
+    }
+}
+
+// Empreinte de l'etat du reseau (contenu des files et compteurs) pour comparer deux executions
+unsigned long long networkFingerprint(RoadNetwork* net) {
+    unsigned long long h = 1469598103934665603ULL; // FNV-1a
+    for (int i = 0; i < net->count; i++) {
+        Intersection* x = &net->nodes[i];
+        for (int d = 0; d < x->numLanes; d++) {
+            Queue* queues[] = {x->lanes[d].aller, x->lanes[d].retour};
+            for (int k = 0; k < 2; k++) {
+                for (int n = 0; n < queues[k]->size; n++) {
+                    h = (h ^ (unsigned long long)queueAt(queues[k], n)->id) * 1099511628211ULL;
+                }
+                h = (h ^ (unsigned long long)queues[k]->size) * 1099511628211ULL;
+            }
+        }
+        h = (h ^ x->exitedVehicles) * 1099511628211ULL;
+        h = (h ^ x->receivedVehicles) * 1099511628211ULL;
+        h = (h ^ x->blockedDischarges) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// Memoire reservee par les pools de vehicules et nombre de vehicules vivants
+void networkPoolUsage(RoadNetwork* net, size_t* bytes, long* liveVehicles) {
+    *bytes = 0;
+    *liveVehicles = 0;
+    for (int i = 0; i < net->count; i++) {
+        *bytes += poolBytes(&net->pools[i]);
+        *liveVehicles += net->pools[i].liveItems;
+    }
+}
+
+// Affiche l'occupation de chaque intersection (voies aller et retour)
+void printNetworkStatus(RoadNetwork* net) {
+    unsigned long exited, received, blocked;
+    networkTotals(net, &exited, &received, &blocked);
+    printf("\n---\nReseau a t=%lu (sortis: %lu, transferes: %lu, bloques: %lu)\n",
+           net->clock, exited, received, blocked);
+    for (int i = 0; i < net->count; i++) {
+        Intersection* x = &net->nodes[i];
+        printf("Intersection %3d | Aller N:%d S:%d E:%d O:%d | Retour N:%d S:%d E:%d O:%d | Bloques: %lu\n",
+               x->id,
+               x->lanes[NORTH].aller->size, x->lanes[SOUTH].aller->size,
+               x->lanes[EAST].aller->size, x->lanes[WEST].aller->size,
+               x->lanes[NORTH].retour->size, x->lanes[SOUTH].retour->size,
+               x->lanes[EAST].retour->size, x->lanes[WEST].retour->size,
+               x->blockedDischarges);
+    }
+}
+
+#endif // NETWORK_H
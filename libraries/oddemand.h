@@ -0,0 +1,168 @@
+#ifndef ODDEMAND_H
+#define ODDEMAND_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "roadgraph.h"
+#include "random.h"
+
+/* --- Demande origine-destination par zones (modele gravitaire) --- */
+// Les intersections sont groupees en zones carrees de OD_ZONE_SIZE intersections de cote
+// (agrandies si besoin pour rester sous OD_MAX_ZONES). Le nombre de trajets d'une zone vers une
+// autre est proportionnel au produit de leurs tailles et decroit avec la distance entre leurs
+// centres : exp(-distance / OD_DISTANCE_DECAY) (0 : demande uniforme).
+// Chaque intersection tire une arrivee par pas avec une probabilite proportionnelle aux trajets
+// partant de sa zone ; la moyenne sur le reseau vaut VEHICLE_GEN_PROB. La destination est tiree
+// dans la ligne cumulee de la zone, puis uniformement parmi les intersections de la zone choisie.
+
+typedef struct {
+    int zones;
+    int* zoneOf;                     // Zone de chaque intersection
+    int* zoneStart;                  // Intersections de la zone z : zoneNodes[zoneStart[z] .. zoneStart[z + 1])
+    int* zoneNodes;
+    unsigned int* destinationCdf;    // [origine * zones + destination] : cumul sur 2^32
+    unsigned int* arrivalThreshold;  // Par intersection : arrivee si le tirage est en dessous
+    const int* component;            // Composantes connexes du graphe (trajets possibles)
+    double tripsPerHour;             // Demande totale du reseau
+} OdDemand;
+
+// Construit la demande du graphe "g" pour le scenario "config". Retourne 0 si la memoire manque
+int buildOdDemand(OdDemand* od, const RoadGraph* g, const ScenarioConfig* config) {
+    memset(od, 0, sizeof(*od));
+    int count = g->count;
+    float minX = g->x[0], maxX = g->x[0], minY = g->y[0], maxY = g->y[0];
+    for (int i = 1; i < count; i++) {
+        if (g->x[i] < minX) minX = g->x[i];
+        if (g->x[i] > maxX) maxX = g->x[i];
+        if (g->y[i] < minY) minY = g->y[i];
+        if (g->y[i] > maxY) maxY = g->y[i];
+    }
+    // Cote des zones : OD_ZONE_SIZE, double tant que la matrice depasserait OD_MAX_ZONES zones
+    int side = config->odZoneSize, zonesX, zonesY;
+    while (1) {
+        zonesX = (int)((maxX - minX) / (float)side) + 1;
+        zonesY = (int)((maxY - minY) / (float)side) + 1;
+        if ((long long)zonesX * zonesY <= OD_MAX_ZONES) break;
+        side *= 2;
+    }
+    int zones = od->zones = zonesX * zonesY;
+    od->zoneOf = (int*)malloc(sizeof(int) * count);
+    od->zoneStart = (int*)calloc((size_t)zones + 1, sizeof(int));
+    od->zoneNodes = (int*)malloc(sizeof(int) * count);
+    od->destinationCdf = (unsigned int*)malloc(sizeof(unsigned int) * (size_t)zones * zones);
+    od->arrivalThreshold = (unsigned int*)malloc(sizeof(unsigned int) * count);
+    double* centerX = (double*)calloc(zones, sizeof(double));
+    double* centerY = (double*)calloc(zones, sizeof(double));
+    double* weight = (double*)malloc(sizeof(double) * zones);
+    double* outgoing = (double*)malloc(sizeof(double) * zones);
+    if (!od->zoneOf || !od->zoneStart || !od->zoneNodes || !od->destinationCdf || !od->arrivalThreshold
+        || !centerX || !centerY || !weight || !outgoing) {
+        free(centerX);
+        free(centerY);
+        free(weight);
+        free(outgoing);
+        return 0;
+    }
+    od->component = g->component;
+
+    // Zones : intersections rangees par zone, centre de chaque zone
+    for (int i = 0; i < count; i++) {
+        int zx = (int)((g->x[i] - minX) / (float)side);
+        int zy = (int)((g->y[i] - minY) / (float)side);
+        int z = od->zoneOf[i] = zy * zonesX + zx;
+        od->zoneStart[z + 1]++;
+        centerX[z] += g->x[i];
+        centerY[z] += g->y[i];
+    }
+    for (int z = 0; z < zones; z++) {
+        int size = od->zoneStart[z + 1];
+        if (size > 0) {
+            centerX[z] /= size;
+            centerY[z] /= size;
+        }
+        od->zoneStart[z + 1] += od->zoneStart[z];
+    }
+    int* fill = (int*)malloc(sizeof(int) * zones);
+    memcpy(fill, od->zoneStart, sizeof(int) * zones);
+    for (int i = 0; i < count; i++) od->zoneNodes[fill[od->zoneOf[i]]++] = i;
+    free(fill);
+
+    // Matrice gravitaire : ligne cumulee de chaque zone d'origine
+    double decay = config->odDistanceDecay;
+    double total = 0.0;
+    for (int o = 0; o < zones; o++) {
+        double po = od->zoneStart[o + 1] - od->zoneStart[o];
+        double sum = 0.0;
+        for (int d = 0; d < zones; d++) {
+            double pd = od->zoneStart[d + 1] - od->zoneStart[d];
+            if (d == o) pd -= 1.0; // pas de trajet d'une intersection vers elle-meme
+            double w = (po > 0.0 && pd > 0.0) ? po * pd : 0.0;
+            if (w > 0.0 && decay > 0.0) {
+                double distance = fabs(centerX[o] - centerX[d]) + fabs(centerY[o] - centerY[d]);
+                w *= exp(-distance / decay);
+            }
+            weight[d] = w;
+            sum += w;
+        }
+        double cumulative = 0.0;
+        int last = zones - 1; // derniere zone possible : son cumul est le maximum exact
+        while (last > 0 && weight[last] == 0.0) last--;
+        for (int d = 0; d < zones; d++) {
+            cumulative += weight[d];
+            double share = (sum > 0.0) ? cumulative / sum : 0.0;
+            od->destinationCdf[(size_t)o * zones + d] = (d >= last && sum > 0.0)
+                ? UINT_MAX : (unsigned int)(share * 4294967295.0);
+        }
+        outgoing[o] = (po > 0.0) ? sum / po : 0.0; // par intersection de la zone
+        total += sum;
+    }
+
+    // Probabilite d'arrivee de chaque intersection : moyenne VEHICLE_GEN_PROB sur le reseau
+    double mean = (total > 0.0) ? total / count : 0.0;
+    double base = config->vehicleGenProb / 100.0;
+    od->tripsPerHour = 0.0;
+    for (int i = 0; i < count; i++) {
+        double p = (mean > 0.0) ? base * outgoing[od->zoneOf[i]] / mean : 0.0;
+        if (p > 1.0) p = 1.0;
+        od->arrivalThreshold[i] = (unsigned int)(p * 4294967295.0);
+        od->tripsPerHour += p * 3600.0 / TIME_INCREMENT;
+    }
+    free(centerX);
+    free(centerY);
+    free(weight);
+    free(outgoing);
+    return 1;
+}
+
+void freeOdDemand(OdDemand* od) {
+    free(od->zoneOf);
+    free(od->zoneStart);
+    free(od->zoneNodes);
+    free(od->destinationCdf);
+    free(od->arrivalThreshold);
+    memset(od, 0, sizeof(*od));
+}
+
+// Destination d'un trajet partant de "origin" (mots aleatoires "zoneWord" et "nodeWord")
+// Retourne -1 si aucune intersection de la zone tiree n'est joignable
+int sampleOdDestination(const OdDemand* od, int origin, unsigned int zoneWord, unsigned int nodeWord) {
+    const unsigned int* cdf = od->destinationCdf + (size_t)od->zoneOf[origin] * od->zones;
+    int low = 0, high = od->zones - 1;
+    while (low < high) { // premiere zone dont le cumul depasse le tirage
+        int mid = (low + high) / 2;
+        if (cdf[mid] > zoneWord) high = mid;
+        else low = mid + 1;
+    }
+    int first = od->zoneStart[low];
+    int size = od->zoneStart[low + 1] - first;
+    if (size == 0) return -1;
+    int k = randomBelow(nodeWord, size);
+    for (int tries = 0; tries < size; tries++) {
+        int node = od->zoneNodes[first + (k + tries) % size];
+        if (node != origin && od->component[node] == od->component[origin]) return node;
+    }
+    return -1;
+}
+
+#endif // ODDEMAND_H
@@ -0,0 +1,331 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "parallel.h"
+#include "montecarlo.h"
+#include "checkpoint.h"
+
+/* --- Optimisation des plans de feux d'un corridor --- */
+// Recherche locale par tours : a chaque tour, OPTIMIZER_CANDIDATES variantes du meilleur plan
+// (cycle commun, vert ou decalage d'un groupe d'intersections, onde verte) sont evaluees en
+// parallele. Le corridor n'est chauffe qu'une fois (OPTIMIZER_WARMUP secondes avec le controleur
+// du scenario) puis sauvegarde ; chaque evaluation repart de cette sauvegarde et simule
+// OPTIMIZER_HORIZON secondes en OPTIMIZER_SEGMENTS tranches. Apres chaque tranche, une variante
+// dont le retard depasse de plus de OPTIMIZER_PRUNE_MARGIN celui du meilleur plan au meme instant
+// est abandonnee. Les arrivees ne dependent que de la graine : toutes les variantes voient la meme
+// demande, et le plan retenu ne depend pas du nombre de threads.
+
+#define OPTIMIZER_RANDOM_STREAM 0xFFFFFFFFULL // Flux des variantes (distinct de ceux des intersections)
+
+// Plan de feux du corridor : un SignalTiming par intersection
+typedef struct {
+    int count;
+    SignalTiming* timings;
+} TimingPlan;
+
+// Score d'un plan : retard cumule a la fin de chaque tranche simulee
+typedef struct {
+    double delay[OPTIMIZER_SEGMENTS]; // Vehicules-secondes (penalites comprises)
+    unsigned long served;             // Vehicules passes au feu pendant l'evaluation
+    unsigned long refused;            // Vehicules refuses a l'entree ou perdus au feu
+    int segments;                     // Tranches simulees (OPTIMIZER_SEGMENTS : evaluation complete)
+} PlanScore;
+
+// Point de depart commun des evaluations
+typedef struct {
+    const ScenarioConfig* config;
+    const char* warmPath;   // Corridor chauffe
+    unsigned long start;    // Premier pas evalue
+} PlanEvaluator;
+
+// Travail d'un tour partage par les threads : "count" variantes comparees a "reference"
+typedef struct {
+    atomic_int next;             // Prochaine variante a evaluer
+    atomic_int failed;           // Un etat chauffe n'a pas pu etre relu : tour interrompu
+    int count;
+    const PlanEvaluator* evaluator;
+    const TimingPlan* candidates;
+    const PlanScore* reference;  // Score complet du meilleur plan (NULL : aucun abandon)
+    PlanScore* scores;
+} CandidateBatch;
+
+// Bilan de l'optimisation
+typedef struct {
+    PlanScore baseline;  // Controleur du scenario depuis l'etat chauffe
+    PlanScore initial;   // Plan de depart (BASE_GREEN_DURATION pour chaque phase, sans decalage)
+    PlanScore best;
+    int evaluated;       // Variantes evaluees
+    int pruned;          // Variantes abandonnees avant la fin de l'horizon
+    int improvements;    // Tours qui ont ameliore le plan
+} OptimizerReport;
+
+int allocTimingPlan(TimingPlan* plan, int count) {
+    plan->count = count;
+    plan->timings = (SignalTiming*)malloc(sizeof(SignalTiming) * count);
+    return plan->timings != NULL;
+}
+
+void freeTimingPlan(TimingPlan* plan) {
+    free(plan->timings);
+    plan->timings = NULL;
+    plan->count = 0;
+}
+
+void copyTimingPlan(TimingPlan* dst, const TimingPlan* src) {
+    memcpy(dst->timings, src->timings, sizeof(SignalTiming) * src->count);
+}
+
+// Ramene un plan d'intersection dans les bornes : cycle de 2 x OPTIMIZER_MIN_GREEN a "maxCycle",
+// au moins OPTIMIZER_MIN_GREEN de vert par phase, decalage dans le cycle
+void clampSignalTiming(SignalTiming* t, int maxCycle) {
+    if (t->cycle < 2 * OPTIMIZER_MIN_GREEN) t->cycle = 2 * OPTIMIZER_MIN_GREEN;
+    if (t->cycle > maxCycle) t->cycle = maxCycle;
+    if (t->green < OPTIMIZER_MIN_GREEN) t->green = OPTIMIZER_MIN_GREEN;
+    if (t->green > t->cycle - OPTIMIZER_MIN_GREEN) t->green = t->cycle - OPTIMIZER_MIN_GREEN;
+    t->offset %= t->cycle;
+    if (t->offset < 0) t->offset += t->cycle;
+}
+
+// Retard cumule du reseau : vehicules-secondes dans les files aller (echantillonnees a chaque pas),
+// plus OPTIMIZER_REFUSED_PENALTY par vehicule refuse a l'entree ou perdu au feu
+double networkDelay(RoadNetwork* net, unsigned long* served, unsigned long* refused) {
+    double queued = 0.0;
+    *served = *refused = 0;
+    for (int i = 0; i < net->count; i++) {
+        Intersection* x = &net->nodes[i];
+        *refused += x->rejectedArrivals;
+        for (int l = 0; l < 4; l++) {
+            const LaneMetrics* m = &x->metrics.lanes[l];
+            queued += (double)m->queueLength.sum * TIME_INCREMENT;
+            for (int t = 0; t < VEHICLE_TYPE_COUNT; t++) {
+                *served += m->served[t];
+                *refused += m->lost[t];
+            }
+        }
+    }
+    return queued + OPTIMIZER_REFUSED_PENALTY * (double)*refused;
+}
+
+// Simule "plan" (NULL : controleur du scenario) depuis l'etat chauffe ; abandonne des que le retard
+// depasse celui de "reference" (NULL : jamais) de plus de OPTIMIZER_PRUNE_MARGIN a la fin d'une tranche.
+// Retourne 0 si l'etat chauffe ne peut pas etre relu (ce n'est pas un abandon : "score" est vide)
+int evaluateTimingPlan(const PlanEvaluator* e, const TimingPlan* plan, const PlanScore* reference,
+                       PlanScore* score) {
+    TRACE_BEGIN(span);
+    memset(score, 0, sizeof(*score));
+    RoadNetwork net;
+    if (!loadNetworkCheckpoint(e->warmPath, &net, e->config)) return 0;
+    for (int i = 0; plan != NULL && i < net.count; i++) {
+        applySignalTiming(&net.nodes[i], &plan->timings[i], e->start);
+    }
+    unsigned long servedBefore, refusedBefore, served, refused;
+    double before = networkDelay(&net, &servedBefore, &refusedBefore);
+    unsigned long horizon = (unsigned long)e->config->optimizerHorizon;
+    for (int s = 0; s < OPTIMIZER_SEGMENTS; s++) {
+        unsigned long from = e->start + horizon * s / OPTIMIZER_SEGMENTS;
+        unsigned long to = e->start + horizon * (s + 1) / OPTIMIZER_SEGMENTS;
+        runNetworkParallel(&net, from, to, 1); // le parallelisme est entre les evaluations
+        score->delay[s] = networkDelay(&net, &served, &refused) - before;
+        score->served = served - servedBefore;
+        score->refused = refused - refusedBefore;
+        score->segments = s + 1;
+        if (reference != NULL && score->delay[s] > reference->delay[s] * (1.0 + OPTIMIZER_PRUNE_MARGIN)) break;
+    }
+    freeRoadNetwork(&net);
+    TRACE_END(span, "evaluation");
+    return 1;
+}
+
+// Boucle d'un thread : prend la prochaine variante libre jusqu'a epuisement ou echec d'une relecture
+void* candidateWorker(void* arg) {
+    CandidateBatch* batch = (CandidateBatch*)arg;
+    while (!atomic_load_explicit(&batch->failed, memory_order_relaxed)) {
+        int index = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+        if (index >= batch->count) break;
+        if (!evaluateTimingPlan(batch->evaluator, &batch->candidates[index], batch->reference,
+                                &batch->scores[index])) {
+            atomic_store_explicit(&batch->failed, 1, memory_order_relaxed);
+        }
+    }
+    TRACE_THREAD_EXIT();
+    return NULL;
+}
+
+// Evalue "count" variantes sur "threads" threads (le thread appelant en fait partie) ;
+// retourne 0 si l'etat chauffe n'a pas pu etre relu pour l'une d'elles
+int evaluateCandidates(const PlanEvaluator* e, const TimingPlan* candidates, int count,
+                       const PlanScore* reference, PlanScore* scores, int threads) {
+    if (threads > count) threads = count;
+    CandidateBatch batch;
+    atomic_init(&batch.next, 0);
+    atomic_init(&batch.failed, 0);
+    batch.count = count;
+    batch.evaluator = e;
+    batch.candidates = candidates;
+    batch.reference = reference;
+    batch.scores = scores;
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    for (int t = 1; t < threads; t++) {
+        pthread_create(&workers[t], NULL, candidateWorker, &batch);
+    }
+    candidateWorker(&batch);
+    for (int t = 1; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    free(workers);
+    return !atomic_load(&batch.failed);
+}
+
+// Variante "index" du tour "round" : un mouvement tire au hasard applique a une copie de "plan"
+//   0 : cycle commun allonge ou raccourci (verts et decalages mis a l'echelle)
+//   1 : vert Nord-Sud d'un groupe d'intersections voisines deplace
+//   2 : decalage d'un groupe d'intersections deplace
+//   3 : onde verte vers l'Est ou l'Ouest a la vitesse de LINK_TRAVEL_TIME
+void mutateTimingPlan(TimingPlan* out, const TimingPlan* plan, const SimRandom* rng, int round, int index,
+                      const ScenarioConfig* config) {
+    static const int steps[] = {-4, -2, -1, 1, 2, 4};
+    copyTimingPlan(out, plan);
+    RandomBlock r = randomDraw(rng, (unsigned long long)round, index, RANDOM_SEARCH, 0);
+    int n = out->count;
+    int delta = steps[randomBelow(r.v[1], 6)];
+    int first = randomBelow(r.v[2], n);
+    int last = first + 1 + randomBelow(r.v[3], (n + 3) / 4);
+    if (last > n) last = n;
+    switch (randomBelow(r.v[0], 4)) {
+        case 0:
+            for (int i = 0; i < n; i++) {
+                SignalTiming* t = &out->timings[i];
+                int cycle = t->cycle + delta;
+                if (cycle < 2 * OPTIMIZER_MIN_GREEN) cycle = 2 * OPTIMIZER_MIN_GREEN;
+                t->green = (t->green * cycle + t->cycle / 2) / t->cycle;
+                t->offset = t->offset * cycle / t->cycle;
+                t->cycle = cycle;
+            }
+            break;
+        case 1:
+            for (int i = first; i < last; i++) out->timings[i].green += delta;
+            break;
+        case 2:
+            for (int i = first; i < last; i++) out->timings[i].offset += delta;
+            break;
+        default: {
+            int eastbound = r.v[1] & 1;
+            int origin = out->timings[first].offset;
+            for (int i = 0; i < n; i++) {
+                int position = eastbound ? i - first : first - i;
+                out->timings[i].offset = origin + position * config->linkTravelTime;
+            }
+            break;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        clampSignalTiming(&out->timings[i], config->optimizerMaxCycle);
+    }
+}
+
+// Chauffe le corridor du scenario et le sauvegarde dans "warmPath" ; retourne 0 si l'ecriture echoue
+int warmCorridor(const ScenarioConfig* config, const char* warmPath, PlanEvaluator* e) {
+    RoadNetwork net;
+    buildCorridor(&net, config->networkSize, config, config->seed);
+    runNetworkParallel(&net, 0, (unsigned long)config->optimizerWarmup, config->networkThreads);
+    int saved = saveNetworkCheckpoint(warmPath, &net);
+    e->config = config;
+    e->warmPath = warmPath;
+    e->start = net.clock + TIME_INCREMENT;
+    freeRoadNetwork(&net);
+    return saved;
+}
+
+// Cherche le meilleur plan de feux du corridor de "config" ; "best" est alloue (a liberer) et
+// la progression est ecrite dans "progress" (NULL : aucune). Retourne 0 si l'etat chauffe ne peut
+// pas etre sauvegarde ou relu
+int optimizeSignalTiming(const ScenarioConfig* config, TimingPlan* best, OptimizerReport* report,
+                         FILE* progress) {
+    memset(report, 0, sizeof(*report));
+    PlanEvaluator e;
+    int count = config->networkSize;
+    int threads = (config->optimizerThreads > 0) ? config->optimizerThreads : availableCores();
+    if (!warmCorridor(config, OPTIMIZER_WARM_PATH, &e)) return 0;
+
+    // References : controleur du scenario, puis plan de depart
+    allocTimingPlan(best, count);
+    for (int i = 0; i < count; i++) {
+        SignalTiming t = {2 * config->baseGreenDuration, config->baseGreenDuration, 0};
+        clampSignalTiming(&t, config->optimizerMaxCycle);
+        best->timings[i] = t;
+    }
+    if (!evaluateTimingPlan(&e, NULL, NULL, &report->baseline) ||
+        !evaluateTimingPlan(&e, best, NULL, &report->initial)) {
+        freeTimingPlan(best);
+        remove(OPTIMIZER_WARM_PATH);
+        return 0;
+    }
+    report->best = report->initial;
+
+    int k = config->optimizerCandidates;
+    TimingPlan* candidates = (TimingPlan*)malloc(sizeof(TimingPlan) * k);
+    PlanScore* scores = (PlanScore*)malloc(sizeof(PlanScore) * k);
+    for (int c = 0; c < k; c++) allocTimingPlan(&candidates[c], count);
+    SimRandom rng;
+    seedRandom(&rng, config->seed, OPTIMIZER_RANDOM_STREAM);
+
+    int ok = 1;
+    for (int round = 0; round < config->optimizerRounds; round++) {
+        for (int c = 0; c < k; c++) {
+            mutateTimingPlan(&candidates[c], best, &rng, round, c, config);
+        }
+        if (!evaluateCandidates(&e, candidates, k, &report->best, scores, threads)) {
+            ok = 0; // une variante non relue n'est pas un abandon : la recherche s'arrete
+            break;
+        }
+        int winner = -1;
+        int pruned = 0;
+        for (int c = 0; c < k; c++) {
+            if (scores[c].segments < OPTIMIZER_SEGMENTS) {
+                pruned++;
+                continue;
+            }
+            double delay = scores[c].delay[OPTIMIZER_SEGMENTS - 1];
+            double bestDelay = (winner < 0) ? report->best.delay[OPTIMIZER_SEGMENTS - 1]
+                                            : scores[winner].delay[OPTIMIZER_SEGMENTS - 1];
+            if (delay < bestDelay) winner = c;
+        }
+        report->evaluated += k;
+        report->pruned += pruned;
+        if (winner >= 0) {
+            copyTimingPlan(best, &candidates[winner]);
+            report->best = scores[winner];
+            report->improvements++;
+        }
+        if (progress != NULL) {
+            fprintf(progress, "Tour %3d : retard %12.0f veh.s, %2d/%d variantes abandonnees%s\n", round + 1,
+                    report->best.delay[OPTIMIZER_SEGMENTS - 1], pruned, k, (winner >= 0) ? " (ameliore)" : "");
+        }
+    }
+
+    for (int c = 0; c < k; c++) freeTimingPlan(&candidates[c]);
+    free(candidates);
+    free(scores);
+    remove(OPTIMIZER_WARM_PATH);
+    if (!ok) freeTimingPlan(best);
+    return ok;
+}
+
+// Ecrit un plan en CSV : intersection,cycle,green_ns,offset (secondes)
+int writeTimingPlan(const char* path, const TimingPlan* plan) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) return 0;
+    fprintf(out, "intersection,cycle,green_ns,offset\n");
+    for (int i = 0; i < plan->count; i++) {
+        const SignalTiming* t = &plan->timings[i];
+        fprintf(out, "%d,%d,%d,%d\n", i, t->cycle, t->green, t->offset);
+    }
+    return fclose(out) == 0;
+}
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,125 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "network.h"
+
+/* --- Execution parallele d'un reseau partitionne entre plusieurs threads --- */
+
+// Barriere a attente active (puis cession du processeur) reutilisable a chaque pas
+typedef struct {
+    atomic_int remaining;  // Threads encore attendus pour la generation courante
+    atomic_int generation; // Incrementee quand tous les threads sont arrives
+    int parties;           // Nombre de threads synchronises
+} SpinBarrier;
+
+void initSpinBarrier(SpinBarrier* b, int parties) {
+    atomic_init(&b->remaining, parties);
+    atomic_init(&b->generation, 0);
+    b->parties = parties;
+}
+
+// Attend que tous les threads aient atteint la barriere
+void spinBarrierWait(SpinBarrier* b) {
+    int gen = atomic_load_explicit(&b->generation, memory_order_acquire);
+    if (atomic_fetch_sub_explicit(&b->remaining, 1, memory_order_acq_rel) == 1) {
+        atomic_store_explicit(&b->remaining, b->parties, memory_order_relaxed);
+        atomic_fetch_add_explicit(&b->generation, 1, memory_order_release);
+        return;
+    }
+    int spins = 0;
+    while (atomic_load_explicit(&b->generation, memory_order_acquire) == gen) {
+        if (++spins >= 256) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+// Bloc contigu d'intersections confie a un thread
+typedef struct {
+    RoadNetwork* net;
+    SpinBarrier* barrier;
+    int first;          // Premiere intersection du bloc
+    int last;           // Fin du bloc (exclue)
+    int leader;         // 1 pour un seul thread : taches communes du pas (demande, image)
+    unsigned long from; // Premier pas simule
+    unsigned long to;   // Fin de la simulation (exclue)
+} NetworkPartition;
+
+// Boucle d'un thread : les deux phases de chaque pas sont separees par une barriere,
+// si bien que les files de passage sont vues dans le meme etat quel que soit le decoupage
+void* runPartition(void* arg) {
+    NetworkPartition* p = (NetworkPartition*)arg;
+    for (unsigned long t = p->from; t < p->to; t += TIME_INCREMENT) {
+        TRACE_BEGIN(ingest);
+        // Les arrivees enregistrees ne sont consommees qu'apres la barriere (phase 2) ; de meme,
+        // la demande d'image n'est lue qu'une fois par pas, pour tous les threads
+        if (p->leader) {
+            p->net->viewCapture = viewerWantsFrame(p->net->viewer);
+            stageNetworkDemand(p->net, t);
+        }
+        for (int i = p->first; i < p->last; i++) {
+            ingestIncoming(p->net, i, t);
+        }
+        TRACE_END(ingest, "ingest");
+        TRACE_BEGIN(wait);
+        spinBarrierWait(p->barrier);
+        TRACE_END(wait, "barrier");
+        TRACE_BEGIN(advance);
+        updateLaneState(&p->net->lanes, p->first, p->last);
+        for (int i = p->first; i < p->last; i++) {
+            advanceLocal(p->net, i, t);
+        }
+        if (p->net->viewCapture) captureNetworkView(p->net, p->first, p->last);
+        TRACE_END(advance, "advance");
+        TRACE_BEGIN(wait2);
+        spinBarrierWait(p->barrier);
+        TRACE_END(wait2, "barrier");
+        if (p->leader && p->net->viewCapture) viewerPublish(p->net->viewer, t);
+    }
+    TRACE_THREAD_EXIT();
+    return NULL;
+}
+
+// Simule les pas [from, to) en repartissant les intersections sur "threads" threads
+// Le resultat est identique a l'execution sequentielle (stepNetwork) pour la meme graine
+void runNetworkParallel(RoadNetwork* net, unsigned long from, unsigned long to, int threads) {
+    if (from >= to) return;
+    if (threads > net->count) threads = net->count;
+    if (threads <= 1) {
+        for (unsigned long t = from; t < to; t += TIME_INCREMENT) {
+            stepNetwork(net, t);
+        }
+        return;
+    }
+
+    SpinBarrier barrier;
+    initSpinBarrier(&barrier, threads);
+    NetworkPartition* parts = (NetworkPartition*)malloc(sizeof(NetworkPartition) * threads);
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    for (int p = 0; p < threads; p++) {
+        parts[p].net = net;
+        parts[p].barrier = &barrier;
+        // Bornes alignees sur les blocs de l'etat des voies (un bloc n'est traite que par un thread)
+        parts[p].first = alignLaneBlock((int)((long long)net->count * p / threads), net->count);
+        parts[p].last = alignLaneBlock((int)((long long)net->count * (p + 1) / threads), net->count);
+        parts[p].leader = (p == 0); // l'alignement peut donner plusieurs blocs commencant a 0
+        parts[p].from = from;
+        parts[p].to = to;
+    }
+    for (int p = 1; p < threads; p++) {
+        pthread_create(&workers[p], NULL, runPartition, &parts[p]);
+    }
+    runPartition(&parts[0]); // le thread appelant traite le premier bloc
+    for (int p = 1; p < threads; p++) {
+        pthread_join(workers[p], NULL);
+    }
+    free(workers);
+    free(parts);
+    net->clock = to - TIME_INCREMENT;
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,89 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdlib.h>
+
+/* --- Pool memoire : allocation par blocs et liste libre d'elements de taille fixe --- */
+
+// Bloc alloue d'un seul malloc, suivi de "itemsPerChunk" elements
+typedef struct PoolChunk {
+    struct PoolChunk* next;
+} PoolChunk;
+
+// Pool d'elements de meme taille ; les elements liberes sont reutilises en priorite
+// Un element peut etre rendu a un autre pool de meme taille : les blocs ne sont
+// liberes qu'a la destruction de tous les pools qui les partagent
+typedef struct {
+    size_t itemSize;      // Taille d'un element (au moins celle d'un pointeur)
+    int itemsPerChunk;    // Nombre d'elements par bloc
+    void* freeList;       // Elements libres (chaines par leur premier mot)
+    PoolChunk* chunks;    // Blocs alloues par ce pool
+    long liveItems;       // Elements actuellement utilises
+    long peakItems;       // Maximum d'elements utilises simultanement
+    long chunkCount;      // Nombre de blocs alloues (un malloc chacun)
+} MemoryPool;
+
+// Initialise un pool vide
+void initPool(MemoryPool* p, size_t itemSize, int itemsPerChunk) {
+    if (itemSize < sizeof(void*)) itemSize = sizeof(void*);
+    p->itemSize = (itemSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    p->itemsPerChunk = itemsPerChunk;
+    p->freeList = NULL;
+    p->chunks = NULL;
+    p->liveItems = 0;
+    p->peakItems = 0;
+    p->chunkCount = 0;
+}
+
+// Alloue un nouveau bloc et chaine ses elements dans la liste libre
+int growPool(MemoryPool* p) {
+    size_t header = (sizeof(PoolChunk) + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    PoolChunk* chunk = (PoolChunk*)malloc(header + p->itemSize * p->itemsPerChunk);
+    if (chunk == NULL) return 0;
+    chunk->next = p->chunks;
+    p->chunks = chunk;
+    p->chunkCount++;
+    char* items = (char*)chunk + header;
+    for (int i = p->itemsPerChunk - 1; i >= 0; i--) {
+        void* item = items + p->itemSize * i;
+        *(void**)item = p->freeList;
+        p->freeList = item;
+    }
+    return 1;
+}
+
+// Retourne un element libre (NULL si la memoire est epuisee)
+void* poolAlloc(MemoryPool* p) {
+    if (p->freeList == NULL && !growPool(p)) return NULL;
+    void* item = p->freeList;
+    p->freeList = *(void**)item;
+    if (++p->liveItems > p->peakItems) p->peakItems = p->liveItems;
+    return item;
+}
+
+// Rend un element au pool
+void poolFree(MemoryPool* p, void* item) {
+    *(void**)item = p->freeList;
+    p->freeList = item;
+    p->liveItems--;
+}
+
+// Octets reserves par le pool (blocs entiers)
+size_t poolBytes(MemoryPool* p) {
+    size_t header = (sizeof(PoolChunk) + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    return (size_t)p->chunkCount * (header + p->itemSize * p->itemsPerChunk);
+}
+
+// Libere tous les blocs du pool (les elements ne doivent plus etre utilises)
+void destroyPool(MemoryPool* p) {
+    while (p->chunks != NULL) {
+        PoolChunk* next = p->chunks->next;
+        free(p->chunks);
+        p->chunks = next;
+    }
+    p->freeList = NULL;
+    p->liveItems = 0;
+    p->chunkCount = 0;
+}
+
+#endif // POOL_H
@@ -1,9 +1,19 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
 #include <string.h>
 #include "config.h"
+#include "scenario.h"
+#include "random.h"
+#include "pool.h"
+#include "historystore.h"
+#include "historyretention.h"
+#include "trafficlog.h"
+#include "metrics.h"
 
 /* --- Declarations des enumerations --- */
 
@@ -34,18 +44,30 @@ NORTH_SOUTH_GREEN, // Phase où les feux Nord-Sud sont verts
 EAST_WEST_GREEN    // Phase où les feux Est-Ouest sont verts
 } TrafficLightPhase;
 
+// Bilan d'un etage de passage au feu (processQueue)
+typedef struct {
+int moved;   // Vehicules passes dans une voie de retour
+int lost;    // Vehicules perdus (voie de retour pleine) ou invalides
+int blocked; // 1 si la tete attend une place dans sa voie de retour (remontee de file)
+} DischargeResult;
+
 /* --- Declaration des structures --- */
 
-// Structure representant un vehicule dans la simulation
+// Structure representant un vehicule dans la simulation (16 octets, allouee dans un pool ; un octet de
+// bourrage apres les champs de bits, remis a zero a la creation pour des sauvegardes reproductibles)
+// Un vehicule n'appartient qu'a une file a la fois : l'historique en garde une copie (HistoryRecord)
 typedef struct Vehicule {
 int id;                     // Identifiant du vehicule
-VehiculeType type;          // Type de vehicule (voiture, bus, moto, urgence)
-time_t arrivalTime;         // Heure d'arrivee dans la file
-Direction origin;           // Direction d'origine du vehicule
-TurnDirection turn;         // Direction dans laquelle le vehicule va tourner
-struct Vehicule* next;      // Pointeur vers le vehicule suivant dans la file
+unsigned int arrivalTime;   // Pas d'arrivee dans la simulation (horloge virtuelle)
+unsigned int queueTime;     // Pas d'entree dans la file courante
+unsigned char type : 2;     // Type de vehicule (VehiculeType : voiture, bus, moto, urgence)
+unsigned char origin : 2;   // Direction d'origine du vehicule (Direction)
+unsigned char turn : 2;     // Direction dans laquelle le vehicule va tourner (TurnDirection)
+unsigned short destination; // Intersection visee dans un reseau route (VEHICLE_NO_DESTINATION : virages au hasard)
 } Vehicule;
 
+#define VEHICLE_NO_DESTINATION 0xFFFF
+
 // Structure pour stocker les durees des feux (vert et rouge)
 typedef struct {
 int greenDuration;
@@ -53,10 +75,11 @@ int redDuration;
 } LightDurations;
 
 // Structure representant une file d'attente pour les vehicules d'une direction donnee
+// Les vehicules sont ranges dans un anneau contigu de Maxcapacity cases
 typedef struct Queue {
 int id;                         // Identifiant de la file
-Vehicule* first;                // Premier vehicule dans la file
-Vehicule* last;                 // Dernier vehicule dans la file
+Vehicule** slots;               // Anneau des vehicules (Maxcapacity cases)
+int head;                       // Case du premier vehicule dans l'anneau
 int size;                       // Nombre de vehicules dans la file
 int Maxcapacity;                // Capacite maximale de la file
 TrafficLightState lightState;   // etat actuel du feu pour cette file (VERT/ROUGE)
@@ -65,6 +88,14 @@ int baseGreenDuration;          // Duree de base pour le feu vert
 int baseRedDuration;            // Duree de base pour le feu rouge
 int currentGreenDuration;       // Duree actuelle du feu vert (peut être ajustee)
 int currentRedDuration;         // Duree actuelle du feu rouge (peut être ajustee)
+int* sizeMirror;                // Copie de "size" tenue a jour (case d'un LaneState, sinon "size" lui-meme)
+MemoryPool* pool;               // Pool des vehicules de la file (NULL : malloc/free)
+const ScenarioConfig* config;   // Parametres du scenario (seuil d'embouteillage, ajustements des feux)
+int isReturn;                   // 1 : file de retour (identifie la file dans le journal)
+unsigned int version;           // Incremente a chaque ajout, retrait ou changement de feu
+unsigned int loggedVersion;     // Version vue par le dernier logQueueState
+int loggedFlags;                // Feu et embouteillage vus par le dernier logQueueState
+int loggedDurations;            // Durees vert/rouge vues par le dernier logQueueState
 } Queue;
 
 // Structure representant une voie composee de deux files : "aller" et "retour"
@@ -87,42 +118,61 @@ TrafficPhaseNode* front;
 TrafficPhaseNode* rear;
 } LLCircular;
 
-typedef struct TrafficHistoryNode {
-Vehicule* vehicule;
-struct TrafficHistoryNode* next;
-} TrafficHistoryNode;
-
 typedef struct {
-TrafficHistoryNode* top; // pointeur pour LIFO
+HistoryRetention recent; // Enregistrements recents et cumuls par minute et par heure (memoire bornee)
+MemoryPool vehicles;     // Pool des vehicules de la simulation
+HistoryStore* store;     // Historique persistant sur disque (NULL : memoire seulement)
 } TrafficHistoryStack;
 
 /* --- Fonctions de creation et de gestion des structures --- */
 
-// Cree et initialise un vehicule avec les paramètres fournis
-Vehicule* createVehicule(int id, VehiculeType type, time_t arrivalTime, Direction origin, TurnDirection turn) {
-Vehicule* v = (Vehicule*)malloc(sizeof(Vehicule));
+// Cree et initialise un vehicule avec les paramètres fournis, dans le pool donne (NULL : malloc)
+Vehicule* createVehicule(MemoryPool* pool, int id, VehiculeType type, unsigned int arrivalTime, Direction origin, TurnDirection turn) {
+Vehicule* v = (pool != NULL) ? (Vehicule*)poolAlloc(pool) : (Vehicule*)malloc(sizeof(Vehicule));
+if (v == NULL) return NULL;
+memset(v, 0, sizeof(*v));
 v->id = id;
-v->type = type;
+v->type = (unsigned char)type;
 v->arrivalTime = arrivalTime;
-v->origin = origin;
-v->turn = turn;
-v->next = NULL;
+v->queueTime = arrivalTime;
+v->origin = (unsigned char)origin;
+v->turn = (unsigned char)turn;
+v->destination = VEHICLE_NO_DESTINATION;
 return v;
 }
 
+// Rend un vehicule sorti de sa file au pool (NULL : free)
+void releaseVehicule(MemoryPool* pool, Vehicule* v) {
+if (v == NULL) return;
+if (pool != NULL) {
+    poolFree(pool, v);
+} else {
+    free(v);
+}
+}
+
 // Cree et initialise une file d'attente avec la capacite maximale, un identifiant et une direction
 Queue* createQueue(int max, int id, Direction dir) {
 Queue* q = (Queue*)malloc(sizeof(Queue));
 q->id = id;
 q->direction = dir;
-q->first = q->last = NULL;
+q->slots = (Vehicule**)malloc(sizeof(Vehicule*) * (max > 0 ? max : 1));
+q->head = 0;
 q->size = 0;
+q->sizeMirror = &q->size;
 q->Maxcapacity = max;
 q->lightState = RED;
-q->baseGreenDuration = BASE_GREEN_DURATION;
-q->baseRedDuration = BASE_RED_DURATION;
+q->config = &activeScenario;
+q->baseGreenDuration = q->config->baseGreenDuration;
+q->baseRedDuration = q->config->baseRedDuration;
 q->currentGreenDuration = q->baseGreenDuration;
 q->currentRedDuration = q->baseRedDuration;
+q->pool = NULL;
+q->isReturn = 0;
+q->version = 0;
+q->loggedVersion = ~0u; // rien n'a encore ete journalise
+q->loggedFlags = -1;
+q->loggedDurations = 0;
 return q;
 }
 
@@ -130,6 +180,25 @@ return q;
 void Createlane(lane* l, int max, int id, Direction dir) {
 l->aller = createQueue(max, id, dir);
 l->retour = createQueue(max, id, dir);
+l->retour->isReturn = 1;
+}
+
+// Libere une file et son anneau (les vehicules restants doivent avoir ete rendus)
+void freeQueue(Queue* q) {
+free(q->slots);
+free(q);
+}
+
+// Retourne le i-eme vehicule de la file (0 : tete), sans le retirer
+Vehicule* queueAt(Queue* q, int i) {
+int index = q->head + i;
+if (index >= q->Maxcapacity) index -= q->Maxcapacity;
+return q->slots[index];
+}
+
+// Retourne le vehicule de tete (NULL si la file est vide)
+Vehicule* queueFront(Queue* q) {
+return (q->size > 0) ? q->slots[q->head] : NULL;
 }
 
 // Verifie si la file est pleine
@@ -142,9 +211,9 @@ int isEmpty(Queue* q) {
 return q->size == 0; 
 }
 
-// Detecte un embouteillage si la taille de la file depasse un seuil (defini dans config.h)
+// Detecte un embouteillage si la taille de la file depasse un seuil (defini par le scenario)
 int detectTrafficJam(Queue* q) {
-return q->size >= q->Maxcapacity * TRAFFIC_JAM_THRESHOLD;
+return q->size >= q->Maxcapacity * q->config->trafficJamThreshold;
 }
 
 /* --- Ajustement des durees de feux --- */
@@ -153,8 +222,8 @@ return q->size >= q->Maxcapacity * TRAFFIC_JAM_THRESHOLD;
 LightDurations adjustLightDurationsForPair(Queue* q1, Queue* q2) {
 LightDurations durations;
 if (detectTrafficJam(q1) || detectTrafficJam(q2)) {
-    durations.greenDuration = q1->baseGreenDuration + GREEN_BOOST;
-    durations.redDuration = q1->baseRedDuration - RED_REDUCTION;
+    durations.greenDuration = q1->baseGreenDuration + q1->config->greenBoost;
+    durations.redDuration = q1->baseRedDuration - q1->config->redReduction;
 } else {
     durations.greenDuration = q1->baseGreenDuration;
     durations.redDuration = q1->baseRedDuration;
@@ -162,15 +231,35 @@ if (detectTrafficJam(q1) || detectTrafficJam(q2)) {
 return durations;
 }
 
+/* --- Directions de sortie --- */
+
+// Retourne la direction opposee (cote d'arrivee chez l'intersection voisine)
+Direction oppositeDirection(Direction dir) {
+switch(dir) {
+    case NORTH: return SOUTH;
+    case SOUTH: return NORTH;
+    case EAST:  return WEST;
+    default:    return EAST;
+}
+}
+
+// Direction de sortie d'un vehicule venant de "origin" selon son virage (circulation a droite)
+Direction exitDirection(Direction origin, TurnDirection turn) {
+Direction straight = oppositeDirection(origin);
+if (turn == STRAIGHT) return straight;
+switch(straight) {
+    case SOUTH: return (turn == RIGHT) ? WEST : EAST;
+    case NORTH: return (turn == RIGHT) ? EAST : WEST;
+    case WEST:  return (turn == RIGHT) ? NORTH : SOUTH;
+    default:    return (turn == RIGHT) ? SOUTH : NORTH;
+}
+}
+
 /* --- Fonctions de journalisation (log) --- */
 
-// Enregistre un message dans le fichier log avec un horodatage
-void logWithTimestamp(FILE* logFile, char* message) {
-time_t now = time(NULL);
-char timestamp[20];
-strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
-fprintf(logFile, "[%s] %s\n", timestamp, message);
-fflush(logFile);
+// Enregistre un message horodate dans le journal binaire (sans attendre le disque)
+void logWithTimestamp(TrafficLog* trafficLog, LogMessageCode message) {
+writeLogRecord(trafficLog, LOG_MESSAGE, message, 0, 0, 0, 0);
 }
 
 // Convertit une direction en chaîne de caractères
@@ -205,138 +294,239 @@ switch(turn) {
 }
 }
 
-// Journalise l'etat d'une file dans le fichier log
-void logQueueState(Queue* q, FILE* logFile,  char* phase) {
-char* lightState = (q->lightState == GREEN) ? "VERT" : "ROUGE";
-char* trafficJam = detectTrafficJam(q) ? "Oui" : "Non";
-fprintf(logFile, "\n=== File %s (%s) ===\n", dirToString(q->direction), phase);
-fprintf(logFile, "Taille: %d/%d | Feu: %s | Embouteillage: %s | Vert: %ds, Rouge: %ds\n",
-        q->size, q->Maxcapacity, lightState, trafficJam,
-        q->currentGreenDuration, q->currentRedDuration);
-Vehicule* current = q->first;
-while (current != NULL) {
-    fprintf(logFile, "Vehicule %d (Type: %s, Tourne: %s)\n",
-        current->id, typeToString(current->type), turnToString(current->turn));
-    current = current->next;
+// Drapeaux du journal decrivant l'etat courant de la file (LOG_FLAG_*)
+int queueLogFlags(Queue* q) {
+return (q->lightState == GREEN ? LOG_FLAG_GREEN : 0) | (detectTrafficJam(q) ? LOG_FLAG_JAM : 0)
+     | (q->isReturn ? LOG_FLAG_RETURN : 0);
 }
-logWithTimestamp(logFile, "------------------------");
+
+// Durees courantes des feux de la file, regroupees dans un entier (vert << 16 | rouge)
+int queueLogDurations(Queue* q) {
+return (q->currentGreenDuration << 16) | (q->currentRedDuration & 0xFFFF);
+}
+
+// Journalise l'etat d'une file a la fin d'un pas
+// Avec "keyframe", la file est decrite entierement (image cle) ; sinon, les ajouts et retraits
+// ayant deja ete journalises par enqueue/dequeue, il ne reste a signaler qu'un changement de feu,
+// d'embouteillage ou de durees, et rien du tout si la file n'a pas change (meme version)
+void logQueueState(Queue* q, TrafficLog* trafficLog, int keyframe) {
+if (trafficLog == NULL) return;
+if (!keyframe && q->version == q->loggedVersion) return;
+int flags = queueLogFlags(q);
+int durations = queueLogDurations(q);
+q->loggedVersion = q->version;
+if (keyframe) {
+    writeLogRecord(trafficLog, LOG_QUEUE_STATE, q->direction, q->size, q->Maxcapacity, flags, durations);
+    for (int i = 0; i < q->size; i++) {
+        Vehicule* current = queueAt(q, i);
+        writeLogRecord(trafficLog, LOG_QUEUE_VEHICLE, q->direction, current->id, current->type, current->turn, 0);
+    }
+    logWithTimestamp(trafficLog, MSG_SEPARATOR);
+} else if (flags != q->loggedFlags || durations != q->loggedDurations) {
+    writeLogRecord(trafficLog, LOG_QUEUE_SIGNAL, q->direction, q->size, 0, durations, flags);
+}
+q->loggedFlags = flags;
+q->loggedDurations = durations;
 }
 
 /* --- Fonctions de gestion des files --- */
 
-// Ajoute un vehicule dans la file d'historique du trafic
-void pushToTrafficHistory(TrafficHistoryStack* history, Vehicule* v) { // urgence ne sont pas add 
-    if (v == NULL) {
-        printf("[ERREUR] Vehicule NULL passe à l'historique.\n");
-        return;
-    }
+// Enregistrement d'historique d'un vehicule entrant dans une file
+HistoryRecord vehicleHistoryRecord(const Vehicule* v) {
+    HistoryRecord record = { v->id, v->queueTime, v->arrivalTime, v->type, v->origin, v->turn, 0 };
+    return record;
+}
 
-    TrafficHistoryNode* newNode = (TrafficHistoryNode*)malloc(sizeof(TrafficHistoryNode));
-    if (newNode == NULL) {
-        printf("[ERREUR] Memoire insuffisante pour le nœud d'historique.\n");
-        return;
+// Enregistre un vehicule dans l'historique persistant (y compris les urgences)
+void storeHistoryRecord(TrafficHistoryStack* history, Vehicule* v) {
+    if (history->store == NULL) return;
+    HistoryRecord record = vehicleHistoryRecord(v);
+    if (!appendHistoryRecord(history->store, &record)) {
+        printf("[ERREUR] Ecriture impossible dans l'historique persistant.\n");
     }
+}
 
-    newNode->vehicule = (Vehicule*)malloc(sizeof(Vehicule));
-    if (newNode->vehicule == NULL) {
-        printf("[ERREUR] Memoire insuffisante pour le vehicule dans l'historique.\n");
-        free(newNode);
+// Ajoute un vehicule dans l'historique du trafic (copie de 16 octets : le vehicule n'est pas retenu)
+// Au-dela de la memoire fixee, les plus anciens ne sont plus gardes que dans les cumuls
+void pushToTrafficHistory(TrafficHistoryStack* history, Vehicule* v) { // urgence ne sont pas add 
+    if (v == NULL) {
+        printf("[ERREUR] Vehicule NULL passe à l'historique.\n");
         return;
     }
-
-    // Deep copy the vehicle data
-    memcpy(newNode->vehicule, v, sizeof(Vehicule));
-    newNode->next = history->top;
-    history->top = newNode;
+    HistoryRecord record = vehicleHistoryRecord(v);
+    retainHistoryRecord(&history->recent, &record);
+    storeHistoryRecord(history, v);
 }
 
 
 // Ajoute un vehicule dans la file
-// Les vehicules d'urgence sont ajoutes en tête de file
-void enqueue(Queue* q, Vehicule* v, FILE* logFile,TrafficHistoryStack *history) {
+// Les vehicules d'urgence sont ajoutes en tête de file, dans la limite de la capacite
+// Retourne 1 si le vehicule a ete ajoute, 0 sinon (le vehicule reste a la charge de l'appelant)
+int enqueue(Queue* q, Vehicule* v, TrafficLog* trafficLog,TrafficHistoryStack *history) {
     if (v == NULL) {
-        logWithTimestamp(logFile, "ERREUR: Tentative d'ajouter un vehicule NULL");
-        return;
-    }
-    if (v->type == Emergency) {
-        v->next = q->first;
-        q->first = v;
-        if (q->last == NULL) {
-            q->last = v;
-        }
-        q->size++;
-        return;
+        logWithTimestamp(trafficLog, MSG_NULL_VEHICLE);
+        return 0;
     }
     if (isFull(q)) {
-        logWithTimestamp(logFile, "ERREUR: File pleine!");
-        return;
+        logWithTimestamp(trafficLog, MSG_QUEUE_FULL);
+        return 0;
     }
-    if (q->first == NULL) {
-        q->first = v;
-    } else {
-        q->last->next = v;
+    if (v->type == Emergency) {
+        q->head = (q->head == 0) ? q->Maxcapacity - 1 : q->head - 1;
+        q->slots[q->head] = v;
+        q->size++;
+        *q->sizeMirror = q->size;
+        q->version++;
+        writeLogRecord(trafficLog, LOG_QUEUE_ADDED, q->direction, v->id, v->type, v->turn,
+                       LOG_FLAG_FRONT | (q->isReturn ? LOG_FLAG_RETURN : 0));
+        if (history != NULL) {
+            storeHistoryRecord(history, v); // pas dans la pile, mais conserve sur disque
+        }
+        return 1;
     }
-    q->last = v;
+    int tail = q->head + q->size;
+    if (tail >= q->Maxcapacity) tail -= q->Maxcapacity;
+    q->slots[tail] = v;
     q->size++;
-    pushToTrafficHistory(history, v); 
+    *q->sizeMirror = q->size;
+    q->version++;
+    writeLogRecord(trafficLog, LOG_QUEUE_ADDED, q->direction, v->id, v->type, v->turn,
+                   q->isReturn ? LOG_FLAG_RETURN : 0);
+    if (history != NULL) {
+        pushToTrafficHistory(history, v);
+    }
+    return 1;
 }
 
 // Retire le premier vehicule de la file et le retourne
-Vehicule* dequeue(Queue* q, FILE* logFile) {
+Vehicule* dequeue(Queue* q, TrafficLog* trafficLog) {
     if (isEmpty(q)) {
-        logWithTimestamp(logFile, "ERREUR: File vide!");
+        logWithTimestamp(trafficLog, MSG_QUEUE_EMPTY);
         return NULL;
     }
-    Vehicule* v = q->first;
-    q->first = q->first->next;
+    Vehicule* v = q->slots[q->head];
+    q->head = (q->head + 1 == q->Maxcapacity) ? 0 : q->head + 1;
     q->size--;
-    if (q->first == NULL) {
-        q->last = NULL;
-    }
+    *q->sizeMirror = q->size;
+    q->version++;
+    writeLogRecord(trafficLog, LOG_QUEUE_REMOVED, q->direction, v->id, 1, 0, q->isReturn ? LOG_FLAG_RETURN : 0);
     return v;
 }
 
-/* --- Fonction de generation et de traitement des vehicules --- */ 
-int vehicleId = 1; // VARIABLE GLOBALE
+// Recopie "n" vehicules dans l'anneau a partir de la case "start" (deux segments au plus)
+void copyIntoRing(Queue* q, int start, Vehicule** vehicles, int n) {
+    int first = q->Maxcapacity - start;
+    if (first > n) first = n;
+    memcpy(&q->slots[start], vehicles, sizeof(Vehicule*) * (size_t)first);
+    memcpy(q->slots, vehicles + first, sizeof(Vehicule*) * (size_t)(n - first));
+}
 
-void generateRandomVehicle(Queue* queue, FILE* logFile, unsigned int simTime,TrafficHistoryStack *history) {
-    VehiculeType type;
-    if (rand() % 100 < EMERGENCY_CHANCE) {
-        type = Emergency;
-    } else {
-        VehiculeType types[] = {CAR, BUS, BIKE};
-        type = types[rand() % 3];
+// Retire d'un bloc les "n" premiers vehicules de la file (recopies dans "out", de la tete a la queue)
+// Retourne le nombre de vehicules retires
+int dequeueBatch(Queue* q, Vehicule** out, int n, TrafficLog* trafficLog) {
+    if (n > q->size) n = q->size;
+    if (n <= 0) return 0;
+    int first = q->Maxcapacity - q->head;
+    if (first > n) first = n;
+    memcpy(out, &q->slots[q->head], sizeof(Vehicule*) * (size_t)first);
+    memcpy(out + first, q->slots, sizeof(Vehicule*) * (size_t)(n - first));
+    q->head += n;
+    if (q->head >= q->Maxcapacity) q->head -= q->Maxcapacity;
+    q->size -= n;
+    *q->sizeMirror = q->size;
+    q->version++;
+    writeLogRecord(trafficLog, LOG_QUEUE_REMOVED, q->direction, out[0]->id, n, 0, q->isReturn ? LOG_FLAG_RETURN : 0);
+    return n;
+}
+
+// Ajoute d'un bloc "n" vehicules a la file, qui doit avoir la place : les suites de vehicules
+// ordinaires sont recopiees en queue, les urgences passent en tete (comme avec enqueue)
+void enqueueBatch(Queue* q, Vehicule** vehicles, int n, TrafficLog* trafficLog, TrafficHistoryStack* history) {
+    int run = 0; // debut de la suite de vehicules ordinaires en cours
+    for (int i = 0; i <= n; i++) {
+        if (i < n && vehicles[i]->type != Emergency) continue;
+        if (i > run) {
+            int tail = q->head + q->size;
+            if (tail >= q->Maxcapacity) tail -= q->Maxcapacity;
+            copyIntoRing(q, tail, vehicles + run, i - run);
+            q->size += i - run;
+        }
+        if (i < n) {
+            q->head = (q->head == 0) ? q->Maxcapacity - 1 : q->head - 1;
+            q->slots[q->head] = vehicles[i];
+            q->size++;
+        }
+        run = i + 1;
+    }
+    *q->sizeMirror = q->size;
+    q->version++;
+    for (int i = 0; i < n; i++) {
+        Vehicule* v = vehicles[i];
+        int front = (v->type == Emergency) ? LOG_FLAG_FRONT : 0;
+        writeLogRecord(trafficLog, LOG_QUEUE_ADDED, q->direction, v->id, v->type, v->turn,
+                       front | (q->isReturn ? LOG_FLAG_RETURN : 0));
+        if (history == NULL) continue;
+        if (front) storeHistoryRecord(history, v);
+        else pushToTrafficHistory(history, v);
     }
+}
 
-    TurnDirection turn = rand() % 3;
+/* --- Fonction de generation et de traitement des vehicules --- */ 
+int consoleOutput = 1; // VARIABLE GLOBALE : affichage console de chaque vehicule (desactive en mode reseau)
 
+// Cree le vehicule "vehicleId" (a destination de "destination") et l'ajoute a la file s'il reste de la place
+// Retourne 1 si le vehicule a ete ajoute a la file, 0 sinon
+int admitVehicle(Queue* queue, TrafficLog* trafficLog, unsigned int simTime, TrafficHistoryStack* history,
+                 int vehicleId, VehiculeType type, TurnDirection turn, int destination) {
     if (!isFull(queue)) {
-        Vehicule* v = createVehicule(vehicleId, type, simTime, queue->direction, turn);
+        Vehicule* v = createVehicule(queue->pool, vehicleId, type, simTime, queue->direction, turn);
         if (v == NULL) {
-            fprintf(logFile, "Erreur: Impossible de creer le vehicule %d\n", vehicleId);
-            return; // Skip enqueue on failure
+            writeLogRecord(trafficLog, LOG_CREATE_FAILED, 0, vehicleId, 0, 0, 0);
+            return 0; // Skip enqueue on failure
+        }
+        v->destination = (unsigned short)destination;
+        enqueue(queue, v, trafficLog,history);
+        if (consoleOutput) {
+            printf("Vehicle Created in %s -> ID: %d | Type: %s\n", 
+                    dirToString(v->origin), vehicleId, typeToString(v->type));
         }
-        enqueue(queue, v, logFile,history);
-        printf("Vehicle Created in %s -> ID: %d | Type: %s\n", 
-                dirToString(v->origin), vehicleId, typeToString(v->type));
-        vehicleId++;
+        return 1;
     } else {
-        printf("Queue is full! Vehicle %d not added.\n", vehicleId);
+        if (consoleOutput) printf("Queue is full! Vehicle %d not added.\n", vehicleId);
     }
+    return 0;
+}
+
+// Type d'un vehicule cree, tire dans les deux premiers mots de "draw" (urgence, puis type)
+VehiculeType drawVehiculeType(RandomBlock draw, const ScenarioConfig* config) {
+    if (randomBelow(draw.v[0], 100) < config->emergencyChance) return Emergency;
+    VehiculeType types[] = {CAR, BUS, BIKE};
+    return types[randomBelow(draw.v[1], 3)];
+}
+
+// Genere un vehicule aleatoire d'identifiant "vehicleId" a partir du flux "rng" (tirage de l'instant "simTime")
+// Retourne 1 si le vehicule a ete ajoute a la file, 0 sinon
+int generateRandomVehicle(Queue* queue, TrafficLog* trafficLog, unsigned int simTime,TrafficHistoryStack *history, SimRandom* rng, int vehicleId) {
+    // Un seul bloc par (instant, voie) : urgence, type et virage
+    RandomBlock draw = randomDraw(rng, simTime, queue->direction, RANDOM_VEHICLE, 0);
+    VehiculeType type = drawVehiculeType(draw, queue->config);
+    TurnDirection turn = randomBelow(draw.v[2], 3);
+    return admitVehicle(queue, trafficLog, simTime, history, vehicleId, type, turn, VEHICLE_NO_DESTINATION);
 }
 
 
 /* --- Initialisation du fichier journal --- */
 
-// Ouvre (ou cree) le fichier journal et enregistre le debut de la simulation
-FILE* initializeLogFile() {
-    FILE* logFile = fopen("traffic_simulation.log", "w");
-    if (!logFile) {
+// Ouvre (ou cree) le journal binaire et enregistre le debut de la simulation
+// Le texte de traffic_simulation.log s'obtient avec tools/logdecode
+TrafficLog* initializeLogFile() {
+    TrafficLog* trafficLog = openTrafficLog(TRAFFIC_LOG_PATH, TRAFFIC_LOG_CAPACITY);
+    if (!trafficLog) {
         perror("Erreur creation fichier log");
         exit(EXIT_FAILURE);
     }
-    logWithTimestamp(logFile, "Debut simulation");
-    return logFile;
+    logWithTimestamp(trafficLog, MSG_SIMULATION_START);
+    return trafficLog;
 }
 
 // Initialise la queue circulaire
@@ -360,61 +550,119 @@ void enqueuePhase(LLCircular* q, TrafficLightPhase phase, int greenDuration, int
     }
 }
 
-// Dequeue et retourne la phase du Trafic light 
+// Passe a la phase suivante du Trafic light et la retourne
 TrafficPhaseNode* dequeuePhase(LLCircular* q) {
     if (q->front == NULL) return NULL;
 
-    TrafficPhaseNode* temp = q->front;
-    q->rear->next = q->front->next; // Move front forward
+    // Rotation de l'anneau : l'ancienne phase passe en queue (sans suppression pour maintenir le cycle)
+    q->rear = q->front;
     q->front = q->front->next;
 
-    return temp; // Return la pahse ancienne (sans suppression pour maintenir le cycle)
+    return q->front; // Return la nouvelle phase courante
 }
 
-// Initialisation de l'historique du systeme
-void initTrafficHistory(TrafficHistoryStack* history) {
-    history->top = NULL;
+// Initialisation de l'historique du systeme ("memoryBytes" : memoire de l'historique en memoire)
+void initTrafficHistory(TrafficHistoryStack* history, size_t memoryBytes) {
+    history->store = NULL;
+    initHistoryRetention(&history->recent, memoryBytes);
+    initPool(&history->vehicles, sizeof(Vehicule), VEHICLE_POOL_CHUNK);
 }
 
-// Fonction principale de la simulation
-void processQueue(Queue* q, FILE* logFile,TrafficHistoryStack *history, unsigned int* simTime, lane** lanes, int numLanes) {
-    if (q->lightState == GREEN && !isEmpty(q)) {
-        Vehicule* v = dequeue(q, logFile);
-        if (v == NULL) {
-            logWithTimestamp(logFile, "ERREUR: Dequeue a retourne NULL dans une file non vide");
-            return;
-        }
+// Intervalle de passage (dixiemes de seconde) d'un vehicule au debit de saturation
+int vehicleHeadway(const Vehicule* v, const ScenarioConfig* config) {
+    return config->headways[v->type];
+}
 
-        // Validation du data de la vehicule
-        if (v->id <= 0 || v->arrivalTime < 0) {
-            fprintf(logFile, "Donnees vehicule invalides: ID=%d, Temps=%d\n", v->id, v->arrivalTime);
-            free(v);
-            return;
+// Etage de passage d'une voie au vert (fonction principale de la simulation)
+// "credit" : temps de vert accumule par la voie (dixiemes de seconde), que chaque vehicule de tete
+// paie de son intervalle selon son type (bus plus lent, moto plus rapide) ; tous les vehicules
+// payes passent ensemble. La tete passe des que le credit est positif : l'intervalle qu'il ne
+// couvre pas est garde en dette (credit negatif) et retarde le suivant, si bien qu'un bus passe
+// meme quand un etage apporte moins que son intervalle (chaque vert sert au moins un vehicule).
+// Ils sont retires d'un bloc de la voie aller, puis ajoutes d'un bloc a chaque voie de retour
+// visee, dans la limite de sa place libre : sans place, le vehicule est perdu, ou bien avec
+// "spillback" la tete attend (remontee de file) et le lot s'arrete.
+// Le credit restant est garde pour l'etage suivant tant que des vehicules attendent leur tour ;
+// une dette est gardee meme si la voie se vide.
+// "metrics" (NULL : desactive) recoit l'attente dans la voie (depuis queueTime) et l'issue de
+// chaque vehicule, et le degagement des urgences
+DischargeResult processQueue(Queue* q, TrafficLog* trafficLog,TrafficHistoryStack *history, unsigned long simTime, lane** lanes, int numLanes, LaneMetrics* metrics, int* credit, int spillback) {
+    DischargeResult result = {0, 0, 0};
+    if (q->lightState != GREEN || isEmpty(q)) return result;
+
+    // Lot : vehicules de tete dont l'intervalle est paye et qui ont une place (ou sont perdus)
+    Vehicule* batch[DISCHARGE_BATCH_MAX];
+    signed char targets[DISCHARGE_BATCH_MAX]; // Voie de retour visee (-1 : perdu, -2 : invalide)
+    int reserved[4] = {0, 0, 0, 0};
+    int n = 0;
+    while (n < q->size && n < DISCHARGE_BATCH_MAX) {
+        Vehicule* v = queueAt(q, n);
+        int headway = vehicleHeadway(v, q->config);
+        if (*credit <= 0) break;
+        int exitIndex = exitDirection(q->direction, v->turn) % numLanes;
+        Queue* targetRetour = lanes[exitIndex]->retour;
+        if (v->id <= 0) {
+            targets[n] = -2;
+        } else if (targetRetour->size + reserved[exitIndex] < targetRetour->Maxcapacity) {
+            targets[n] = (signed char)exitIndex;
+            reserved[exitIndex]++;
+        } else if (spillback) {
+            result.blocked = 1;
+            break;
+        } else {
+            targets[n] = -1;
         }
+        *credit -= headway;
+        n++;
+    }
+    // Pas de credit mis de cote pendant l'attente (la dette, elle, reste due)
+    if ((result.blocked || n == q->size) && *credit > 0) *credit = 0;
+    if (n == 0) return result;
+    dequeueBatch(q, batch, n, trafficLog);
+
+    // Voies de retour : un ajout en bloc par voie visee, dans l'ordre de passage
+    Vehicule* group[DISCHARGE_BATCH_MAX];
+    for (int d = 0; d < numLanes; d++) {
+        if (reserved[d] == 0) continue;
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            if (targets[i] != d) continue;
+            Vehicule* v = batch[i];
+            if (metrics != NULL) recordLaneDischarge(metrics, v->type, (unsigned int)(simTime - v->queueTime), 1);
+            if (metrics != NULL && v->type == Emergency) {
+                recordLogHistogram(&metrics->clearance, (unsigned int)(simTime - v->queueTime));
+            }
+            v->queueTime = (unsigned int)simTime; // entree dans la voie de retour
+            group[count++] = v;
+        }
+        Queue* targetRetour = lanes[d]->retour;
+        enqueueBatch(targetRetour, group, count, trafficLog, history);
+        for (int i = 0; i < count; i++) {
+            writeLogRecord(trafficLog, LOG_VEHICLE_MOVED, targetRetour->direction, group[i]->id, 0, 0, 0);
+            if (consoleOutput) printf("Vehicle %d processed from %s at t=%lu\n",
+                        group[i]->id, dirToString(q->direction), simTime);
+        }
+        result.moved += count;
+    }
 
-            
-        // Calcul du temps de passage
-        time_t passTime = *simTime + DURATION_FOR_VEHICULE_PASSATION;
-            
-        // Si le vehicule est en direction d'entrée, il va vers la voie de retour
-        int randomIndex = rand() % numLanes;
-        Queue* targetRetour = lanes[randomIndex]->retour;
-            
-        // Si la file de retour n'est pas pleine, on l'ajoute
-        if (!isFull(targetRetour)) {
-            enqueue(targetRetour, v, logFile,history);
-            fprintf(logFile, "Vehicle %d moved to %s return lane\n", 
-                        v->id, dirToString(targetRetour->direction));
-            printf("Vehicle %d processed from %s at t=%u\n", 
-                        v->id, dirToString(q->direction), passTime);
+    // Vehicules perdus (voie de retour pleine) ou invalides
+    for (int i = 0; i < n; i++) {
+        Vehicule* v = batch[i];
+        if (targets[i] == -2) {
+            writeLogRecord(trafficLog, LOG_VEHICLE_INVALID, 0, v->id, (int)v->arrivalTime, 0, 0);
+        } else if (targets[i] == -1) {
+            writeLogRecord(trafficLog, LOG_VEHICLE_LOST, 0, v->id, 0, 0, 0);
+            if (metrics != NULL) recordLaneDischarge(metrics, v->type, (unsigned int)(simTime - v->queueTime), 0);
+            if (metrics != NULL && v->type == Emergency) {
+                recordLogHistogram(&metrics->clearance, (unsigned int)(simTime - v->queueTime));
+            }
         } else {
-            fprintf(logFile, "Vehicle %d lost (return lane full)\n", v->id);
-            free(v);
+            continue;
         }
-            
-        // Incrementation du temps de simulation
-        *simTime += DURATION_FOR_VEHICULE_PASSATION;
+        releaseVehicule(q->pool, v);
+        result.lost++;
     }
+    return result;
 }   
 
 
@@ -422,45 +670,56 @@ void processQueue(Queue* q, FILE* logFile,TrafficHistoryStack *history, unsigned
 // Fonction principale du programme de simulation 
 
 // Affichage de la simulation dans l'histoirique du systeme
+// Les HISTORY_QUERY_MAX_SHOWN enregistrements les plus recents, puis les comptes par origine et
+// par type de tout ce qui est retenu (les plus anciens venant des cumuls par minute et par heure)
 void printTrafficHistory(TrafficHistoryStack* history) {
     if (history == NULL) {
         printf("\n[ERREUR] Pointeur d'historique est NULL.\n");
         return;
     }
+    const HistoryRetention* r = &history->recent;
 
     printf("\n=== Historique du trafic (plus recent en premier) ===\n");
-    
-    TrafficHistoryNode* current = history->top;
-    int count = 0;
-    
-    while (current != NULL) {
-        if (current->vehicule == NULL) {
-            printf("[ERREUR] Vehicule invalide dans l'historique.\n");
-        } else {
-            printf("%d. ID: %d | Type: %s | Direction: %s | Arrivee: %d\n",
-                ++count,
-                current->vehicule->id,
-                typeToString(current->vehicule->type),
-                dirToString(current->vehicule->origin),
-                current->vehicule->arrivalTime);
-            }
-        current = current->next;
+    int shown = 0;
+    for (int i = r->rawSize - 1; i >= 0 && shown < HISTORY_QUERY_MAX_SHOWN; i--) {
+        const HistoryRecord* record = retainedRecordAt(r, i);
+        printf("%d. ID: %d | Type: %s | Direction: %s | Arrivee: %u | Entree file: %u\n",
+            ++shown,
+            record->vehicleId,
+            typeToString((VehiculeType)record->type),
+            dirToString((Direction)record->origin),
+            record->arrivalTime,
+            record->time);
     }
-        
-    if (count == 0) {
+    if (r->total == 0) {
         printf("Aucun vehicule dans l'historique.\n");
+        return;
+    }
+
+    HistorySummary s = summarizeHistoryRetention(r, 0, UINT_MAX);
+    printf("\n%llu vehicule(s) enregistre(s) : %d recent(s) gardes tels quels, %llu dans les cumuls "
+           "(%d minute(s), %d heure(s)) | memoire : %zu octets\n",
+           r->total, r->rawSize, s.rolled, r->levels[0].size, r->levels[1].size, historyRetentionBytes(r));
+    printf("Periode t=%u..%u\n", s.firstTime, s.lastTime);
+    printf("%-8s %10s %10s %10s %10s %14s\n", "Origine", "Voiture", "Bus", "Moto", "Urgence", "Debit (veh/min)");
+    for (int o = 0; o < 4; o++) {
+        unsigned long long laneTotal = 0;
+        for (int t = 0; t < 4; t++) laneTotal += s.counts[o][t];
+        printf("%-8s %10llu %10llu %10llu %10llu %14.2f\n", dirToString((Direction)o),
+               s.counts[o][CAR], s.counts[o][BUS], s.counts[o][BIKE], s.counts[o][Emergency],
+               historyRatePerMinute(&s, laneTotal));
     }
 }
 
-// Suppression de l'historique du systeme
+// Suppression de l'historique en memoire (la memoire reservee est gardee)
 void clearTrafficHistory(TrafficHistoryStack* history) {
-    while (history->top != NULL) {
-        TrafficHistoryNode* temp = history->top;
-        history->top = history->top->next;
-        
-        if (temp->vehicule != NULL) {
-            free(temp->vehicule);
-        }
-        free(temp);
-    }
-}
\ No newline at end of file
+    resetHistoryRetention(&history->recent);
+}
+
+// Libere l'historique en memoire et le pool des vehicules
+void freeTrafficHistory(TrafficHistoryStack* history) {
+    freeHistoryRetention(&history->recent);
+    destroyPool(&history->vehicles);
+}
+
+#endif // QUEUE_H
@@ -0,0 +1,117 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+/* --- Generateur aleatoire a compteur (Philox4x32-10), independant de rand() --- */
+// Chaque tirage est une fonction pure de (graine, intersection, instant, voie, usage, rang) :
+// il ne depend d'aucun etat partage, si bien qu'un tirage ajoute ne decale pas les suivants
+// et qu'une execution parallele reproduit exactement l'execution sequentielle.
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+#define RANDOM_ANY_LANE 0xFFFF // Tirage qui ne concerne pas une voie particuliere
+#define RANDOM_BATCH_WIDTH 8   // Voies traitees ensemble par randomLaneBlocks
+
+// Usage d'un tirage : deux usages differents ne partagent jamais de nombres
+typedef enum {
+    RANDOM_ARRIVAL,  // Arrivee d'un vehicule et choix de sa voie
+    RANDOM_VEHICLE,  // Urgence, type et virage d'un vehicule cree
+    RANDOM_REROUTE,  // Nouveau virage d'un vehicule entrant depuis une intersection voisine
+    RANDOM_SEARCH    // Variante d'un plan de feux (optimiseur)
+} RandomPurpose;
+
+// Cle d'un flux : derivee de la graine et du numero de flux (ex: identifiant d'intersection)
+typedef struct {
+    unsigned int key[2];
+} SimRandom;
+
+// Bloc de quatre entiers 32 bits produit par un tirage
+typedef struct {
+    unsigned int v[4];
+} RandomBlock;
+
+// Melange splitmix64 : derive un etat bien reparti a partir d'une graine
+unsigned long long mixSeed(unsigned long long x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Initialise un flux a partir d'une graine et d'un numero de flux
+void seedRandom(SimRandom* r, unsigned long long seed, unsigned long long stream) {
+    unsigned long long k = mixSeed(seed ^ mixSeed(stream));
+    r->key[0] = (unsigned int)k;
+    r->key[1] = (unsigned int)(k >> 32);
+}
+
+// Chiffre un compteur de 128 bits avec la cle du flux (10 tours Philox)
+RandomBlock philox4x32(const SimRandom* r, unsigned int c0, unsigned int c1, unsigned int c2, unsigned int c3) {
+    unsigned int k0 = r->key[0], k1 = r->key[1];
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        unsigned long long p0 = (unsigned long long)PHILOX_M0 * c0;
+        unsigned long long p1 = (unsigned long long)PHILOX_M1 * c2;
+        unsigned int n0 = (unsigned int)(p1 >> 32) ^ c1 ^ k0;
+        unsigned int n2 = (unsigned int)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (unsigned int)p1;
+        c3 = (unsigned int)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    RandomBlock b = {{c0, c1, c2, c3}};
+    return b;
+}
+
+// Tirage d'un bloc : "draw" distingue plusieurs blocs de meme instant, voie et usage
+RandomBlock randomDraw(const SimRandom* r, unsigned long long tick, int lane, RandomPurpose purpose, unsigned int draw) {
+    return philox4x32(r, (unsigned int)tick, (unsigned int)(tick >> 32),
+                      ((unsigned int)lane & 0xFFFFu) | ((unsigned int)purpose << 16), draw);
+}
+
+// Ramene un entier 32 bits dans [0, n) (multiplication, sans division)
+int randomBelow(unsigned int word, int n) {
+    return (int)(((unsigned long long)word * (unsigned int)n) >> 32);
+}
+
+// Tire un bloc pour chacune des voies [0, lanes) au meme instant et pour le meme usage
+// Les voies sont chiffrees par paquets en parallele (structure de tableaux) : la boucle
+// interne n'a aucune dependance et se vectorise ; le resultat est identique a randomDraw
+void randomLaneBlocks(const SimRandom* r, unsigned long long tick, RandomPurpose purpose,
+                      unsigned int draw, int lanes, RandomBlock* out) {
+    for (int first = 0; first < lanes; first += RANDOM_BATCH_WIDTH) {
+        int width = (lanes - first < RANDOM_BATCH_WIDTH) ? lanes - first : RANDOM_BATCH_WIDTH;
+        unsigned int c0[RANDOM_BATCH_WIDTH], c1[RANDOM_BATCH_WIDTH];
+        unsigned int c2[RANDOM_BATCH_WIDTH], c3[RANDOM_BATCH_WIDTH];
+        for (int i = 0; i < RANDOM_BATCH_WIDTH; i++) {
+            c0[i] = (unsigned int)tick;
+            c1[i] = (unsigned int)(tick >> 32);
+            c2[i] = ((unsigned int)(first + i) & 0xFFFFu) | ((unsigned int)purpose << 16);
+            c3[i] = draw;
+        }
+        unsigned int k0 = r->key[0], k1 = r->key[1];
+        for (int round = 0; round < PHILOX_ROUNDS; round++) {
+            for (int i = 0; i < RANDOM_BATCH_WIDTH; i++) {
+                unsigned long long p0 = (unsigned long long)PHILOX_M0 * c0[i];
+                unsigned long long p1 = (unsigned long long)PHILOX_M1 * c2[i];
+                unsigned int n0 = (unsigned int)(p1 >> 32) ^ c1[i] ^ k0;
+                unsigned int n2 = (unsigned int)(p0 >> 32) ^ c3[i] ^ k1;
+                c1[i] = (unsigned int)p1;
+                c3[i] = (unsigned int)p0;
+                c0[i] = n0;
+                c2[i] = n2;
+            }
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        for (int i = 0; i < width; i++) {
+            RandomBlock b = {{c0[i], c1[i], c2[i], c3[i]}};
+            out[first + i] = b;
+        }
+    }
+}
+
+#endif // RANDOM_H
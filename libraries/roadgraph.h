@@ -0,0 +1,352 @@
+#ifndef ROADGRAPH_H
+#define ROADGRAPH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "queue.h"
+
+/* --- Graphe routier et tables de routage (prochain saut pour toutes les paires) --- */
+// Chaque intersection a quatre sorties (Direction) ; une route relie la sortie "port" d'une
+// intersection a l'approche "approach" de sa voisine, dans les deux sens.
+// La table de routage donne, pour chaque destination et chaque intersection, la sortie a prendre
+// sur un plus court chemin (en duree de parcours) : 2 bits par paire, une ligne par destination.
+// Les lignes sont calculees en parallele (un parcours de Dial par destination) et alignees sur
+// 64 octets : deux threads n'ecrivent jamais dans la meme ligne de cache.
+
+#define ROUTE_MAX_NODES 65535 // La destination d'un vehicule tient sur 16 bits (0xFFFF : aucune)
+#define ROUTE_ROW_ALIGN 64
+#define ROUTE_BUILD_CHUNK 16  // Destinations prises a la fois par un thread de calcul
+
+typedef struct {
+    int count;           // Intersections
+    int (*neighbor)[4];  // neighbor[i][p] : intersection atteinte par la sortie p (-1 : aucune)
+    int (*approach)[4];  // approach[i][p] : approche par laquelle on arrive chez la voisine
+    int (*travel)[4];    // travel[i][p] : duree de parcours de la route (secondes)
+    int* component;      // Composante connexe de chaque intersection
+    float* x;            // Position de chaque intersection (grille : colonne et ligne ;
+    float* y;            // liste de routes : rang de l'intersection) pour la demande
+    int rows;            // Grille : dimensions (0 pour un graphe lu dans une liste de routes)
+    int cols;
+} RoadGraph;
+
+// Table de routage : hops[destination * rowBytes + node / 4], 2 bits par intersection
+typedef struct {
+    int count;
+    size_t rowBytes;
+    unsigned char* hops;
+} RouteTable;
+
+// Cree un graphe de "count" intersections sans route. Retourne 0 si la memoire manque
+int allocRoadGraph(RoadGraph* g, int count) {
+    memset(g, 0, sizeof(*g));
+    g->count = count;
+    g->neighbor = malloc(sizeof(*g->neighbor) * count);
+    g->approach = malloc(sizeof(*g->approach) * count);
+    g->travel = malloc(sizeof(*g->travel) * count);
+    g->component = (int*)malloc(sizeof(int) * count);
+    g->x = (float*)malloc(sizeof(float) * count);
+    g->y = (float*)malloc(sizeof(float) * count);
+    if (!g->neighbor || !g->approach || !g->travel || !g->component || !g->x || !g->y) return 0;
+    for (int i = 0; i < count; i++) {
+        for (int p = 0; p < 4; p++) {
+            g->neighbor[i][p] = -1;
+            g->approach[i][p] = 0;
+            g->travel[i][p] = 0;
+        }
+        g->x[i] = (float)i;
+        g->y[i] = 0.0f;
+    }
+    return 1;
+}
+
+void freeRoadGraph(RoadGraph* g) {
+    free(g->neighbor);
+    free(g->approach);
+    free(g->travel);
+    free(g->component);
+    free(g->x);
+    free(g->y);
+    memset(g, 0, sizeof(*g));
+}
+
+// Route a double sens entre la sortie "pa" de "a" et la sortie "pb" de "b"
+void addRoad(RoadGraph* g, int a, int pa, int b, int pb, int travelTime) {
+    g->neighbor[a][pa] = b;
+    g->approach[a][pa] = pb;
+    g->travel[a][pa] = travelTime;
+    g->neighbor[b][pb] = a;
+    g->approach[b][pb] = pa;
+    g->travel[b][pb] = travelTime;
+}
+
+// Numerote les composantes connexes (parcours en largeur)
+void labelRoadComponents(RoadGraph* g) {
+    int* pending = (int*)malloc(sizeof(int) * g->count);
+    for (int i = 0; i < g->count; i++) g->component[i] = -1;
+    int components = 0;
+    for (int s = 0; s < g->count; s++) {
+        if (g->component[s] >= 0) continue;
+        int head = 0, tail = 0;
+        pending[tail++] = s;
+        g->component[s] = components;
+        while (head < tail) {
+            int v = pending[head++];
+            for (int p = 0; p < 4; p++) {
+                int n = g->neighbor[v][p];
+                if (n >= 0 && g->component[n] < 0) {
+                    g->component[n] = components;
+                    pending[tail++] = n;
+                }
+            }
+        }
+        components++;
+    }
+    free(pending);
+}
+
+// Grille de rows x cols intersections (rang ligne * cols + colonne), la ligne 0 au Nord
+int buildGridGraph(RoadGraph* g, int rows, int cols, int travelTime) {
+    if (!allocRoadGraph(g, rows * cols)) return 0;
+    g->rows = rows;
+    g->cols = cols;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int i = r * cols + c;
+            g->x[i] = (float)c;
+            g->y[i] = (float)r;
+            if (c + 1 < cols) addRoad(g, i, EAST, i + 1, WEST, travelTime);
+            if (r + 1 < rows) addRoad(g, i, SOUTH, i + cols, NORTH, travelTime);
+        }
+    }
+    labelRoadComponents(g);
+    return 1;
+}
+
+// Graphe lu dans une liste de routes a double sens : "origine,destination[,duree]" par ligne
+// (intersections numerotees a partir de 0 ; lignes vides, commentaires # et en-tete ignores).
+// Chaque route prend la premiere sortie libre de ses deux intersections (4 routes au plus).
+// Retourne 0 si le fichier est illisible ou invalide (le graphe n'est alors pas cree)
+int loadEdgeListGraph(RoadGraph* g, const char* path, int defaultTravelTime) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return 0;
+    int (*edges)[3] = NULL;
+    int count = 0, capacity = 0, maxNode = -1, ok = 1;
+    long lineNumber = 0;
+    char line[256];
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char* s = line;
+        while (*s == ' ' || *s == '\t') s++;
+        if (*s < '0' || *s > '9') continue; // ligne vide ou en-tete
+        int from = -1, to = -1, travel = defaultTravelTime;
+        int fields = sscanf(s, "%d%*[ ,;]%d%*[ ,;]%d", &from, &to, &travel);
+        if (fields < 2 || from < 0 || to < 0 || from == to || travel < 0
+            || from >= ROUTE_MAX_NODES || to >= ROUTE_MAX_NODES) {
+            printf("[ERREUR] %s ligne %ld : route invalide\n", path, lineNumber);
+            ok = 0;
+            break;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            edges = realloc(edges, sizeof(*edges) * capacity);
+        }
+        edges[count][0] = from;
+        edges[count][1] = to;
+        edges[count][2] = travel;
+        count++;
+        if (from > maxNode) maxNode = from;
+        if (to > maxNode) maxNode = to;
+    }
+    fclose(file);
+    if (ok && maxNode < 0) ok = 0;
+    if (ok && !allocRoadGraph(g, maxNode + 1)) ok = 0;
+    for (int e = 0; ok && e < count; e++) {
+        int a = edges[e][0], b = edges[e][1], pa = 0, pb = 0;
+        while (pa < 4 && g->neighbor[a][pa] >= 0 && g->neighbor[a][pa] != b) pa++;
+        while (pb < 4 && g->neighbor[b][pb] >= 0) pb++;
+        if (pa < 4 && g->neighbor[a][pa] == b) continue; // route deja connue
+        if (pa == 4 || pb == 4) {
+            printf("[ERREUR] %s : l'intersection %d a plus de 4 routes\n", path, (pa == 4) ? a : b);
+            ok = 0;
+            break;
+        }
+        addRoad(g, a, pa, b, pb, edges[e][2]);
+    }
+    free(edges);
+    if (!ok) {
+        if (maxNode >= 0) freeRoadGraph(g);
+        return 0;
+    }
+    labelRoadComponents(g);
+    return 1;
+}
+
+// Sortie a prendre en "node" pour rejoindre "destination"
+Direction routeExit(const RouteTable* t, int destination, int node) {
+    unsigned char packed = t->hops[(size_t)destination * t->rowBytes + (size_t)(node >> 2)];
+    return (Direction)((packed >> ((node & 3) * 2)) & 3);
+}
+
+// Virage qui mene de l'approche "approach" a la sortie "exit" (demi-tour : tout droit)
+TurnDirection routeTurn(Direction approach, Direction exit) {
+    if (exitDirection(approach, LEFT) == exit) return LEFT;
+    if (exitDirection(approach, RIGHT) == exit) return RIGHT;
+    return STRAIGHT;
+}
+
+// Memoire de la table de routage
+size_t routeTableBytes(const RouteTable* t) {
+    return (size_t)t->count * t->rowBytes;
+}
+
+void freeRouteTable(RouteTable* t) {
+    free(t->hops);
+    t->hops = NULL;
+    t->count = 0;
+}
+
+// Donnees partagees par les threads de calcul des routes
+typedef struct {
+    const RoadGraph* graph;
+    RouteTable* table;
+    int* inStart;     // Routes entrant dans v : inNode/inPort/inTravel[inStart[v] .. inStart[v + 1])
+    int* inNode;      // Intersection de depart de la route
+    unsigned char* inPort; // Sortie prise a l'intersection de depart
+    int* inTravel;
+    int buckets;      // Seaux du parcours de Dial (plus longue duree de route + 1)
+    atomic_int next;  // Prochaine destination a traiter
+} RouteBuild;
+
+// File d'un seau du parcours de Dial
+typedef struct {
+    int* items;
+    int size;
+    int capacity;
+} RouteBucket;
+
+void pushRouteBucket(RouteBucket* b, int node) {
+    if (b->size == b->capacity) {
+        b->capacity = b->capacity ? b->capacity * 2 : 64;
+        b->items = (int*)realloc(b->items, sizeof(int) * b->capacity);
+    }
+    b->items[b->size++] = node;
+}
+
+// Ligne "destination" de la table : plus courts chemins vers la destination en remontant les
+// routes (durees entieres : parcours de Dial, seaux circulaires). Le premier predecesseur
+// trouve a distance minimale est garde, si bien que la table ne depend pas du nombre de threads
+void buildRouteRow(RouteBuild* b, int destination, unsigned int* dist, int* settled, RouteBucket* buckets) {
+    const RoadGraph* g = b->graph;
+    unsigned char* row = b->table->hops + (size_t)destination * b->table->rowBytes;
+    memset(row, 0, b->table->rowBytes);
+    for (int i = 0; i < g->count; i++) dist[i] = UINT_MAX;
+    dist[destination] = 0;
+    pushRouteBucket(&buckets[0], destination);
+    long pending = 1;
+    for (unsigned int current = 0; pending > 0; current++) {
+        RouteBucket* bucket = &buckets[current % (unsigned int)b->buckets];
+        for (int k = 0; k < bucket->size; k++) { // la taille grandit avec les routes de duree nulle
+            int v = bucket->items[k];
+            if (dist[v] != current || settled[v] == destination) continue;
+            settled[v] = destination;
+            for (int e = b->inStart[v]; e < b->inStart[v + 1]; e++) {
+                int u = b->inNode[e];
+                unsigned int d = current + (unsigned int)b->inTravel[e];
+                if (d >= dist[u]) continue;
+                dist[u] = d;
+                row[u >> 2] = (unsigned char)((row[u >> 2] & ~(3 << ((u & 3) * 2))) | (b->inPort[e] << ((u & 3) * 2)));
+                pushRouteBucket(&buckets[d % (unsigned int)b->buckets], u);
+                pending++;
+            }
+        }
+        pending -= bucket->size;
+        bucket->size = 0;
+    }
+}
+
+// Thread de calcul : prend les destinations par paquets jusqu'a epuisement
+void* routeBuildWorker(void* arg) {
+    RouteBuild* b = (RouteBuild*)arg;
+    int count = b->graph->count;
+    unsigned int* dist = (unsigned int*)malloc(sizeof(unsigned int) * count);
+    int* settled = (int*)malloc(sizeof(int) * count);
+    RouteBucket* buckets = (RouteBucket*)calloc(b->buckets, sizeof(RouteBucket));
+    for (int i = 0; i < count; i++) settled[i] = -1;
+    while (1) {
+        int first = atomic_fetch_add(&b->next, ROUTE_BUILD_CHUNK);
+        if (first >= count) break;
+        int last = (first + ROUTE_BUILD_CHUNK < count) ? first + ROUTE_BUILD_CHUNK : count;
+        for (int d = first; d < last; d++) buildRouteRow(b, d, dist, settled, buckets);
+    }
+    for (int k = 0; k < b->buckets; k++) free(buckets[k].items);
+    free(buckets);
+    free(settled);
+    free(dist);
+    return NULL;
+}
+
+// Calcule la table de routage de "g" avec "threads" threads. Retourne 0 si la memoire manque
+int buildRouteTable(RouteTable* t, const RoadGraph* g, int threads) {
+    t->count = g->count;
+    t->rowBytes = ((size_t)(g->count + 3) / 4 + ROUTE_ROW_ALIGN - 1) / ROUTE_ROW_ALIGN * ROUTE_ROW_ALIGN;
+    t->hops = (unsigned char*)aligned_alloc(ROUTE_ROW_ALIGN, t->rowBytes * (size_t)g->count);
+    if (t->hops == NULL) return 0;
+
+    // Routes entrantes de chaque intersection (sens inverse du graphe)
+    RouteBuild b;
+    b.graph = g;
+    b.table = t;
+    b.inStart = (int*)calloc((size_t)g->count + 1, sizeof(int));
+    int maxTravel = 0, roads = 0;
+    for (int u = 0; u < g->count; u++) {
+        for (int p = 0; p < 4; p++) {
+            int v = g->neighbor[u][p];
+            if (v < 0) continue;
+            b.inStart[v + 1]++;
+            roads++;
+            if (g->travel[u][p] > maxTravel) maxTravel = g->travel[u][p];
+        }
+    }
+    for (int v = 0; v < g->count; v++) b.inStart[v + 1] += b.inStart[v];
+    b.inNode = (int*)malloc(sizeof(int) * (roads + 1));
+    b.inPort = (unsigned char*)malloc((size_t)roads + 1);
+    b.inTravel = (int*)malloc(sizeof(int) * (roads + 1));
+    int* fill = (int*)malloc(sizeof(int) * g->count);
+    memcpy(fill, b.inStart, sizeof(int) * g->count);
+    for (int u = 0; u < g->count; u++) {
+        for (int p = 0; p < 4; p++) {
+            int v = g->neighbor[u][p];
+            if (v < 0) continue;
+            int e = fill[v]++;
+            b.inNode[e] = u;
+            b.inPort[e] = (unsigned char)p;
+            b.inTravel[e] = g->travel[u][p];
+        }
+    }
+    free(fill);
+    b.buckets = maxTravel + 1;
+    atomic_init(&b.next, 0);
+
+    if (threads > (g->count + ROUTE_BUILD_CHUNK - 1) / ROUTE_BUILD_CHUNK) {
+        threads = (g->count + ROUTE_BUILD_CHUNK - 1) / ROUTE_BUILD_CHUNK;
+    }
+    if (threads < 1) threads = 1;
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    for (int k = 1; k < threads; k++) pthread_create(&workers[k], NULL, routeBuildWorker, &b);
+    routeBuildWorker(&b); // le thread appelant participe
+    for (int k = 1; k < threads; k++) pthread_join(workers[k], NULL);
+    free(workers);
+    free(b.inStart);
+    free(b.inNode);
+    free(b.inPort);
+    free(b.inTravel);
+    return 1;
+}
+
+#endif // ROADGRAPH_H
@@ -0,0 +1,261 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include "config.h"
+
+/* --- Scenario : parametres de simulation modifiables sans recompiler --- */
+// Les valeurs par defaut sont celles de config.h ; un fichier de scenario les remplace
+// ligne par ligne ("NOM = valeur", commentaires commencant par #).
+
+// Politiques de feux (valeurs de SIGNAL_CONTROLLER)
+typedef enum {
+    CONTROLLER_FIXED,        // Alternance fixe des phases
+    CONTROLLER_ACTUATED,     // Vert prolonge tant que des vehicules se presentent
+    CONTROLLER_MAX_PRESSURE, // Phase de plus forte pression amont - aval
+    SIGNAL_CONTROLLER_COUNT
+} SignalControllerType;
+
+typedef struct {
+    int simulationDuration;       // SIMULATION_DURATION
+    unsigned long long seed;      // SIMULATION_SEED
+    int queueCapacity;            // QUEUE_CAPACITY
+    int emergencyChance;          // EMERGENCY_CHANCE
+    int vehicleGenProb;           // VEHICLE_GEN_PROB
+    int baseGreenDuration;        // BASE_GREEN_DURATION
+    int baseRedDuration;          // BASE_RED_DURATION
+    int greenBoost;               // GREEN_BOOST
+    int redReduction;             // RED_REDUCTION
+    double trafficJamThreshold;   // TRAFFIC_JAM_THRESHOLD
+    int signalController;         // SIGNAL_CONTROLLER
+    int actuatedGap;              // ACTUATED_GAP
+    int actuatedMaxGreen;         // ACTUATED_MAX_GREEN
+    int emergencyPreemption;      // EMERGENCY_PREEMPTION
+    int passageDuration;          // DURATION_FOR_VEHICULE_PASSATION
+    int headways[4];              // HEADWAY_CAR, HEADWAY_BUS, HEADWAY_BIKE, HEADWAY_EMERGENCY (par VehiculeType)
+    int networkSize;              // NETWORK_SIZE
+    int linkTravelTime;           // LINK_TRAVEL_TIME
+    int gridRows;                 // GRID_ROWS
+    int gridCols;                 // GRID_COLS
+    int odZoneSize;               // OD_ZONE_SIZE
+    double odDistanceDecay;       // OD_DISTANCE_DECAY
+    int networkDuration;          // NETWORK_DURATION
+    int networkThreads;           // NETWORK_THREADS
+    int replications;             // MONTE_CARLO_REPLICATIONS
+    int replicationDuration;      // MONTE_CARLO_DURATION
+    int replicationThreads;       // MONTE_CARLO_THREADS
+    int optimizerRounds;          // OPTIMIZER_ROUNDS
+    int optimizerCandidates;      // OPTIMIZER_CANDIDATES
+    int optimizerWarmup;          // OPTIMIZER_WARMUP
+    int optimizerHorizon;         // OPTIMIZER_HORIZON
+    int optimizerMaxCycle;        // OPTIMIZER_MAX_CYCLE
+    int optimizerThreads;         // OPTIMIZER_THREADS
+    int historyMemoryLimit;       // HISTORY_MEMORY_LIMIT
+} ScenarioConfig;
+
+// Type d'un parametre du fichier de scenario
+typedef enum {
+    PARAM_INT,
+    PARAM_DOUBLE,
+    PARAM_SEED
+} ScenarioParamType;
+
+// Description d'un parametre : nom dans le fichier, type et position dans ScenarioConfig
+typedef struct {
+    const char* name;
+    ScenarioParamType type;
+    size_t offset;
+} ScenarioParam;
+
+static const ScenarioParam scenarioParams[] = {
+    {"SIMULATION_DURATION", PARAM_INT, offsetof(ScenarioConfig, simulationDuration)},
+    {"SIMULATION_SEED", PARAM_SEED, offsetof(ScenarioConfig, seed)},
+    {"QUEUE_CAPACITY", PARAM_INT, offsetof(ScenarioConfig, queueCapacity)},
+    {"EMERGENCY_CHANCE", PARAM_INT, offsetof(ScenarioConfig, emergencyChance)},
+    {"VEHICLE_GEN_PROB", PARAM_INT, offsetof(ScenarioConfig, vehicleGenProb)},
+    {"BASE_GREEN_DURATION", PARAM_INT, offsetof(ScenarioConfig, baseGreenDuration)},
+    {"BASE_RED_DURATION", PARAM_INT, offsetof(ScenarioConfig, baseRedDuration)},
+    {"GREEN_BOOST", PARAM_INT, offsetof(ScenarioConfig, greenBoost)},
+    {"RED_REDUCTION", PARAM_INT, offsetof(ScenarioConfig, redReduction)},
+    {"TRAFFIC_JAM_THRESHOLD", PARAM_DOUBLE, offsetof(ScenarioConfig, trafficJamThreshold)},
+    {"SIGNAL_CONTROLLER", PARAM_INT, offsetof(ScenarioConfig, signalController)},
+    {"ACTUATED_GAP", PARAM_INT, offsetof(ScenarioConfig, actuatedGap)},
+    {"ACTUATED_MAX_GREEN", PARAM_INT, offsetof(ScenarioConfig, actuatedMaxGreen)},
+    {"EMERGENCY_PREEMPTION", PARAM_INT, offsetof(ScenarioConfig, emergencyPreemption)},
+    {"DURATION_FOR_VEHICULE_PASSATION", PARAM_INT, offsetof(ScenarioConfig, passageDuration)},
+    {"HEADWAY_CAR", PARAM_INT, offsetof(ScenarioConfig, headways[0])},
+    {"HEADWAY_BUS", PARAM_INT, offsetof(ScenarioConfig, headways[1])},
+    {"HEADWAY_BIKE", PARAM_INT, offsetof(ScenarioConfig, headways[2])},
+    {"HEADWAY_EMERGENCY", PARAM_INT, offsetof(ScenarioConfig, headways[3])},
+    {"NETWORK_SIZE", PARAM_INT, offsetof(ScenarioConfig, networkSize)},
+    {"LINK_TRAVEL_TIME", PARAM_INT, offsetof(ScenarioConfig, linkTravelTime)},
+    {"GRID_ROWS", PARAM_INT, offsetof(ScenarioConfig, gridRows)},
+    {"GRID_COLS", PARAM_INT, offsetof(ScenarioConfig, gridCols)},
+    {"OD_ZONE_SIZE", PARAM_INT, offsetof(ScenarioConfig, odZoneSize)},
+    {"OD_DISTANCE_DECAY", PARAM_DOUBLE, offsetof(ScenarioConfig, odDistanceDecay)},
+    {"NETWORK_DURATION", PARAM_INT, offsetof(ScenarioConfig, networkDuration)},
+    {"NETWORK_THREADS", PARAM_INT, offsetof(ScenarioConfig, networkThreads)},
+    {"MONTE_CARLO_REPLICATIONS", PARAM_INT, offsetof(ScenarioConfig, replications)},
+    {"MONTE_CARLO_DURATION", PARAM_INT, offsetof(ScenarioConfig, replicationDuration)},
+    {"MONTE_CARLO_THREADS", PARAM_INT, offsetof(ScenarioConfig, replicationThreads)},
+    {"OPTIMIZER_ROUNDS", PARAM_INT, offsetof(ScenarioConfig, optimizerRounds)},
+    {"OPTIMIZER_CANDIDATES", PARAM_INT, offsetof(ScenarioConfig, optimizerCandidates)},
+    {"OPTIMIZER_WARMUP", PARAM_INT, offsetof(ScenarioConfig, optimizerWarmup)},
+    {"OPTIMIZER_HORIZON", PARAM_INT, offsetof(ScenarioConfig, optimizerHorizon)},
+    {"OPTIMIZER_MAX_CYCLE", PARAM_INT, offsetof(ScenarioConfig, optimizerMaxCycle)},
+    {"OPTIMIZER_THREADS", PARAM_INT, offsetof(ScenarioConfig, optimizerThreads)},
+    {"HISTORY_MEMORY_LIMIT", PARAM_INT, offsetof(ScenarioConfig, historyMemoryLimit)}
+};
+#define SCENARIO_PARAM_COUNT ((int)(sizeof(scenarioParams) / sizeof(scenarioParams[0])))
+
+// Scenario utilise par les simulations lancees depuis le menu (charge au demarrage)
+ScenarioConfig activeScenario = {
+    SIMULATION_DURATION, SIMULATION_SEED, QUEUE_CAPACITY, EMERGENCY_CHANCE, VEHICLE_GEN_PROB,
+    BASE_GREEN_DURATION, BASE_RED_DURATION, GREEN_BOOST, RED_REDUCTION, TRAFFIC_JAM_THRESHOLD,
+    SIGNAL_CONTROLLER, ACTUATED_GAP, ACTUATED_MAX_GREEN, EMERGENCY_PREEMPTION, DURATION_FOR_VEHICULE_PASSATION,
+    {HEADWAY_CAR, HEADWAY_BUS, HEADWAY_BIKE, HEADWAY_EMERGENCY}, NETWORK_SIZE, LINK_TRAVEL_TIME,
+    GRID_ROWS, GRID_COLS, OD_ZONE_SIZE, OD_DISTANCE_DECAY, NETWORK_DURATION,
+    NETWORK_THREADS, MONTE_CARLO_REPLICATIONS, MONTE_CARLO_DURATION, MONTE_CARLO_THREADS,
+    OPTIMIZER_ROUNDS, OPTIMIZER_CANDIDATES, OPTIMIZER_WARMUP, OPTIMIZER_HORIZON, OPTIMIZER_MAX_CYCLE,
+    OPTIMIZER_THREADS, HISTORY_MEMORY_LIMIT
+};
+
+// Retourne le parametre de ce nom (NULL s'il est inconnu)
+const ScenarioParam* findScenarioParam(const char* name) {
+    for (int i = 0; i < SCENARIO_PARAM_COUNT; i++) {
+        if (strcmp(scenarioParams[i].name, name) == 0) return &scenarioParams[i];
+    }
+    return NULL;
+}
+
+// Verifie qu'une valeur convient au type du parametre : un PARAM_INT doit etre entier et tenir dans un int
+int scenarioValueValid(const ScenarioParam* p, double value) {
+    if (p->type != PARAM_INT) return 1;
+    return value >= (double)INT_MIN && value <= (double)INT_MAX && (double)(int)value == value;
+}
+
+// Affecte une valeur numerique a un parametre ; retourne 0 (sans rien modifier) si elle ne convient pas
+int setScenarioValue(ScenarioConfig* c, const ScenarioParam* p, double value) {
+    if (!scenarioValueValid(p, value)) return 0;
+    char* field = (char*)c + p->offset;
+    switch (p->type) {
+        case PARAM_INT:    *(int*)field = (int)value; break;
+        case PARAM_DOUBLE: *(double*)field = value; break;
+        case PARAM_SEED:   *(unsigned long long*)field = (unsigned long long)value; break;
+    }
+    return 1;
+}
+
+// Lit la valeur d'un parametre
+double getScenarioValue(const ScenarioConfig* c, const ScenarioParam* p) {
+    const char* field = (const char*)c + p->offset;
+    switch (p->type) {
+        case PARAM_INT:    return (double)*(const int*)field;
+        case PARAM_DOUBLE: return *(const double*)field;
+        default:           return (double)*(const unsigned long long*)field;
+    }
+}
+
+// Retire les espaces en debut et fin de chaine (modifie la chaine)
+char* trimSpaces(char* s) {
+    while (*s == ' ' || *s == '\t') s++;
+    char* end = s + strlen(s);
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) end--;
+    *end = '\0';
+    return s;
+}
+
+// Decoupe une ligne "NOM = valeur" ; retourne 0 pour une ligne vide ou un commentaire
+int splitScenarioLine(char* line, char** name, char** value) {
+    char* comment = strchr(line, '#');
+    if (comment != NULL) *comment = '\0';
+    char* s = trimSpaces(line);
+    if (*s == '\0') return 0;
+    char* eq = strchr(s, '=');
+    if (eq == NULL) {
+        *name = s;
+        *value = NULL;
+        return 1;
+    }
+    *eq = '\0';
+    *name = trimSpaces(s);
+    *value = trimSpaces(eq + 1);
+    return 1;
+}
+
+// Verifie la coherence d'un scenario ; affiche le premier probleme rencontre
+int validateScenario(const ScenarioConfig* c) {
+    const char* error = NULL;
+    if (c->queueCapacity <= 0) error = "QUEUE_CAPACITY doit etre positive";
+    else if (c->vehicleGenProb < 0 || c->vehicleGenProb > 100 || c->emergencyChance < 0 || c->emergencyChance > 100)
+        error = "VEHICLE_GEN_PROB et EMERGENCY_CHANCE sont des pourcentages (0 a 100)";
+    else if (c->simulationDuration <= 0 || c->networkDuration <= 0 || c->replicationDuration <= 0)
+        error = "les durees de simulation doivent etre positives";
+    else if (c->baseGreenDuration <= 0 || c->baseRedDuration <= 0)
+        error = "les durees de feux doivent etre positives";
+    else if (c->baseGreenDuration + c->greenBoost <= 0)
+        error = "GREEN_BOOST rend la duree du vert nulle";
+    else if (c->signalController < 0 || c->signalController >= SIGNAL_CONTROLLER_COUNT)
+        error = "SIGNAL_CONTROLLER inconnu (0: fixe, 1: actionne, 2: max-pressure)";
+    else if (c->actuatedGap < 0 || c->actuatedMaxGreen < c->baseGreenDuration)
+        error = "ACTUATED_MAX_GREEN doit etre au moins BASE_GREEN_DURATION";
+    else if (c->emergencyPreemption != 0 && c->emergencyPreemption != 1)
+        error = "EMERGENCY_PREEMPTION vaut 0 ou 1";
+    else if (c->passageDuration <= 0) error = "DURATION_FOR_VEHICULE_PASSATION doit etre positive";
+    else if (c->headways[0] <= 0 || c->headways[1] <= 0 || c->headways[2] <= 0 || c->headways[3] <= 0)
+        error = "les intervalles HEADWAY_* doivent etre positifs";
+    else if (c->networkSize <= 0 || c->linkTravelTime < 0) error = "parametres de reseau invalides";
+    else if (c->gridRows <= 0 || c->gridCols <= 0 || (long long)c->gridRows * c->gridCols > 65535)
+        error = "GRID_ROWS x GRID_COLS doit etre entre 1 et 65535";
+    else if (c->odZoneSize <= 0 || c->odDistanceDecay < 0) error = "parametres de demande origine-destination invalides";
+    else if (c->replications <= 0) error = "MONTE_CARLO_REPLICATIONS doit etre positif";
+    else if (c->optimizerRounds < 0 || c->optimizerCandidates <= 0 || c->optimizerWarmup <= 0
+             || c->optimizerHorizon < OPTIMIZER_SEGMENTS || c->optimizerThreads < 0)
+        error = "parametres de l'optimiseur de feux invalides";
+    else if (c->optimizerMaxCycle < 2 * OPTIMIZER_MIN_GREEN)
+        error = "OPTIMIZER_MAX_CYCLE doit laisser OPTIMIZER_MIN_GREEN de vert a chaque phase";
+    else if (c->historyMemoryLimit <= 0) error = "HISTORY_MEMORY_LIMIT doit etre positive (octets)";
+    if (error != NULL) {
+        printf("[ERREUR] Scenario invalide : %s\n", error);
+        return 0;
+    }
+    return 1;
+}
+
+// Charge un fichier de scenario par-dessus "c" ; retourne 0 si le fichier est absent ou invalide
+int loadScenarioFile(ScenarioConfig* c, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return 0;
+    ScenarioConfig loaded = *c;
+    char buffer[256];
+    int lineNumber = 0, ok = 1;
+    while (fgets(buffer, sizeof(buffer), file) != NULL) {
+        lineNumber++;
+        char *name, *value;
+        if (!splitScenarioLine(buffer, &name, &value)) continue;
+        const ScenarioParam* p = findScenarioParam(name);
+        char* end = NULL;
+        double number = (value != NULL) ? strtod(value, &end) : 0.0;
+        if (p == NULL || value == NULL || end == value || *end != '\0') {
+            printf("[ERREUR] %s:%d : ligne invalide (%s)\n", path, lineNumber, name);
+            ok = 0;
+            continue;
+        }
+        if (p->type == PARAM_SEED) {
+            loaded.seed = strtoull(value, NULL, 10);
+        } else if (!setScenarioValue(&loaded, p, number)) {
+            printf("[ERREUR] %s:%d : %s attend un entier (%s)\n", path, lineNumber, name, value);
+            ok = 0;
+        }
+    }
+    fclose(file);
+    if (!ok || !validateScenario(&loaded)) return 0;
+    *c = loaded;
+    return 1;
+}
+
+#endif // SCENARIO_H
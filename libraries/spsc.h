@@ -0,0 +1,67 @@
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "queue.h"
+
+/* --- File de passage sans verrou (un producteur, un consommateur) --- */
+
+// Anneau de vehicules entre deux intersections : l'amont pousse, l'aval retire
+// La capacite est une puissance de deux ; head et tail sont sur des lignes de cache distinctes
+typedef struct {
+    Vehicule** slots;
+    unsigned int mask;
+    _Alignas(64) atomic_uint head; // Position de lecture (consommateur)
+    _Alignas(64) atomic_uint tail; // Position d'ecriture (producteur)
+} SpscRing;
+
+// Initialise un anneau de capacite au moins egale a "capacity"
+void initSpscRing(SpscRing* r, unsigned int capacity) {
+    unsigned int size = 1;
+    while (size < capacity) size <<= 1;
+    r->slots = (Vehicule**)malloc(sizeof(Vehicule*) * size);
+    r->mask = size - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+}
+
+// Libere l'anneau ; les vehicules encore en transit retournent au pool
+void freeSpscRing(SpscRing* r, MemoryPool* pool) {
+    if (r->slots == NULL) return;
+    unsigned int head = atomic_load(&r->head);
+    unsigned int tail = atomic_load(&r->tail);
+    for (; head != tail; head++) {
+        releaseVehicule(pool, r->slots[head & r->mask]);
+    }
+    free(r->slots);
+    r->slots = NULL;
+}
+
+// Nombre de vehicules en transit
+unsigned int spscSize(SpscRing* r) {
+    return atomic_load_explicit(&r->tail, memory_order_acquire)
+         - atomic_load_explicit(&r->head, memory_order_acquire);
+}
+
+// Ajoute un vehicule (cote producteur). Retourne 0 si l'anneau est plein
+int spscPush(SpscRing* r, Vehicule* v) {
+    unsigned int tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (tail - head > r->mask) return 0;
+    r->slots[tail & r->mask] = v;
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// Retire le vehicule de tete (cote consommateur). NULL si vide
+Vehicule* spscPop(SpscRing* r) {
+    unsigned int head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head == tail) return NULL;
+    Vehicule* v = r->slots[head & r->mask];
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return v;
+}
+
+#endif // SPSC_H
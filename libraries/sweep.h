@@ -0,0 +1,227 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <math.h>
+#include "montecarlo.h"
+
+/* --- Balayage de parametres : produit cartesien de scenarios simules en parallele --- */
+// Fichier de balayage : meme syntaxe que le scenario, mais une valeur peut etre
+//   une liste      BASE_GREEN_DURATION = 2, 3, 5
+//   un intervalle  VEHICLE_GEN_PROB = 40:90:10   (debut:fin:pas, pas de 1 par defaut)
+// Chaque parametre a plusieurs valeurs devient un axe ; chaque point du produit cartesien
+// est evalue par MONTE_CARLO_REPLICATIONS replications (memes graines pour tous les points).
+
+// Axe du balayage : un parametre et ses valeurs
+typedef struct {
+    const ScenarioParam* param;
+    double* values;
+    int count;
+} SweepAxis;
+
+// Plan de balayage : scenario de base et axes (le dernier axe varie le plus vite)
+typedef struct {
+    ScenarioConfig base;
+    SweepAxis axes[SCENARIO_PARAM_COUNT];
+    int axisCount;
+    long points; // Nombre de scenarios du produit cartesien
+} SweepPlan;
+
+// Decode une liste ou un intervalle de valeurs ; retourne leur nombre (0 si la syntaxe est invalide)
+int parseSweepValues(const char* text, double** values) {
+    *values = NULL;
+    char* end;
+    double first = strtod(text, &end);
+    if (end == text) return 0;
+    while (*end == ' ' || *end == '\t') end++;
+
+    if (*end == ':') {
+        double last = strtod(end + 1, &end);
+        double step = 1.0;
+        while (*end == ' ' || *end == '\t') end++;
+        if (*end == ':') step = strtod(end + 1, &end);
+        while (*end == ' ' || *end == '\t') end++;
+        if (*end != '\0' || step <= 0.0 || last < first) return 0;
+        long count = (long)floor((last - first) / step + 1e-9) + 1;
+        if (count > SWEEP_MAX_POINTS) return 0;
+        *values = (double*)malloc(sizeof(double) * count);
+        for (long i = 0; i < count; i++) {
+            (*values)[i] = first + step * (double)i;
+        }
+        return (int)count;
+    }
+
+    int count = 1, capacity = 8;
+    *values = (double*)malloc(sizeof(double) * capacity);
+    (*values)[0] = first;
+    while (*end == ',') {
+        char* start = end + 1;
+        double v = strtod(start, &end);
+        if (end == start) {
+            free(*values);
+            *values = NULL;
+            return 0;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            *values = (double*)realloc(*values, sizeof(double) * capacity);
+        }
+        (*values)[count++] = v;
+        while (*end == ' ' || *end == '\t') end++;
+    }
+    if (*end != '\0') {
+        free(*values);
+        *values = NULL;
+        return 0;
+    }
+    return count;
+}
+
+// Libere les valeurs des axes
+void freeSweepPlan(SweepPlan* plan) {
+    for (int a = 0; a < plan->axisCount; a++) {
+        free(plan->axes[a].values);
+    }
+    plan->axisCount = 0;
+    plan->points = 0;
+}
+
+// Charge un fichier de balayage par-dessus le scenario "base" ; retourne 0 en cas d'erreur
+int loadSweepFile(SweepPlan* plan, const char* path, const ScenarioConfig* base) {
+    plan->base = *base;
+    plan->axisCount = 0;
+    plan->points = 1;
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("[ERREUR] Fichier de balayage introuvable : %s\n", path);
+        return 0;
+    }
+    char buffer[1024];
+    int lineNumber = 0, ok = 1;
+    while (fgets(buffer, sizeof(buffer), file) != NULL) {
+        lineNumber++;
+        char *name, *value;
+        if (!splitScenarioLine(buffer, &name, &value)) continue;
+        const ScenarioParam* p = findScenarioParam(name);
+        double* values = NULL;
+        int count = (p != NULL && value != NULL) ? parseSweepValues(value, &values) : 0;
+        if (count == 0) {
+            printf("[ERREUR] %s:%d : ligne invalide (%s)\n", path, lineNumber, name);
+            ok = 0;
+            continue;
+        }
+        int valid = 1;
+        for (int v = 0; v < count; v++) valid = valid && scenarioValueValid(p, values[v]);
+        if (!valid) {
+            printf("[ERREUR] %s:%d : %s attend des entiers (%s)\n", path, lineNumber, name, value);
+            free(values);
+            ok = 0;
+            continue;
+        }
+        if (count == 1) {
+            if (p->type == PARAM_SEED) plan->base.seed = strtoull(value, NULL, 10);
+            else setScenarioValue(&plan->base, p, values[0]);
+            free(values);
+            continue;
+        }
+        // Graine et nombre de replications sont communs a tous les points du balayage
+        if (p->type == PARAM_SEED || p->offset == offsetof(ScenarioConfig, replications)) {
+            printf("[ERREUR] %s:%d : %s ne peut pas etre balaye\n", path, lineNumber, name);
+            free(values);
+            ok = 0;
+            continue;
+        }
+        // Un parametre repete remplace son axe precedent
+        int a = 0;
+        while (a < plan->axisCount && plan->axes[a].param != p) a++;
+        if (a == plan->axisCount) plan->axisCount++;
+        else free(plan->axes[a].values);
+        plan->axes[a].param = p;
+        plan->axes[a].values = values;
+        plan->axes[a].count = count;
+    }
+    fclose(file);
+
+    for (int a = 0; a < plan->axisCount && ok; a++) {
+        plan->points *= plan->axes[a].count;
+        if (plan->points > SWEEP_MAX_POINTS) {
+            printf("[ERREUR] Balayage trop grand (plus de %d scenarios)\n", SWEEP_MAX_POINTS);
+            ok = 0;
+        }
+    }
+    if (!ok) freeSweepPlan(plan);
+    return ok;
+}
+
+// Construit le scenario numero "index" du produit cartesien (valeurs verifiees par loadSweepFile)
+void sweepPointConfig(const SweepPlan* plan, long index, ScenarioConfig* out) {
+    *out = plan->base;
+    for (int a = plan->axisCount - 1; a >= 0; a--) {
+        const SweepAxis* axis = &plan->axes[a];
+        setScenarioValue(out, axis->param, axis->values[index % axis->count]);
+        index /= axis->count;
+    }
+}
+
+// Evalue tous les scenarios du plan en parallele, affiche le tableau des resultats
+// (limite a SWEEP_MAX_SHOWN lignes) et l'ecrit en entier dans "csvPath"
+int runParameterSweep(const SweepPlan* plan, int threads, const char* csvPath) {
+    int replications = plan->base.replications;
+    ScenarioConfig* configs = (ScenarioConfig*)malloc(sizeof(ScenarioConfig) * plan->points);
+    ReplicationResult* results = (ReplicationResult*)malloc(sizeof(ReplicationResult) * plan->points * replications);
+    if (configs == NULL || results == NULL) {
+        printf("[ERREUR] Memoire insuffisante pour le balayage.\n");
+        free(configs);
+        free(results);
+        return 0;
+    }
+    for (long i = 0; i < plan->points; i++) {
+        sweepPointConfig(plan, i, &configs[i]);
+        if (!validateScenario(&configs[i])) {
+            printf("[ERREUR] Scenario %ld du balayage invalide.\n", i);
+            free(configs);
+            free(results);
+            return 0;
+        }
+    }
+
+    runReplicationBatch(configs, (int)plan->points, replications, results, threads);
+
+    FILE* csv = fopen(csvPath, "w");
+    if (csv == NULL) printf("[ERREUR] Impossible d'ecrire %s\n", csvPath);
+    printf("\n");
+    for (int a = 0; a < plan->axisCount; a++) {
+        printf("%-22s", plan->axes[a].param->name);
+        if (csv) fprintf(csv, "%s,", plan->axes[a].param->name);
+    }
+    for (int m = 0; m < LANE_METRIC_COUNT; m++) {
+        printf(" %-20s", laneMetricNames[m]);
+        if (csv) fprintf(csv, "%s,%s +/-%s", laneMetricNames[m], laneMetricNames[m],
+                         (m + 1 < LANE_METRIC_COUNT) ? "," : "\n");
+    }
+    printf("\n");
+
+    for (long i = 0; i < plan->points; i++) {
+        int shown = i < SWEEP_MAX_SHOWN;
+        for (int a = 0; a < plan->axisCount; a++) {
+            double v = getScenarioValue(&configs[i], plan->axes[a].param);
+            if (shown) printf("%-22g", v);
+            if (csv) fprintf(csv, "%g,", v);
+        }
+        for (int m = 0; m < LANE_METRIC_COUNT; m++) {
+            Estimate e = estimateLaneMetric(results + i * replications, replications,
+                                            INTERSECTION_TOTAL, laneMetricOffsets[m]);
+            if (shown) printf(" %9.2f +/- %-7.2f", e.mean, e.halfWidth);
+            if (csv) fprintf(csv, "%.4f,%.4f%s", e.mean, e.halfWidth, (m + 1 < LANE_METRIC_COUNT) ? "," : "\n");
+        }
+        if (shown) printf("\n");
+    }
+    if (plan->points > SWEEP_MAX_SHOWN) {
+        printf("... %ld scenarios de plus\n", plan->points - SWEEP_MAX_SHOWN);
+    }
+    if (csv) fclose(csv);
+    free(configs);
+    free(results);
+    return 1;
+}
+
+#endif // SWEEP_H
@@ -0,0 +1,170 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "config.h"
+
+/* --- Traces d'execution : intervalles horodates a la nanoseconde, export Chrome / Perfetto --- */
+// Usage :   TRACE_BEGIN(span);  ...etape...  TRACE_END(span, "nom");
+// Sans TRACE_ENABLED les macros disparaissent a la compilation. Compilees mais hors
+// echantillonnage, elles coutent une lecture atomique et un branchement. Chaque thread
+// enregistre dans son propre tampon (aucun verrou sur le chemin chaud) ; le fichier
+// produit s'ouvre dans chrome://tracing ou ui.perfetto.dev.
+
+#if TRACE_ENABLED
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Intervalle termine
+typedef struct {
+    const char* name;         // Chaine statique (non copiee)
+    unsigned long long start; // Debut (ns, horloge monotone)
+    unsigned long long duration;
+} TraceEvent;
+
+// Tampon d'un thread : seul son proprietaire y ecrit, l'export a lieu threads arretes
+typedef struct TraceBuffer {
+    TraceEvent* events;
+    int count;
+    int capacity;
+    int tid;                  // Numero de piste dans la trace
+    int inUse;                // Attribue a un thread vivant
+    unsigned long dropped;    // Intervalles perdus (tampon au maximum)
+    struct TraceBuffer* next;
+} TraceBuffer;
+
+atomic_int traceSampling;                 // 0 : les intervalles ne sont pas enregistres
+pthread_mutex_t traceRegistryLock = PTHREAD_MUTEX_INITIALIZER;
+TraceBuffer* traceBuffers = NULL;         // Tampons de tous les threads ayant trace
+int traceThreadCount = 0;
+unsigned long long traceOrigin = 0;       // Instant zero de la trace
+__thread TraceBuffer* traceLocal = NULL;  // Tampon du thread courant
+
+unsigned long long traceNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+// Tampon du thread courant, attribue au premier intervalle : un tampon libere par un thread
+// termine est repris, si bien que les threads successifs d'un meme role partagent une piste
+TraceBuffer* traceThreadBuffer() {
+    if (traceLocal == NULL) {
+        pthread_mutex_lock(&traceRegistryLock);
+        TraceBuffer* b = traceBuffers;
+        while (b != NULL && b->inUse) b = b->next;
+        if (b == NULL && (b = (TraceBuffer*)calloc(1, sizeof(TraceBuffer))) != NULL) {
+            b->tid = ++traceThreadCount;
+            b->next = traceBuffers;
+            traceBuffers = b;
+        }
+        if (b != NULL) b->inUse = 1;
+        pthread_mutex_unlock(&traceRegistryLock);
+        traceLocal = b;
+    }
+    return traceLocal;
+}
+
+// Rend le tampon du thread qui se termine
+void traceThreadExit() {
+    if (traceLocal == NULL) return;
+    pthread_mutex_lock(&traceRegistryLock);
+    traceLocal->inUse = 0;
+    pthread_mutex_unlock(&traceRegistryLock);
+    traceLocal = NULL;
+}
+
+// Enregistre un intervalle commence a "start" (TRACE_BEGIN)
+void traceEnd(const char* name, unsigned long long start) {
+    unsigned long long end = traceNow();
+    TraceBuffer* b = traceThreadBuffer();
+    if (b == NULL) return;
+    if (b->count == b->capacity) {
+        int capacity = (b->capacity == 0) ? TRACE_BUFFER_CHUNK : b->capacity * 2;
+        TraceEvent* grown = (capacity <= TRACE_BUFFER_MAX_EVENTS)
+            ? (TraceEvent*)realloc(b->events, sizeof(TraceEvent) * capacity) : NULL;
+        if (grown == NULL) {
+            b->dropped++;
+            return;
+        }
+        b->events = grown;
+        b->capacity = capacity;
+    }
+    TraceEvent* e = &b->events[b->count++];
+    e->name = name;
+    e->start = start;
+    e->duration = end - start;
+}
+
+// Vide les tampons et commence l'echantillonnage (aucun thread ne doit etre en train de tracer)
+void traceStart() {
+    pthread_mutex_lock(&traceRegistryLock);
+    for (TraceBuffer* b = traceBuffers; b != NULL; b = b->next) {
+        b->count = 0;
+        b->dropped = 0;
+    }
+    pthread_mutex_unlock(&traceRegistryLock);
+    traceOrigin = traceNow();
+    atomic_store_explicit(&traceSampling, 1, memory_order_release);
+}
+
+void traceStop() {
+    atomic_store_explicit(&traceSampling, 0, memory_order_release);
+}
+
+// Ecrit les intervalles au format JSON "Trace Event" (evenements complets "X", en microsecondes)
+// Retourne le nombre d'intervalles ecrits (0 : rien a ecrire, le fichier n'est pas touche),
+// -1 si le fichier ne peut pas etre cree
+long writeChromeTrace(const char* path) {
+    pthread_mutex_lock(&traceRegistryLock);
+    long spans = 0;
+    for (TraceBuffer* b = traceBuffers; b != NULL; b = b->next) {
+        spans += b->count;
+    }
+    FILE* out = (spans > 0) ? fopen(path, "w") : NULL;
+    if (out == NULL) {
+        pthread_mutex_unlock(&traceRegistryLock);
+        return (spans > 0) ? -1 : 0;
+    }
+    long written = 0;
+    unsigned long dropped = 0;
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (TraceBuffer* b = traceBuffers; b != NULL; b = b->next) {
+        if (b->count == 0) continue;
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                (written > 0) ? ",\n" : "", b->tid, b->tid);
+        for (int i = 0; i < b->count; i++) {
+            const TraceEvent* e = &b->events[i];
+            unsigned long long start = e->start - traceOrigin;
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"sim\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                         "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}",
+                    e->name, b->tid, start / 1000, start % 1000, e->duration / 1000, e->duration % 1000);
+        }
+        written += b->count;
+        dropped += b->dropped;
+    }
+    pthread_mutex_unlock(&traceRegistryLock);
+    fprintf(out, "\n],\"otherData\":{\"dropped\":%lu}}\n", dropped);
+    fclose(out);
+    return written;
+}
+
+// Le test d'echantillonnage est fait sur place pour que le cas courant n'appelle aucune fonction
+#define TRACE_BEGIN(span) \
+    unsigned long long span = __builtin_expect(atomic_load_explicit(&traceSampling, memory_order_relaxed), 0) \
+        ? traceNow() : 0
+#define TRACE_END(span, name) do { if (__builtin_expect(span != 0, 0)) traceEnd(name, span); } while (0)
+#define TRACE_THREAD_EXIT() traceThreadExit()
+
+#else
+
+#define TRACE_BEGIN(span)
+#define TRACE_END(span, name)
+#define TRACE_THREAD_EXIT()
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
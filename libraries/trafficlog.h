@@ -0,0 +1,243 @@
+#ifndef TRAFFICLOG_H
+#define TRAFFICLOG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/* --- Journal binaire asynchrone --- */
+// Les producteurs ecrivent des enregistrements de taille fixe dans un anneau sans verrou ;
+// un thread d'ecriture les vide par lots dans le fichier. Si l'anneau est plein,
+// l'enregistrement est perdu (et compte) : la simulation n'attend jamais le disque. Le nombre
+// d'enregistrements perdus est ecrit dans l'en-tete a la fermeture du journal.
+// L'outil tools/logdecode.c restitue le format texte de traffic_simulation.log.
+// Les files sont journalisees par differences (ajout, retrait, changement de feu) entre deux
+// images cles completes (LOG_QUEUE_STATE suivi de ses LOG_QUEUE_VEHICLE) : le volume suit
+// l'activite et non le nombre de vehicules en attente, et l'etat a tout instant se reconstruit
+// depuis l'image cle precedente (logdecode --at).
+
+#define TRAFFIC_LOG_MAGIC 0x474F4C54u // "TLOG"
+#define TRAFFIC_LOG_VERSION 2 // 2 : files journalisees par differences
+
+// Nature d'un enregistrement
+typedef enum {
+    LOG_MESSAGE,         // Message fixe horodate (code : LogMessageCode)
+    LOG_QUEUE_STATE,     // En-tete d'etat d'une file
+    LOG_QUEUE_VEHICLE,   // Vehicule present dans la file decrite juste avant
+    LOG_VEHICLE_MOVED,   // Vehicule passe dans une voie de retour
+    LOG_VEHICLE_LOST,    // Vehicule perdu (voie de retour pleine)
+    LOG_VEHICLE_INVALID, // Donnees vehicule invalides
+    LOG_CREATE_FAILED,   // Creation de vehicule impossible
+    LOG_QUEUE_ADDED,     // Vehicule ajoute a une file (en queue, ou en tete pour une urgence)
+    LOG_QUEUE_REMOVED,   // Vehicule retire de la tete d'une file
+    LOG_QUEUE_SIGNAL     // Feu, embouteillage ou durees d'une file modifies depuis le dernier pas
+} LogRecordKind;
+
+// Drapeaux des enregistrements de file (args[2] de LOG_QUEUE_STATE, args[3] des differences)
+#define LOG_FLAG_GREEN 1   // Feu vert
+#define LOG_FLAG_JAM 2     // Embouteillage
+#define LOG_FLAG_RETURN 4  // File de retour
+#define LOG_FLAG_FRONT 8   // Ajout en tete (LOG_QUEUE_ADDED)
+
+// Messages fixes du journal
+typedef enum {
+    MSG_SIMULATION_START,   // "Debut simulation"
+    MSG_RUN_START,          // "Debut de la simulation"
+    MSG_RUN_END,            // "Fin de la simulation"
+    MSG_NORTH_SOUTH_GREEN,  // "Feu NORD-SUD -> VERT"
+    MSG_EAST_WEST_GREEN,    // "Feu EST-OUEST -> VERT"
+    MSG_TRAFFIC_JAM,        // "Embouteillage detecte !"
+    MSG_PHASE_CHANGE,       // "Changement de phase"
+    MSG_SEPARATOR,          // "------------------------"
+    MSG_NULL_VEHICLE,       // "ERREUR: Tentative d'ajouter un vehicule NULL"
+    MSG_QUEUE_FULL,         // "ERREUR: File pleine!"
+    MSG_QUEUE_EMPTY,        // "ERREUR: File vide!"
+    MSG_DEQUEUE_NULL,       // "ERREUR: Dequeue a retourne NULL dans une file non vide"
+    MSG_PREEMPTION,         // "Preemption : feu vert pour un vehicule d'urgence"
+    MSG_PREEMPTION_END,     // "Fin de preemption : reprise du cycle"
+    MSG_COUNT
+} LogMessageCode;
+
+const char* logMessageText(int code) {
+    static const char* texts[MSG_COUNT] = {
+        "Debut simulation",
+        "Debut de la simulation",
+        "Fin de la simulation",
+        "Feu NORD-SUD -> VERT",
+        "Feu EST-OUEST -> VERT",
+        "Embouteillage detecte !",
+        "Changement de phase",
+        "------------------------",
+        "ERREUR: Tentative d'ajouter un vehicule NULL",
+        "ERREUR: File pleine!",
+        "ERREUR: File vide!",
+        "ERREUR: Dequeue a retourne NULL dans une file non vide",
+        "Preemption : feu vert pour un vehicule d'urgence",
+        "Fin de preemption : reprise du cycle"
+    };
+    return (code >= 0 && code < MSG_COUNT) ? texts[code] : "Message inconnu";
+}
+
+// Enregistrement de 32 octets
+typedef struct {
+    long long wallTime;    // Heure reelle (secondes depuis l'epoque)
+    unsigned int simTime;  // Horloge virtuelle
+    unsigned short kind;   // LogRecordKind
+    unsigned short code;   // Message, ou direction de la file
+    int args[4];           // Parametres selon la nature
+} LogRecord;
+
+// En-tete du fichier binaire
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int recordSize;
+    unsigned int dropped;    // Enregistrements perdus (anneau plein), ecrit a la fermeture
+} LogFileHeader;
+
+// Case de l'anneau : le numero de sequence indique si elle est libre ou remplie
+typedef struct {
+    atomic_uint sequence;
+    LogRecord record;
+} LogSlot;
+
+typedef struct TrafficLog {
+    LogSlot* slots;
+    unsigned int mask;
+    _Alignas(64) atomic_uint enqueuePos;  // Producteurs
+    _Alignas(64) unsigned int dequeuePos; // Thread d'ecriture seulement
+    atomic_ulong dropped;                 // Enregistrements perdus (anneau plein)
+    atomic_int running;
+    unsigned int simTime;                 // Horloge virtuelle courante (mise a jour par la simulation)
+    FILE* file;
+    pthread_t writer;
+} TrafficLog;
+
+// Reserve une case et y copie l'enregistrement ; retourne 0 si l'anneau est plein
+int tryPushLogRecord(TrafficLog* log, const LogRecord* r) {
+    unsigned int pos = atomic_load_explicit(&log->enqueuePos, memory_order_relaxed);
+    while (1) {
+        LogSlot* slot = &log->slots[pos & log->mask];
+        unsigned int seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log->enqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->record = *r;
+                atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&log->enqueuePos, memory_order_relaxed);
+        }
+    }
+}
+
+// Ecrit dans le fichier les enregistrements disponibles ; retourne leur nombre
+int drainTrafficLog(TrafficLog* log) {
+    LogRecord batch[256];
+    int total = 0;
+    while (1) {
+        int n = 0;
+        while (n < 256) {
+            LogSlot* slot = &log->slots[log->dequeuePos & log->mask];
+            unsigned int seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+            if (seq != log->dequeuePos + 1) break;
+            batch[n++] = slot->record;
+            atomic_store_explicit(&slot->sequence, log->dequeuePos + log->mask + 1, memory_order_release);
+            log->dequeuePos++;
+        }
+        if (n == 0) break;
+        fwrite(batch, sizeof(LogRecord), (size_t)n, log->file);
+        total += n;
+    }
+    return total;
+}
+
+// Thread d'ecriture : vide l'anneau par lots, dort brievement quand il est vide
+void* trafficLogWriter(void* arg) {
+    TrafficLog* log = (TrafficLog*)arg;
+    while (atomic_load_explicit(&log->running, memory_order_acquire)) {
+        if (drainTrafficLog(log) == 0) {
+            fflush(log->file);
+            usleep(1000);
+        }
+    }
+    drainTrafficLog(log);
+    fflush(log->file);
+    return NULL;
+}
+
+// Ouvre un journal binaire et demarre son thread d'ecriture (NULL en cas d'echec)
+TrafficLog* openTrafficLog(const char* path, unsigned int capacity) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return NULL;
+    LogFileHeader header = { TRAFFIC_LOG_MAGIC, TRAFFIC_LOG_VERSION, sizeof(LogRecord), 0 };
+    fwrite(&header, sizeof(header), 1, file);
+
+    TrafficLog* log = (TrafficLog*)malloc(sizeof(TrafficLog));
+    unsigned int size = 1;
+    while (size < capacity) size <<= 1;
+    log->slots = (LogSlot*)malloc(sizeof(LogSlot) * size);
+    log->mask = size - 1;
+    for (unsigned int i = 0; i < size; i++) {
+        atomic_init(&log->slots[i].sequence, i);
+    }
+    atomic_init(&log->enqueuePos, 0);
+    log->dequeuePos = 0;
+    atomic_init(&log->dropped, 0);
+    atomic_init(&log->running, 1);
+    log->simTime = 0;
+    log->file = file;
+    pthread_create(&log->writer, NULL, trafficLogWriter, log);
+    return log;
+}
+
+// Arrete le thread d'ecriture apres avoir vide l'anneau, inscrit le nombre d'enregistrements
+// perdus dans l'en-tete, puis ferme le fichier
+void closeTrafficLog(TrafficLog* log) {
+    if (log == NULL) return;
+    atomic_store_explicit(&log->running, 0, memory_order_release);
+    pthread_join(log->writer, NULL);
+    unsigned long dropped = atomic_load_explicit(&log->dropped, memory_order_relaxed);
+    if (dropped > 0) {
+        unsigned int count = (dropped > 0xFFFFFFFFul) ? 0xFFFFFFFFu : (unsigned int)dropped;
+        fseek(log->file, (long)offsetof(LogFileHeader, dropped), SEEK_SET);
+        fwrite(&count, sizeof(count), 1, log->file);
+        printf("[ERREUR] %lu enregistrements du journal perdus (anneau plein) : "
+               "les files reconstruites par logdecode --at peuvent etre fausses\n", dropped);
+    }
+    fclose(log->file);
+    free(log->slots);
+    free(log);
+}
+
+// Construit et publie un enregistrement
+void writeLogRecord(TrafficLog* log, LogRecordKind kind, int code, int a0, int a1, int a2, int a3) {
+    if (log == NULL) return; // journalisation desactivee
+    LogRecord r;
+    r.wallTime = (long long)time(NULL);
+    r.simTime = log->simTime;
+    r.kind = (unsigned short)kind;
+    r.code = (unsigned short)code;
+    r.args[0] = a0;
+    r.args[1] = a1;
+    r.args[2] = a2;
+    r.args[3] = a3;
+    tryPushLogRecord(log, &r);
+}
+
+// Met a jour l'horloge virtuelle attachee aux enregistrements suivants
+void setTrafficLogTime(TrafficLog* log, unsigned long simTime) {
+    if (log != NULL) log->simTime = (unsigned int)simTime;
+}
+
+#endif // TRAFFICLOG_H
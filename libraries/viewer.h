@@ -0,0 +1,120 @@
+#ifndef VIEWER_H
+#define VIEWER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "engine.h"
+
+/* --- Visualisation decouplee : un thread affiche l'etat des voies a cadence fixe --- */
+// La simulation ne fait jamais d'affichage : quand le thread de visualisation demande une image
+// (au plus "fps" fois par seconde), elle recopie la taille des files et les feux dans le tampon
+// libre d'une paire, puis le publie. Le thread affiche le tampon publie pendant que la simulation
+// continue ; un terminal lent ne ralentit que lui. Hors demande, le cout par pas est une lecture atomique.
+
+// Image de l'etat des voies (les VIEWER_MAX_ROWS premieres intersections)
+typedef struct {
+    unsigned long simTime;
+    int count;                    // Intersections recopiees
+    int aller[VIEWER_MAX_ROWS][4];
+    int retour[VIEWER_MAX_ROWS][4];
+    unsigned char light[VIEWER_MAX_ROWS][4];
+} ViewerFrame;
+
+typedef struct {
+    ViewerFrame frames[2];  // Double tampon : la simulation ecrit l'un, le thread affiche l'autre
+    atomic_int published;   // Tampon lisible (-1 : aucune image)
+    atomic_int wanted;      // 1 : le thread attend une nouvelle image
+    atomic_int running;
+    int intersections;      // Intersections simulees (l'image n'en garde que VIEWER_MAX_ROWS)
+    int fps;
+    unsigned long shown;    // Images affichees
+    FILE* out;
+    pthread_t thread;
+} Viewer;
+
+// Affiche une image : une ligne par intersection (file aller / retour et feu de chaque voie)
+void renderViewerFrame(Viewer* v, const ViewerFrame* f) {
+    static const char* names[4] = {"N", "S", "E", "O"};
+    fprintf(v->out, "\n--- t=%lu ---\n", f->simTime);
+    for (int i = 0; i < f->count; i++) {
+        fprintf(v->out, "%4d |", i + 1);
+        for (int d = 0; d < 4; d++) {
+            fprintf(v->out, " %s%c %3d/%-3d", names[d], f->light[i][d] == GREEN ? '*' : ' ',
+                    f->aller[i][d], f->retour[i][d]);
+        }
+        fprintf(v->out, "\n");
+    }
+    if (v->intersections > f->count) {
+        fprintf(v->out, "     (%d intersections de plus non affichees)\n", v->intersections - f->count);
+    }
+    fflush(v->out);
+    v->shown++;
+}
+
+// Thread de visualisation : demande une image, attend la periode, affiche la derniere image publiee
+void* viewerThread(void* arg) {
+    Viewer* v = (Viewer*)arg;
+    useconds_t period = (useconds_t)(1000000 / v->fps);
+    atomic_store_explicit(&v->wanted, 1, memory_order_release);
+    while (atomic_load_explicit(&v->running, memory_order_acquire)) {
+        usleep(period);
+        // "wanted" repasse a 0 apres la publication : "published" est alors a jour
+        if (atomic_load_explicit(&v->wanted, memory_order_acquire)) continue; // rien de neuf
+        int p = atomic_load_explicit(&v->published, memory_order_acquire);
+        renderViewerFrame(v, &v->frames[p]);
+        atomic_store_explicit(&v->wanted, 1, memory_order_release); // le tampon "p" n'est plus lu
+    }
+    return NULL;
+}
+
+// Demarre la visualisation de "intersections" intersections a "fps" images par seconde
+int startViewer(Viewer* v, int intersections, int fps, FILE* out) {
+    v->intersections = intersections;
+    v->fps = (fps > 0) ? fps : 1;
+    v->shown = 0;
+    v->out = out;
+    atomic_init(&v->published, -1);
+    atomic_init(&v->wanted, 0);
+    atomic_init(&v->running, 1);
+    return pthread_create(&v->thread, NULL, viewerThread, v) == 0;
+}
+
+void stopViewer(Viewer* v) {
+    atomic_store_explicit(&v->running, 0, memory_order_release);
+    pthread_join(v->thread, NULL);
+}
+
+// Vrai si le thread attend une image (a tester une fois par pas ; NULL : pas de visualisation)
+int viewerWantsFrame(Viewer* v) {
+    return v != NULL && atomic_load_explicit(&v->wanted, memory_order_acquire);
+}
+
+// Tampon a remplir : celui qui n'est pas publie (le thread n'y touche pas tant que "wanted" vaut 1)
+ViewerFrame* viewerBackFrame(Viewer* v) {
+    int p = atomic_load_explicit(&v->published, memory_order_relaxed);
+    return &v->frames[(p == 0) ? 1 : 0];
+}
+
+// Recopie les voies de "x" a la ligne "row" de l'image
+void captureViewerRow(ViewerFrame* f, int row, Intersection* x) {
+    if (row >= VIEWER_MAX_ROWS) return;
+    for (int d = 0; d < x->numLanes; d++) {
+        f->aller[row][d] = x->lanes[d].aller->size;
+        f->retour[row][d] = x->lanes[d].retour->size;
+        f->light[row][d] = (unsigned char)x->lanes[d].aller->lightState;
+    }
+}
+
+// Publie le tampon rempli ; le thread l'affichera a sa prochaine periode
+void viewerPublish(Viewer* v, unsigned long simTime) {
+    ViewerFrame* f = viewerBackFrame(v);
+    f->simTime = simTime;
+    f->count = (v->intersections < VIEWER_MAX_ROWS) ? v->intersections : VIEWER_MAX_ROWS;
+    atomic_store_explicit(&v->published, (int)(f - v->frames), memory_order_release);
+    atomic_store_explicit(&v->wanted, 0, memory_order_release);
+}
+
+#endif // VIEWER_H
@@ -1,7 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-#include "libraries/queue.h"
+#include "libraries/parallel.h"
+#include "libraries/sweep.h"
+#include "libraries/checkpoint.h"
+#include "libraries/optimizer.h"
+#include "libraries/meso.h"
+
+int batchMode = 0;           // VARIABLE GLOBALE : mode sans menu (ni affichage dans la boucle, ni attente)
+Viewer* activeViewer = NULL; // VARIABLE GLOBALE : visualisation du mode sans menu (NULL : aucune)
 
 // Affiche le menu principal de la simulation 
 void displayMenu() {
@@ -10,7 +18,16 @@ void displayMenu() {
     printf("***************************************************\n\n");
     printf("* 1. Lancer la simulation                   |=>|  *\n");
     printf("* 2. SHOW HISTORY                           |X|   *\n");
-    printf("* 3. FERMER LE PROGRAMME                    |X|   *\n\n");
+    printf("* 3. FERMER LE PROGRAMME                    |X|   *\n");
+    printf("* 4. SIMULATION D'UN CORRIDOR               |=>|  *\n");
+    printf("* 5. RECHERCHE DANS L'HISTORIQUE            |?|   *\n");
+    printf("* 6. REPLICATIONS MONTE CARLO               |=>|  *\n");
+    printf("* 7. BALAYAGE DE PARAMETRES                 |=>|  *\n");
+    printf("* 8. REJOUER UNE DEMANDE ENREGISTREE        |=>|  *\n");
+    printf("* 9. REPRENDRE UNE SIMULATION SAUVEGARDEE   |=>|  *\n");
+    printf("* 10. RESEAU EN GRILLE (ORIGINE-DESTINATION) |=>| *\n");
+    printf("* 11. OPTIMISER LES FEUX DU CORRIDOR        |=>|  *\n");
+    printf("* 12. SIMULATION MESOSCOPIQUE (CELLULES)    |=>|  *\n\n");
     printf("***************************************************\n");
     printf("Votre choix: ");
 }
@@ -34,16 +51,14 @@ void printLaneStatus(lane* lanes[]) {
 
     for (int i = 0; i < 4; i++) {
         printf("%s : ", directions[i]);
-        Vehicule* current = lanes[i]->aller->first;
-        while (current != NULL) {
-            printf("[%s] ", vehicleTypeToString(current->type));
-            current = current->next;
+        Queue* aller = lanes[i]->aller;
+        for (int k = 0; k < aller->size; k++) {
+            printf("[%s] ", vehicleTypeToString(queueAt(aller, k)->type));
         }
         printf("\n%s (Retour) : ", directions[i]);
-        current = lanes[i]->retour->first;
-        while (current != NULL) {
-            printf("[%s] ", vehicleTypeToString(current->type));
-            current = current->next;
+        Queue* retour = lanes[i]->retour;
+        for (int k = 0; k < retour->size; k++) {
+            printf("[%s] ", vehicleTypeToString(queueAt(retour, k)->type));
         }
         printf("\n");
     }
@@ -51,133 +66,775 @@ void printLaneStatus(lane* lanes[]) {
 }
 
 // Fonction de simulation principale
-void runSimulation(TrafficHistoryStack* trafficHistory) {
-    srand(time(NULL));
-    printf("\n=========== Simulation demarree ===========\n");
-
+// Le temps est virtuel : les evenements (arrivees, phases, passages) sont traites sans attente reelle
+// Avec "checkpoint", l'intersection et l'historique en memoire reprennent l'etat sauvegarde et la
+// simulation continue pendant SIMULATION_DURATION secondes ; sinon elle part de zero et son etat
+// final est sauvegarde dans CHECKPOINT_PATH (une reprise n'ecrase pas la sauvegarde dont elle part)
+void runSimulation(TrafficHistoryStack* trafficHistory, const char* checkpoint) {
     // Creation du fichier journal
-    FILE* logFile = initializeLogFile();
-    logWithTimestamp(logFile, "Debut de la simulation");
-
-    // Creation des files de circulation
-    lane north_lane, south_lane, east_lane, west_lane;
-    Createlane(&north_lane, QUEUE_CAPACITY, 1, NORTH);
-    Createlane(&south_lane, QUEUE_CAPACITY, 2, SOUTH);
-    Createlane(&east_lane,  QUEUE_CAPACITY, 3, EAST);
-    Createlane(&west_lane,  QUEUE_CAPACITY, 4, WEST);
-
-    lane* lanes[] = {&north_lane, &south_lane, &east_lane, &west_lane};
-    int numLanes = 4;
+    TrafficLog* trafficLog = initializeLogFile();
 
-    // Initialisation de la file circulaire pour les feux de circulation
-    LLCircular trafficLightQueue;
-    initLLCircular(&trafficLightQueue);
-
-    enqueuePhase(&trafficLightQueue, NORTH_SOUTH_GREEN, BASE_GREEN_DURATION, BASE_RED_DURATION);
-    enqueuePhase(&trafficLightQueue, EAST_WEST_GREEN, BASE_GREEN_DURATION, BASE_RED_DURATION);
-
-    // Premier etat des feux
-    TrafficPhaseNode* currentPhaseNode = trafficLightQueue.front;
-    time_t phaseStartTime = time(NULL);
-    int simTime = 0;
+    // Creation de l'intersection (voies, anneau des phases et premiers evenements)
+    Intersection intersection;
+    unsigned long start = 0;
+    if (checkpoint != NULL) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (!loadIntersectionCheckpoint(checkpoint, &intersection, &activeScenario,
+                                        &trafficHistory->vehicles, trafficLog, trafficHistory)) {
+            printf("[ERREUR] Sauvegarde %s illisible ou incompatible avec le scenario.\n", checkpoint);
+            closeTrafficLog(trafficLog);
+            return;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        start = intersection.clock + TIME_INCREMENT;
+        printf("\nReprise de %s a t=%lu (%.2f ms)\n", checkpoint, start,
+               1000.0 * (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e6);
+    } else {
+        initIntersection(&intersection, 1, &activeScenario, activeScenario.seed,
+                         &trafficHistory->vehicles, trafficLog, trafficHistory);
+    }
+    printf("\n=========== Simulation demarree ===========\n");
+    if (trafficHistory->store != NULL) {
+        beginHistoryRun(trafficHistory->store);
+    }
+    logWithTimestamp(trafficLog, MSG_RUN_START);
+    lane** lanes = intersection.lanePtrs;
+    int numLanes = intersection.numLanes;
+    unsigned long end = start + (unsigned long)activeScenario.simulationDuration;
 
-    // Boucle de simulation
-    while (simTime < SIMULATION_DURATION) {
-        printSimulationHeader(simTime);
+    // Boucle de simulation : avance l'horloge virtuelle pas a pas pour l'affichage
+    for (unsigned long simTime = start; simTime < end; simTime += TIME_INCREMENT) {
+        TRACE_BEGIN(tick);
+        advanceIntersection(&intersection, simTime);
+        TrafficPhaseNode* currentPhaseNode = intersection.currentPhase;
 
-        // Affichage des feux
-        printf("\nFeu Nord-Sud: %s\n", (currentPhaseNode->phase == NORTH_SOUTH_GREEN) ? "GREEN" : "RED");
-        printf("Feu Est-Ouest: %s\n", (currentPhaseNode->phase == EAST_WEST_GREEN) ? "GREEN" : "RED");
+        TRACE_BEGIN(render);
+        if (batchMode) {
+            // Aucun affichage ici : le thread de visualisation demande une image de temps en temps
+            if (viewerWantsFrame(activeViewer)) {
+                captureViewerRow(viewerBackFrame(activeViewer), 0, &intersection);
+                viewerPublish(activeViewer, simTime);
+            }
+        } else {
+            printSimulationHeader((int)simTime);
 
-        logWithTimestamp(logFile, (currentPhaseNode->phase == NORTH_SOUTH_GREEN) ? 
-            "Feu NORD-SUD -> VERT" : "Feu EST-OUEST -> VERT");
+            // Affichage des feux
+            printf("\nFeu Nord-Sud: %s\n", (currentPhaseNode->phase == NORTH_SOUTH_GREEN) ? "GREEN" : "RED");
+            printf("Feu Est-Ouest: %s\n", (currentPhaseNode->phase == EAST_WEST_GREEN) ? "GREEN" : "RED");
+            printLaneStatus(lanes);
+        }
 
-        printLaneStatus(lanes);
+        logWithTimestamp(trafficLog, (currentPhaseNode->phase == NORTH_SOUTH_GREEN) ? 
+            MSG_NORTH_SOUTH_GREEN : MSG_EAST_WEST_GREEN);
+        TRACE_END(render, "render");
 
         // Verification des embouteillages
+        TRACE_BEGIN(jam);
         for (int i = 0; i < numLanes; i++) {
             if (detectTrafficJam(lanes[i]->aller)) {
-                printf("\n Embouteillage detecte sur voie %d !\n", lanes[i]->aller->id);
-                logWithTimestamp(logFile, "Embouteillage detecte !");
+                if (!batchMode) printf("\n Embouteillage detecte sur voie %d !\n", lanes[i]->aller->id);
+                logWithTimestamp(trafficLog, MSG_TRAFFIC_JAM);
             }
         }
+        TRACE_END(jam, "jam_check");
+    
+        // Files : image cle complete tous les LOG_KEYFRAME_INTERVAL pas, differences entre les deux
+        TRACE_BEGIN(queueLog);
+        int keyframe = ((simTime - start) % LOG_KEYFRAME_INTERVAL) == 0;
+        for (int i = 0; i < numLanes; i++) {
+            logQueueState(lanes[i]->aller, trafficLog, keyframe);
+            logQueueState(lanes[i]->retour, trafficLog, keyframe);
+        }
+        TRACE_END(queueLog, "log_queue_state");
+        TRACE_END(tick, "tick");
+    }
+
+    printf("\n============ Simulation terminee ============\n");
+    logWithTimestamp(trafficLog, MSG_RUN_END);
+    FILE* metrics = fopen(METRICS_SNAPSHOT_PATH, "w");
+    if (metrics != NULL) {
+        writeMetricsSnapshot(metrics, &intersection.metrics, intersection.id, end);
+        fclose(metrics);
+        printf("Metriques ecrites dans %s\n", METRICS_SNAPSHOT_PATH);
+    }
+    if (checkpoint == NULL) {
+        if (saveIntersectionCheckpoint(CHECKPOINT_PATH, &intersection, trafficHistory)) {
+            printf("Etat final sauvegarde dans %s\n", CHECKPOINT_PATH);
+        } else {
+            printf("[ERREUR] Impossible d'ecrire la sauvegarde %s\n", CHECKPOINT_PATH);
+        }
+    }
+    freeIntersection(&intersection);
+    closeTrafficLog(trafficLog);
+    if (!batchMode) getchar();
+}
 
-        // Generation aleatoire de vehicules
-        if (rand() % 100 < VEHICLE_GEN_PROB) {
-            int laneIndex = rand() % numLanes;
-            generateRandomVehicle(lanes[laneIndex]->aller, logFile, simTime,trafficHistory);
-        
-            // Add vehicle to traffic history after it's generated and added to a lane
-            time_t passTime = time(NULL);  // Vehicle passing time
-            
+// Simule un reseau deja construit pendant NETWORK_DURATION secondes a partir de "start"
+// "savePath" (NULL : aucune) recoit l'etat final ; le reseau est libere a la fin
+void runRoadNetwork(RoadNetwork* network, unsigned long start, DemandStream* demand, const char* title, const char* savePath) {
+    consoleOutput = 0; // pas d'affichage par vehicule en mode reseau
+    printf("\n=========== Simulation %s demarree (%d intersections, %d threads, feux %s) ===========\n",
+           title, network->count, activeScenario.networkThreads,
+           signalControllers[activeScenario.signalController].name);
+
+    if (demand != NULL) attachDemand(network, demand);
+    network->viewer = activeViewer;
+    unsigned long duration = start + (unsigned long)activeScenario.networkDuration;
+    // Un instantane des metriques de chaque intersection a chaque rapport
+    FILE* metrics = fopen(METRICS_SNAPSHOT_PATH, "w");
+    for (unsigned long simTime = start; simTime < duration; simTime += NETWORK_REPORT_INTERVAL) {
+        unsigned long end = simTime + NETWORK_REPORT_INTERVAL;
+        if (end > duration) end = duration;
+        runNetworkParallel(network, simTime, end, activeScenario.networkThreads);
+        if (!batchMode) printNetworkStatus(network);
+        for (int i = 0; metrics != NULL && i < network->count; i++) {
+            writeMetricsSnapshot(metrics, &network->nodes[i].metrics, network->nodes[i].id, end);
+        }
+    }
+    if (metrics != NULL) {
+        fclose(metrics);
+        printf("Metriques ecrites dans %s\n", METRICS_SNAPSHOT_PATH);
+    }
+    printf("Empreinte de l'etat final: %016llx\n", networkFingerprint(network));
+    size_t poolBytesUsed;
+    long liveVehicles;
+    networkPoolUsage(network, &poolBytesUsed, &liveVehicles);
+    printf("Memoire vehicules: %zu octets reserves, %ld vehicules vivants (%zu octets par vehicule)\n",
+           poolBytesUsed, liveVehicles, sizeof(Vehicule));
+    if (demand != NULL) {
+        unsigned long rejected = 0;
+        for (int i = 0; i < network->count; i++) {
+            rejected += network->nodes[i].rejectedArrivals;
         }
+        printf("Demande relue: %llu arrivees, %llu invalides, %llu hors reseau, %lu refusees (file pleine)\n",
+               demand->records, demand->invalid, demand->skipped, rejected);
+    }
+    if (network->nodes[0].od != NULL) {
+        unsigned long arrived = 0, exited, received, blocked;
+        for (int i = 0; i < network->count; i++) arrived += network->nodes[i].arrivedVehicles;
+        networkTotals(network, &exited, &received, &blocked);
+        printf("Trajets: %lu arrives a destination, %lu transferts entre intersections, %ld vehicules en route\n",
+               arrived, received, liveVehicles);
+    }
 
-        // Ajustement des feux en fonction du trafic
-        LightDurations adjustedDurations;
-        if (currentPhaseNode->phase == NORTH_SOUTH_GREEN) {
-            adjustedDurations = adjustLightDurationsForPair(north_lane.aller, south_lane.aller);
+    if (savePath != NULL) {
+        if (saveNetworkCheckpoint(savePath, network)) {
+            printf("Etat final sauvegarde dans %s\n", savePath);
         } else {
-            adjustedDurations = adjustLightDurationsForPair(east_lane.aller, west_lane.aller);
-        }
-        currentPhaseNode->greenDuration = adjustedDurations.greenDuration;
-        currentPhaseNode->redDuration = adjustedDurations.redDuration;
-
-        // Verification du changement de phase
-        time_t currentTime = time(NULL);
-        int elapsed = (int)difftime(currentTime, phaseStartTime);
-        if (elapsed >= currentPhaseNode->greenDuration) {
-            TrafficPhaseNode* nextPhase = dequeuePhase(&trafficLightQueue);
-            if (nextPhase != NULL) {
-                currentPhaseNode = nextPhase;
-                logWithTimestamp(logFile, "Changement de phase");
-            }
-            phaseStartTime = currentTime;
+            printf("[ERREUR] Impossible d'ecrire la sauvegarde %s\n", savePath);
         }
+    }
 
-        // Traitement des vehicules
-        for (int i = 0; i < numLanes; i++) {
-            processQueue(lanes[i]->aller, logFile,trafficHistory, &simTime, lanes, numLanes);
+    printf("\n============ Simulation %s terminee ============\n", title);
+    freeRoadNetwork(network);
+    consoleOutput = !batchMode;
+}
+
+// Simulation d'un corridor d'intersections : les voies de retour alimentent les intersections voisines
+// Avec "demand", les arrivees sont relues dans la demande enregistree au lieu d'etre tirees au hasard
+// Avec "checkpoint", le reseau sauvegarde continue pendant NETWORK_DURATION secondes ; sinon il part
+// de zero et son etat final est sauvegarde dans CORRIDOR_CHECKPOINT_PATH, sauf en rejeu : la position
+// dans la demande n'est pas conservee et la reprise passerait aux arrivees aleatoires
+void runCorridorSimulation(DemandStream* demand, const char* checkpoint) {
+    RoadNetwork network;
+    unsigned long start = 0;
+    if (checkpoint != NULL) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (!loadNetworkCheckpoint(checkpoint, &network, &activeScenario)) {
+            printf("[ERREUR] Sauvegarde %s illisible ou incompatible avec le scenario.\n", checkpoint);
+            return;
         }
-    
-        for (int i = 0; i < numLanes; i++) {
-            logQueueState(lanes[i]->aller, logFile, "Aller");
-            logQueueState(lanes[i]->retour, logFile, "Retour");
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        start = network.clock + TIME_INCREMENT;
+        printf("\nReprise de %s a t=%lu (%.2f ms)\n", checkpoint, start,
+               1000.0 * (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e6);
+    } else {
+        buildCorridor(&network, activeScenario.networkSize, &activeScenario, activeScenario.seed);
+    }
+    const char* savePath = (checkpoint == NULL && demand == NULL) ? CORRIDOR_CHECKPOINT_PATH : NULL;
+    if (checkpoint == NULL && demand != NULL) {
+        printf("Rejeu de demande : etat final non sauvegarde (la reprise ne retrouverait pas la demande)\n");
+    }
+    runRoadNetwork(&network, start, demand, "corridor", savePath);
+}
+
+// Reseau genere : grille de GRID_ROWS x GRID_COLS intersections, ou graphe lu dans la liste de
+// routes "edges" (NULL : grille). Les vehicules suivent des trajets origine-destination (modele
+// gravitaire) le long des routes de la table des prochains sauts, calculee une fois en parallele
+// Retourne 0 si le graphe ne peut pas etre construit
+int runGridSimulation(const char* edges) {
+    RoadGraph graph;
+    if (edges != NULL) {
+        if (!loadEdgeListGraph(&graph, edges, activeScenario.linkTravelTime)) {
+            printf("[ERREUR] Liste de routes %s illisible ou invalide\n", edges);
+            return 0;
+        }
+        printf("\nGraphe %s : %d intersections\n", edges, graph.count);
+    } else {
+        if (!buildGridGraph(&graph, activeScenario.gridRows, activeScenario.gridCols, activeScenario.linkTravelTime)) {
+            printf("[ERREUR] Memoire insuffisante pour la grille\n");
+            return 0;
         }
+        printf("\nGrille %d x %d : %d intersections\n", graph.rows, graph.cols, graph.count);
+    }
+    RouteTable routes;
+    OdDemand od;
+    int threads = availableCores();
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (!buildRouteTable(&routes, &graph, threads)) {
+        printf("[ERREUR] Memoire insuffisante pour la table de routage\n");
+        freeRoadGraph(&graph);
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("Table des prochains sauts : %.2f Mo, calculee en %.3f s (%d threads)\n",
+           (double)routeTableBytes(&routes) / (1024.0 * 1024.0),
+           (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9, threads);
+    if (!buildOdDemand(&od, &graph, &activeScenario)) {
+        printf("[ERREUR] Memoire insuffisante pour la demande origine-destination\n");
+        freeRouteTable(&routes);
+        freeRoadGraph(&graph);
+        return 0;
+    }
+    printf("Demande origine-destination : %d zones, %.0f trajets/h\n", od.zones, od.tripsPerHour);
+
+    RoadNetwork network;
+    buildGraphNetwork(&network, &graph, &activeScenario, activeScenario.seed);
+    attachRouting(&network, &routes, &od);
+    // Pas de sauvegarde : la table de routage et la demande ne sont pas conservees
+    runRoadNetwork(&network, 0, NULL, "grille", NULL);
+    freeOdDemand(&od);
+    freeRouteTable(&routes);
+    freeRoadGraph(&graph);
+    return 1;
+}
+
+void runGridSimulationMenu() {
+    char path[256];
+    printf("\nListe de routes (Entree: grille %d x %d): ", activeScenario.gridRows, activeScenario.gridCols);
+    if (fgets(path, sizeof(path), stdin) == NULL) return;
+    char* chosen = trimSpaces(path);
+    runGridSimulation((*chosen == '\0') ? NULL : chosen);
+}
 
-        sleep(1);
-        simTime++;
+// Moteur mesoscopique (modele de transmission cellulaire) sur le corridor de NETWORK_SIZE
+// intersections ("grid" = 0), la grille GRID_ROWS x GRID_COLS ou le graphe de la liste de routes
+// "edges". Feux fixes et metriques par voie du moteur par vehicule, a une fraction du cout
+// Retourne 0 si le reseau ne peut pas etre construit ou si le controleur de feux n'est pas modelise
+int runMesoSimulation(int grid, const char* edges) {
+    RoadGraph graph;
+    const char* title = "corridor";
+    int built;
+    if (edges != NULL) {
+        built = loadEdgeListGraph(&graph, edges, activeScenario.linkTravelTime);
+        title = edges;
+    } else if (grid) {
+        built = buildGridGraph(&graph, activeScenario.gridRows, activeScenario.gridCols, activeScenario.linkTravelTime);
+        title = "grille";
+    } else {
+        // Corridor : une ligne d'intersections reliees d'est en ouest, comme buildCorridor
+        built = buildGridGraph(&graph, 1, activeScenario.networkSize, activeScenario.linkTravelTime);
+    }
+    if (!built) {
+        printf("[ERREUR] Reseau %s illisible ou memoire insuffisante\n", title);
+        return 0;
+    }
+    const char* unsupported = mesoUnsupportedScenario(&activeScenario);
+    if (unsupported != NULL) {
+        printf("[ERREUR] Feux %s : %s\n", signalControllers[activeScenario.signalController].name, unsupported);
+        freeRoadGraph(&graph);
+        return 0;
+    }
+    if (activeScenario.emergencyPreemption) {
+        printf("Preemption des urgences non modelisee par le moteur mesoscopique (EMERGENCY_PREEMPTION ignore)\n");
+    }
+    if (grid || edges != NULL) {
+        printf("Virages uniformes : les trajets origine-destination du mode grille ne sont pas modelises\n");
     }
+    MesoNetwork meso;
+    if (!buildMesoNetwork(&meso, &graph, &activeScenario)) {
+        printf("[ERREUR] Memoire insuffisante pour le reseau mesoscopique\n");
+        freeRoadGraph(&graph);
+        return 0;
+    }
+    freeRoadGraph(&graph);
+    printf("\n=========== Simulation mesoscopique %s demarree (%d intersections, %d cellules, %.2f veh/s au vert) ===========\n",
+           title, meso.count, meso.cellCount, meso.saturationFlow / TIME_INCREMENT);
 
-    printf("\n============ Simulation terminee ============\n");
-    logWithTimestamp(logFile, "Fin de la simulation");
-    fclose(logFile);
+    unsigned long duration = (unsigned long)activeScenario.networkDuration;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    FILE* metrics = fopen(METRICS_SNAPSHOT_PATH, "w");
+    for (unsigned long simTime = 0; simTime < duration; simTime += NETWORK_REPORT_INTERVAL) {
+        unsigned long end = simTime + NETWORK_REPORT_INTERVAL;
+        if (end > duration) end = duration;
+        runMesoNetwork(&meso, simTime, end);
+        if (!batchMode) printMesoStatus(&meso);
+        for (int i = 0; metrics != NULL && i < meso.count; i++) {
+            writeMesoSnapshot(metrics, &meso, i, end);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (metrics != NULL) {
+        fclose(metrics);
+        printf("Metriques ecrites dans %s\n", METRICS_SNAPSHOT_PATH);
+    }
+    double served, refused, present;
+    mesoTotals(&meso, &served, &refused, &present);
+    printf("Vehicules : %.0f passes au feu, %.0f refuses (file pleine), %.0f sortis du reseau, %.0f en route\n",
+           served, refused, meso.exited, present);
+    printf("%lu pas simules en %.3f s\n", meso.samples,
+           (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9);
+    printf("\n============ Simulation mesoscopique terminee ============\n");
+    freeMesoNetwork(&meso);
+    return 1;
+}
+
+void runMesoSimulationMenu() {
+    char path[256];
+    printf("\nReseau (Entree: corridor de %d, G: grille %d x %d, sinon liste de routes): ",
+           activeScenario.networkSize, activeScenario.gridRows, activeScenario.gridCols);
+    if (fgets(path, sizeof(path), stdin) == NULL) return;
+    char* chosen = trimSpaces(path);
+    if (*chosen == '\0') runMesoSimulation(0, NULL);
+    else if (strcmp(chosen, "G") == 0 || strcmp(chosen, "g") == 0) runMesoSimulation(1, NULL);
+    else runMesoSimulation(1, chosen);
+}
+
+// Corridor alimente par une demande enregistree (CSV ou binaire produit par tools/demandpack)
+// Retourne 0 si la demande est illisible
+int runDemandReplay(const char* chosen) {
+    DemandStream demand;
+    if (!openDemandStream(&demand, chosen)) {
+        printf("[ERREUR] Impossible de lire la demande %s\n", chosen);
+        return 0;
+    }
+    printf("Demande %s (%s)\n", chosen, demand.binary ? "binaire" : "CSV");
+    runCorridorSimulation(&demand, NULL);
+    closeDemandStream(&demand);
+    return 1;
+}
+
+void runDemandReplayMenu() {
+    char path[256];
+    printf("\nFichier de demande (Entree: %s): ", DEMAND_PATH);
+    if (fgets(path, sizeof(path), stdin) == NULL) return;
+    char* chosen = trimSpaces(path);
+    runDemandReplay((*chosen == '\0') ? DEMAND_PATH : chosen);
+}
+
+// Reprise d'une sauvegarde (intersection ou corridor) avec le scenario courant : la sauvegarde
+// n'est pas modifiee, si bien que plusieurs variantes peuvent partir du meme etat
+// Retourne 0 si le fichier n'est pas une sauvegarde
+int resumeCheckpoint(TrafficHistoryStack* trafficHistory, const char* chosen) {
+    CheckpointFile f;
+    CheckpointHeader header;
+    if (!readCheckpointHeader(&f, chosen, &header)) {
+        printf("[ERREUR] %s n'est pas une sauvegarde lisible.\n", chosen);
+        return 0;
+    }
+    fclose(f.file);
+    if (header.kind == CHECKPOINT_NETWORK) {
+        runCorridorSimulation(NULL, chosen);
+    } else {
+        runSimulation(trafficHistory, chosen);
+    }
+    return 1;
+}
+
+void runCheckpointMenu(TrafficHistoryStack* trafficHistory) {
+    char path[256];
+    printf("\nFichier de sauvegarde (Entree: %s, corridor: %s): ", CHECKPOINT_PATH, CORRIDOR_CHECKPOINT_PATH);
+    if (fgets(path, sizeof(path), stdin) == NULL) return;
+    char* chosen = trimSpaces(path);
+    resumeCheckpoint(trafficHistory, (*chosen == '\0') ? CHECKPOINT_PATH : chosen);
+}
+
+// Affiche une mesure sous la forme "moyenne +/- demi-largeur"
+void printEstimate(Estimate e) {
+    printf(" %9.2f +/- %-7.2f", e.mean, e.halfWidth);
+}
+
+// Replications independantes du scenario de l'intersection, agregees en intervalles de confiance a 95%
+void runMonteCarloSimulation() {
+    consoleOutput = 0; // pas d'affichage par vehicule pendant les replications
+    int replications = activeScenario.replications;
+    int threads = (activeScenario.replicationThreads > 0) ? activeScenario.replicationThreads : availableCores();
+    printf("\n=========== Replications Monte Carlo (%d x %d s, %d threads) ===========\n",
+           replications, activeScenario.replicationDuration, threads);
+
+    ReplicationResult* results = (ReplicationResult*)malloc(sizeof(ReplicationResult) * replications);
+    if (results == NULL) {
+        printf("[ERREUR] Memoire insuffisante pour les replications.\n");
+        consoleOutput = !batchMode;
+        return;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    runReplications(&activeScenario, results, threads);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    char* directions[] = {"Nord", "Sud", "Est", "Ouest", "Total"};
+    printf("\nVoie   ");
+    for (int m = 0; m < LANE_METRIC_COUNT; m++) {
+        printf(" %-20s", laneMetricNames[m]);
+    }
+    printf("\n");
+    for (int i = 0; i <= INTERSECTION_TOTAL; i++) {
+        printf("%-7s", directions[i]);
+        for (int m = 0; m < LANE_METRIC_COUNT; m++) {
+            printEstimate(estimateLaneMetric(results, replications, i, laneMetricOffsets[m]));
+        }
+        printf("\n");
+    }
+    printf("\nIntervalles de confiance a 95%% sur %d replications (%.2f s)\n",
+           replications, elapsed);
+    free(results);
+    consoleOutput = !batchMode;
+}
+
+// Recherche d'un plan de feux (vert, cycle et decalage par intersection) pour le corridor du scenario
+// Le plan trouve est ecrit dans OPTIMIZER_PLAN_PATH ; retourne 0 si l'optimisation a echoue
+int runSignalOptimizer() {
+    consoleOutput = 0;
+    int threads = (activeScenario.optimizerThreads > 0) ? activeScenario.optimizerThreads : availableCores();
+    printf("\n=========== Optimisation des feux : %d intersections, %d tours x %d variantes (%d threads) ===========\n",
+           activeScenario.networkSize, activeScenario.optimizerRounds, activeScenario.optimizerCandidates, threads);
+    printf("Etat chauffe : %d s avec les feux %s, evaluation sur %d s\n", activeScenario.optimizerWarmup,
+           signalControllers[activeScenario.signalController].name, activeScenario.optimizerHorizon);
+
+    TimingPlan best;
+    OptimizerReport report;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ok = optimizeSignalTiming(&activeScenario, &best, &report, batchMode ? NULL : stdout);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    consoleOutput = !batchMode;
+    if (!ok) {
+        printf("[ERREUR] Impossible de sauvegarder ou de relire l'etat chauffe (%s)\n", OPTIMIZER_WARM_PATH);
+        return 0;
+    }
+
+    printf("\nIntersection  Cycle  Vert N-S  Vert E-O  Decalage\n");
+    for (int i = 0; i < best.count; i++) {
+        const SignalTiming* t = &best.timings[i];
+        printf("%12d  %5d  %8d  %8d  %8d\n", i, t->cycle, t->green, t->cycle - t->green, t->offset);
+    }
+    const PlanScore* rows[] = {&report.baseline, &report.initial, &report.best};
+    const char* names[] = {"Feux du scenario", "Plan de depart", "Meilleur plan"};
+    printf("\n%-18s %14s %12s %12s\n", "", "Retard (veh.h)", "Veh. servis", "Veh. refuses");
+    for (int r = 0; r < 3; r++) {
+        printf("%-18s %14.1f %12lu %12lu\n", names[r], rows[r]->delay[OPTIMIZER_SEGMENTS - 1] / 3600.0,
+               rows[r]->served, rows[r]->refused);
+    }
+    double baseline = report.baseline.delay[OPTIMIZER_SEGMENTS - 1];
+    if (baseline > 0.0) {
+        printf("Reduction du retard par rapport aux feux du scenario : %.1f%%\n",
+               100.0 * (baseline - report.best.delay[OPTIMIZER_SEGMENTS - 1]) / baseline);
+    }
+    printf("%d variantes evaluees, %d abandonnees avant la fin, %d ameliorations (%.2f s)\n",
+           report.evaluated, report.pruned, report.improvements,
+           (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9);
+    if (writeTimingPlan(OPTIMIZER_PLAN_PATH, &best)) printf("Plan ecrit dans %s\n", OPTIMIZER_PLAN_PATH);
+    else printf("[ERREUR] Impossible d'ecrire %s\n", OPTIMIZER_PLAN_PATH);
+    freeTimingPlan(&best);
+    return 1;
+}
+
+// Balayage de parametres : chaque scenario du fichier est evalue par des replications Monte Carlo
+// Retourne 0 si le plan est invalide ou si les resultats n'ont pas pu etre ecrits
+int runParameterSweepFile(const char* chosen) {
+    SweepPlan plan;
+    if (!loadSweepFile(&plan, chosen, &activeScenario)) return 0;
+    int threads = (plan.base.replicationThreads > 0) ? plan.base.replicationThreads : availableCores();
+    printf("\n=========== Balayage : %ld scenarios x %d replications (%d threads) ===========\n",
+           plan.points, plan.base.replications, threads);
+
+    consoleOutput = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ok = runParameterSweep(&plan, threads, SWEEP_RESULTS_PATH);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    consoleOutput = !batchMode;
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    if (ok) {
+        printf("\nResultats de l'intersection entiere (IC 95%%) ecrits dans %s (%.2f s)\n",
+               SWEEP_RESULTS_PATH, elapsed);
+    }
+    freeSweepPlan(&plan);
+    return ok;
+}
+
+void runParameterSweepMenu() {
+    char path[256];
+    printf("\nFichier de balayage (Entree: %s): ", SWEEP_PATH);
+    if (fgets(path, sizeof(path), stdin) == NULL) return;
+    char* chosen = trimSpaces(path);
+    runParameterSweepFile((*chosen == '\0') ? SWEEP_PATH : chosen);
+}
+
+// Affiche un enregistrement de l'historique persistant (limite aux premiers resultats)
+void printHistoryRecord(const HistoryRecord* r, void* ctx) {
+    int* shown = (int*)ctx;
+    if (*shown >= HISTORY_QUERY_MAX_SHOWN) return;
+    (*shown)++;
+    printf("Simulation %u | ID: %d | Type: %s | Direction: %s | Arrivee: %u | Entree file: %u\n",
+           r->run, r->vehicleId, typeToString(r->type), dirToString(r->origin),
+           r->arrivalTime, r->time);
+}
+
+// Compte, dans l'historique en memoire, les vehicules repondant au critere (sans identifiant :
+// les cumuls ne gardent que l'origine et le type)
+void summarizeRecentHistory(TrafficHistoryStack* history, const HistoryQuery* query) {
+    if (query->vehicleId >= 0) return;
+    HistorySummary s = summarizeHistoryRetention(&history->recent, query->fromTime, query->toTime);
+    unsigned long long matches = 0;
+    for (int o = 0; o < 4; o++) {
+        if (query->origin >= 0 && query->origin != o) continue;
+        for (int t = 0; t < 4; t++) {
+            if (query->type >= 0 && query->type != t) continue;
+            matches += s.counts[o][t];
+        }
+    }
+    printf("Historique en memoire : %llu vehicule(s), %.2f veh/min sur t=%u..%u", matches,
+           historyRatePerMinute(&s, matches), s.firstTime, s.lastTime);
+    if (s.resolution > 0) printf(" (cumuls par tranches de %u s)", s.resolution);
+    printf("\n");
+}
+
+// Recherche dans l'historique persistant par identifiant, origine, type et intervalle de dates
+// puis dans l'historique en memoire (enregistrements recents et cumuls)
+void searchTrafficHistory(TrafficHistoryStack* history) {
+    HistoryStore* store = history->store;
+    HistoryQuery query;
+    printf("\nIdentifiant du vehicule (-1: tous): ");
+    scanf("%d", &query.vehicleId);
+    printf("Origine (-1: toutes, 0: Nord, 1: Sud, 2: Est, 3: Ouest): ");
+    scanf("%d", &query.origin);
+    printf("Type (-1: tous, 0: Voiture, 1: Bus, 2: Moto, 3: Urgence): ");
+    scanf("%d", &query.type);
+    printf("Debut et fin de l'intervalle (en secondes simulees): ");
+    scanf("%u %u", &query.fromTime, &query.toTime);
     getchar();
+
+    summarizeRecentHistory(history, &query);
+    if (store == NULL) {
+        printf("\n[ERREUR] Historique persistant indisponible.\n");
+        return;
+    }
+    int shown = 0;
+    clock_t start = clock();
+    long long matches = queryHistoryStore(store, &query, printHistoryRecord, &shown);
+    double elapsedMs = 1000.0 * (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("\n%lld resultat(s) sur %llu enregistrements (%.3f ms)\n",
+           matches, historyRecordCount(store), elapsedMs);
+}
+
+// Affiche les options du mode sans menu
+void printBatchUsage(const char* program) {
+    printf("Usage : %s --run MODE [options]\n", program);
+    printf("  --run intersection|corridor|grid|optimize|meso|meso-grid|montecarlo|sweep|replay|resume\n");
+    printf("  --scenario FICHIER   scenario a charger (defaut : %s)\n", SCENARIO_PATH);
+    printf("  --input FICHIER      balayage, demande, sauvegarde ou liste d'aretes selon le mode\n");
+    printf("  --set NOM=VALEUR     remplace un parametre du scenario (repetable)\n");
+    printf("  --view [FPS]         affiche un apercu des files a FPS images/s (defaut : %d)\n", VIEWER_FPS);
+}
+
+// Applique "NOM=VALEUR" au scenario actif ; retourne 0 si le parametre est inconnu ou invalide
+int applyScenarioOverride(char* text) {
+    char *name, *value;
+    if (!splitScenarioLine(text, &name, &value) || value == NULL) return 0;
+    const ScenarioParam* p = findScenarioParam(name);
+    char* end = NULL;
+    double number = strtod(value, &end);
+    if (p == NULL || end == value || *end != '\0') return 0;
+    ScenarioConfig changed = activeScenario;
+    if (p->type == PARAM_SEED) changed.seed = strtoull(value, NULL, 10);
+    else if (!setScenarioValue(&changed, p, number)) return 0;
+    if (!validateScenario(&changed)) return 0;
+    activeScenario = changed;
+    return 1;
+}
+
+// Mode sans menu : une seule simulation, aucun affichage dans la boucle, aucune attente clavier
+// Retourne le code de sortie du programme
+int runBatch(int argc, char** argv, TrafficHistoryStack* trafficHistory) {
+    const char* mode = NULL;
+    const char* scenario = NULL; // defaut : SCENARIO_PATH s'il existe
+    const char* input = NULL;
+    int fps = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "--run") == 0 && i + 1 < argc) mode = argv[++i];
+        else if (strcmp(a, "--scenario") == 0 && i + 1 < argc) scenario = argv[++i];
+        else if (strcmp(a, "--input") == 0 && i + 1 < argc) input = argv[++i];
+        else if (strcmp(a, "--set") == 0 && i + 1 < argc) i++; // applique apres le scenario
+        else if (strcmp(a, "--view") == 0) {
+            fps = VIEWER_FPS;
+            if (i + 1 < argc && argv[i + 1][0] != '-') fps = atoi(argv[++i]);
+        } else {
+            printBatchUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (mode == NULL) {
+        printBatchUsage(argv[0]);
+        return 2;
+    }
+    if (loadScenarioFile(&activeScenario, scenario ? scenario : SCENARIO_PATH)) {
+        printf("Scenario charge depuis %s\n", scenario ? scenario : SCENARIO_PATH);
+    } else if (scenario != NULL) {
+        printf("[ERREUR] Scenario %s absent ou invalide\n", scenario);
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--set") == 0 && i + 1 < argc && !applyScenarioOverride(argv[++i])) {
+            printf("[ERREUR] Parametre invalide : %s\n", argv[i]);
+            return 2;
+        }
+    }
+    resizeHistoryRetention(&trafficHistory->recent, (size_t)activeScenario.historyMemoryLimit);
+
+    batchMode = 1;
+    consoleOutput = 0;
+    Viewer viewer;
+    int intersections = (strcmp(mode, "intersection") == 0) ? 1 : activeScenario.networkSize;
+    if (strcmp(mode, "grid") == 0) intersections = activeScenario.gridRows * activeScenario.gridCols;
+    // Le moteur mesoscopique n'alimente pas la visualisation (pas de files de vehicules)
+    if (fps > 0 && strncmp(mode, "meso", 4) != 0 && startViewer(&viewer, intersections, fps, stdout)) activeViewer = &viewer;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ok = 1;
+    if (strcmp(mode, "intersection") == 0) runSimulation(trafficHistory, NULL);
+    else if (strcmp(mode, "corridor") == 0) runCorridorSimulation(NULL, NULL);
+    else if (strcmp(mode, "grid") == 0) ok = runGridSimulation(input);
+    else if (strcmp(mode, "optimize") == 0) ok = runSignalOptimizer();
+    else if (strcmp(mode, "meso") == 0) ok = runMesoSimulation(0, input);
+    else if (strcmp(mode, "meso-grid") == 0) ok = runMesoSimulation(1, input);
+    else if (strcmp(mode, "montecarlo") == 0) runMonteCarloSimulation();
+    else if (strcmp(mode, "sweep") == 0) ok = runParameterSweepFile(input ? input : SWEEP_PATH);
+    else if (strcmp(mode, "replay") == 0) ok = runDemandReplay(input ? input : DEMAND_PATH);
+    else if (strcmp(mode, "resume") == 0) ok = resumeCheckpoint(trafficHistory, input ? input : CHECKPOINT_PATH);
+    else {
+        printf("[ERREUR] Mode inconnu : %s\n", mode);
+        ok = -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (activeViewer != NULL) {
+        stopViewer(activeViewer);
+        printf("%lu images affichees\n", activeViewer->shown);
+        activeViewer = NULL;
+    }
+    if (ok < 0) {
+        printBatchUsage(argv[0]);
+        return 2;
+    }
+    printf("Duree d'execution : %.3f s\n",
+           (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9);
+    return ok ? 0 : 1;
 }
 
 // La fonction main
-int main() {
+int main(int argc, char** argv) {
     int choice;
     TrafficHistoryStack trafficHistory;
-    initTrafficHistory(&trafficHistory);
+    initTrafficHistory(&trafficHistory, (size_t)activeScenario.historyMemoryLimit); // ajustee au scenario charge
+
+    // Historique persistant : conserve d'une execution a l'autre
+    HistoryStore historyStore;
+    if (openHistoryStore(&historyStore, HISTORY_STORE_PATH)) {
+        trafficHistory.store = &historyStore;
+    } else {
+        printf("[ERREUR] Impossible d'ouvrir l'historique persistant %s (fichiers illisibles, tronques ou d'un autre format)\n",
+               HISTORY_STORE_PATH);
+        closeHistoryStore(&historyStore);
+    }
+
+    // Avec des arguments : execution sans menu (scripts, mesures), le scenario est charge par runBatch
+    if (argc > 1) {
+#if TRACE_ENABLED
+        traceStart();
+#endif
+        int status = runBatch(argc, argv, &trafficHistory);
+#if TRACE_ENABLED
+        traceStop();
+        long spans = writeChromeTrace(TRACE_PATH);
+        if (spans > 0) printf("Trace ecrite dans %s (%ld intervalles)\n", TRACE_PATH, spans);
+#endif
+        if (trafficHistory.store != NULL) closeHistoryStore(trafficHistory.store);
+        freeTrafficHistory(&trafficHistory);
+        return status;
+    }
+
+    // Scenario : les valeurs de config.h sont remplacees par celles du fichier s'il existe
+    if (loadScenarioFile(&activeScenario, SCENARIO_PATH)) {
+        printf("Scenario charge depuis %s\n", SCENARIO_PATH);
+        resizeHistoryRetention(&trafficHistory.recent, (size_t)activeScenario.historyMemoryLimit);
+    }
     do {
         displayMenu();
         scanf("%d", &choice);
         getchar();
+#if TRACE_ENABLED
+        traceStart(); // chaque choix du menu est trace ; la trace remplace la precedente
+#endif
         switch (choice) {
             case 1:
-                runSimulation(&trafficHistory);
+                runSimulation(&trafficHistory, NULL);
                 break;
             case 2:
                 printTrafficHistory(&trafficHistory);
                 break;
             case 3:
                 printf("\nFermeture du programme...\n");
+                if (trafficHistory.store != NULL) {
+                    closeHistoryStore(trafficHistory.store);
+                }
+                freeTrafficHistory(&trafficHistory);
                 exit(0);
+            case 4:
+                runCorridorSimulation(NULL, NULL);
+                break;
+            case 5:
+                searchTrafficHistory(&trafficHistory);
+                break;
+            case 6:
+                runMonteCarloSimulation();
+                break;
+            case 7:
+                runParameterSweepMenu();
+                break;
+            case 8:
+                runDemandReplayMenu();
+                break;
+            case 9:
+                runCheckpointMenu(&trafficHistory);
+                break;
+            case 10:
+                runGridSimulationMenu();
+                break;
+            case 11:
+                runSignalOptimizer();
+                break;
+            case 12:
+                runMesoSimulationMenu();
+                break;
             default:
                 printf("\nChoix invalide ! Appuyez sur Entree pour continuer...");
                 getchar();
         }
+#if TRACE_ENABLED
+        traceStop();
+        long spans = writeChromeTrace(TRACE_PATH);
+        if (spans > 0) printf("Trace ecrite dans %s (%ld intervalles)\n", TRACE_PATH, spans);
+#endif
     } while (1);
-    clearTrafficHistory(&trafficHistory);
+    freeTrafficHistory(&trafficHistory);
     return 0;
 }
@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* --- Tests de non-regression des bibliotheques --- */
+// Usage : tests (code de sortie : nombre de tests en echec)
+// Chaque test est une fonction qui verifie ses conditions avec CHECK ; le programme affiche
+// le resultat de chaque test puis le total.
+
+#include "../libraries/parallel.h"
+#include "../libraries/meso.h"
+#include "../libraries/optimizer.h"
+#include "../libraries/historystore.h"
+
+int checkFailures = 0; // Conditions fausses du test en cours
+
+#define CHECK(condition)                                                         \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            printf("  %s:%d : %s\n", __FILE__, __LINE__, #condition);            \
+            checkFailures++;                                                     \
+        }                                                                        \
+    } while (0)
+
+// Vehicules passes au feu (toutes voies, tous types) d'un reseau
+unsigned long networkServed(RoadNetwork* net) {
+    unsigned long total = 0;
+    for (int i = 0; i < net->count; i++) {
+        for (int d = 0; d < 4; d++) {
+            unsigned long served, lost;
+            LogHistogram wait;
+            laneMetricTotals(&net->nodes[i].metrics.lanes[d], &served, &lost, &wait);
+            total += served;
+        }
+    }
+    return total;
+}
+
+// Un bus en tete passe des le premier vert aux durees par defaut : un seul etage de passage
+// (DURATION_FOR_VEHICULE_PASSATION) par vert, moins que HEADWAY_BUS, credit remis a zero a chaque phase
+void testBusAtHeadLeavesEachGreen() {
+    ScenarioConfig saved = activeScenario;
+    activeScenario.passageDuration = 1;
+    activeScenario.headways[BUS] = 20;
+    lane lanes[4];
+    lane* lanePtrs[4];
+    for (int i = 0; i < 4; i++) {
+        Createlane(&lanes[i], 8, i + 1, (Direction)i);
+        lanePtrs[i] = &lanes[i];
+    }
+    Queue* aller = lanes[NORTH].aller;
+    aller->lightState = GREEN;
+    enqueue(aller, createVehicule(NULL, 1, BUS, 0, NORTH, STRAIGHT), NULL, NULL);
+    enqueue(aller, createVehicule(NULL, 2, CAR, 0, NORTH, STRAIGHT), NULL, NULL);
+    enqueue(aller, createVehicule(NULL, 3, BUS, 0, NORTH, STRAIGHT), NULL, NULL);
+
+    for (int green = 0; green < 3; green++) {
+        int credit = 0; // startPhase
+        credit += activeScenario.passageDuration * 10; // handleDischarge
+        DischargeResult r = processQueue(aller, NULL, NULL, (unsigned long)green, lanePtrs, 4, NULL, &credit, 1);
+        CHECK(r.moved == 1);
+    }
+    CHECK(isEmpty(aller));
+    for (int i = 0; i < 4; i++) {
+        while (!isEmpty(lanes[i].retour)) releaseVehicule(NULL, dequeue(lanes[i].retour, NULL));
+        freeQueue(lanes[i].aller);
+        freeQueue(lanes[i].retour);
+    }
+    activeScenario = saved;
+}
+
+// Un bus paie son intervalle en dette : le vehicule suivant attend le credit manquant
+void testHeadwayShortfallDelaysNextVehicle() {
+    lane lanes[4];
+    lane* lanePtrs[4];
+    for (int i = 0; i < 4; i++) {
+        Createlane(&lanes[i], 8, i + 1, (Direction)i);
+        lanePtrs[i] = &lanes[i];
+    }
+    Queue* aller = lanes[NORTH].aller;
+    aller->lightState = GREEN;
+    enqueue(aller, createVehicule(NULL, 1, BUS, 0, NORTH, STRAIGHT), NULL, NULL);
+    enqueue(aller, createVehicule(NULL, 2, CAR, 0, NORTH, STRAIGHT), NULL, NULL);
+    int credit = 10;
+    CHECK(processQueue(aller, NULL, NULL, 0, lanePtrs, 4, NULL, &credit, 1).moved == 1);
+    CHECK(credit == 10 - activeScenario.headways[BUS]);
+    credit += 10;
+    if (activeScenario.headways[BUS] >= 20) {
+        CHECK(processQueue(aller, NULL, NULL, 1, lanePtrs, 4, NULL, &credit, 1).moved == 0);
+    }
+    for (int i = 0; i < 4; i++) {
+        while (!isEmpty(lanes[i].aller)) releaseVehicule(NULL, dequeue(lanes[i].aller, NULL));
+        while (!isEmpty(lanes[i].retour)) releaseVehicule(NULL, dequeue(lanes[i].retour, NULL));
+        freeQueue(lanes[i].aller);
+        freeQueue(lanes[i].retour);
+    }
+}
+
+// Debit du corridor par defaut : les bus ne bloquent pas leurs voies (plus de 40000 vehicules en 1 h)
+void testCorridorThroughput() {
+    ScenarioConfig config = activeScenario;
+    RoadNetwork net;
+    buildCorridor(&net, config.networkSize, &config, config.seed);
+    runNetworkParallel(&net, 0, 3600, 1);
+    unsigned long served = networkServed(&net);
+    CHECK(served > 40000);
+    freeRoadNetwork(&net);
+}
+
+// Attente par voie mesuree depuis l'entree dans la voie : en aval d'une longue liaison, elle ne
+// compte pas le trajet depuis l'origine (files assez grandes pour eviter la remontee de file)
+void testDownstreamWaitExcludesTravel() {
+    ScenarioConfig config = activeScenario;
+    config.linkTravelTime = 60;
+    config.vehicleGenProb = 10;
+    config.queueCapacity = 100;
+    RoadNetwork net;
+    buildCorridor(&net, 3, &config, config.seed);
+    runNetworkParallel(&net, 0, 1800, 1);
+    for (int i = 0; i < net.count; i++) {
+        for (int d = 0; d < 4; d++) {
+            unsigned long served, lost;
+            LogHistogram wait;
+            laneMetricTotals(&net.nodes[i].metrics.lanes[d], &served, &lost, &wait);
+            CHECK(served > 0);
+            CHECK(wait.max < (unsigned int)config.linkTravelTime);
+        }
+    }
+    freeRoadNetwork(&net);
+}
+
+// Bornes de partition des threads (comme runNetworkParallel) : contigues, alignees sur les blocs
+// de l'etat des voies, et couvrant toutes les intersections, meme hors multiple de LANE_STATE_ALIGN
+void testPartitionCoversAllIntersections() {
+    static const int counts[] = {1, 7, 15, 16, 17, 31, 100, 1000, 1001};
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        int count = counts[c];
+        for (int threads = 1; threads <= 8; threads++) {
+            int previous = 0;
+            for (int p = 0; p < threads; p++) {
+                int first = alignLaneBlock((int)((long long)count * p / threads), count);
+                int last = alignLaneBlock((int)((long long)count * (p + 1) / threads), count);
+                CHECK(first == previous);
+                CHECK(first <= last);
+                CHECK(last == count || last % LANE_STATE_ALIGN == 0);
+                previous = last;
+            }
+            CHECK(previous == count);
+        }
+    }
+}
+
+// Un corridor de 100 intersections donne le meme etat final sur 1 et 4 threads
+void testPartitionMatchesSequential() {
+    ScenarioConfig config = activeScenario;
+    unsigned long long fingerprints[2];
+    int threads[2] = {1, 4};
+    for (int k = 0; k < 2; k++) {
+        RoadNetwork net;
+        buildCorridor(&net, 100, &config, config.seed);
+        runNetworkParallel(&net, 0, 300, threads[k]);
+        fingerprints[k] = networkFingerprint(&net);
+        freeRoadNetwork(&net);
+    }
+    CHECK(fingerprints[0] == fingerprints[1]);
+}
+
+// Les enregistrements perdus (anneau plein) sont comptes dans l'en-tete du journal a la fermeture
+void testTrafficLogRecordsDropped() {
+    const char* path = "tests_log.bin";
+    TrafficLog* log = openTrafficLog(path, 2);
+    CHECK(log != NULL);
+    if (log == NULL) return;
+    for (int i = 0; i < 100000; i++) writeLogRecord(log, LOG_VEHICLE_MOVED, 0, i, 0, 0, 0);
+    unsigned long dropped = atomic_load(&log->dropped);
+    closeTrafficLog(log);
+    FILE* file = fopen(path, "rb");
+    LogFileHeader header;
+    CHECK(file != NULL && fread(&header, sizeof(header), 1, file) == 1);
+    if (file != NULL) fclose(file);
+    remove(path);
+    CHECK(dropped > 0);
+    CHECK(header.version == TRAFFIC_LOG_VERSION);
+    CHECK(header.dropped == dropped);
+}
+
+// Le moteur mesoscopique n'accepte que les feux fixes : les autres controleurs sont refuses
+void testMesoRejectsUnsupportedControllers() {
+    ScenarioConfig config = activeScenario;
+    config.signalController = CONTROLLER_FIXED;
+    CHECK(mesoUnsupportedScenario(&config) == NULL);
+    config.signalController = CONTROLLER_ACTUATED;
+    CHECK(mesoUnsupportedScenario(&config) != NULL);
+    config.signalController = CONTROLLER_MAX_PRESSURE;
+    CHECK(mesoUnsupportedScenario(&config) != NULL);
+}
+
+// Un etat chauffe illisible est une erreur d'evaluation, pas une variante abandonnee
+void testOptimizerReportsMissingWarmState() {
+    ScenarioConfig config = activeScenario;
+    PlanEvaluator e = {&config, "tests_missing_warm.bin", 0};
+    TimingPlan plans[2];
+    PlanScore scores[2];
+    for (int c = 0; c < 2; c++) {
+        allocTimingPlan(&plans[c], config.networkSize);
+        for (int i = 0; i < config.networkSize; i++) {
+            SignalTiming t = {2 * config.baseGreenDuration, config.baseGreenDuration, 0};
+            plans[c].timings[i] = t;
+        }
+    }
+    remove(e.warmPath);
+    CHECK(evaluateTimingPlan(&e, &plans[0], NULL, &scores[0]) == 0);
+    CHECK(evaluateCandidates(&e, plans, 2, NULL, scores, 2) == 0);
+    for (int c = 0; c < 2; c++) freeTimingPlan(&plans[c]);
+}
+
+// Ajoute "count" enregistrements a l'historique "base" (cree au besoin)
+int fillHistoryStore(const char* base, int count) {
+    HistoryStore store;
+    if (!openHistoryStore(&store, base)) {
+        closeHistoryStore(&store);
+        return 0;
+    }
+    beginHistoryRun(&store);
+    for (int i = 0; i < count; i++) {
+        HistoryRecord r = {i, (unsigned int)i, (unsigned int)i, (unsigned char)(i % 4), (unsigned char)(i % 4), 0, 0};
+        appendHistoryRecord(&store, &r);
+    }
+    closeHistoryStore(&store);
+    return 1;
+}
+
+// Ecrit "size" octets de "data" a "offset" dans "path" (NULL : tronque le fichier a zero)
+void patchFile(const char* path, long offset, const void* data, size_t size) {
+    FILE* file = fopen(path, (data != NULL) ? "r+b" : "wb");
+    if (file == NULL) return;
+    if (data != NULL && fseek(file, offset, SEEK_SET) == 0) fwrite(data, size, 1, file);
+    fclose(file);
+}
+
+// Nombre d'enregistrements trouves par une recherche de tout l'historique (-1 : ouverture refusee)
+long long countHistoryStore(const char* base) {
+    HistoryStore store;
+    long long found = -1;
+    if (openHistoryStore(&store, base)) {
+        HistoryQuery all = {-1, -1, -1, 0, UINT_MAX};
+        found = queryHistoryStore(&store, &all, NULL, NULL);
+    }
+    closeHistoryStore(&store);
+    return found;
+}
+
+// A la reouverture, un index absent ou abime est reconstruit ; un autre format est refuse
+void testHistoryStoreValidatesOnReopen() {
+    const char* base = "tests_history";
+    const char* rec = "tests_history.rec";
+    const char* idx = "tests_history.idx";
+    remove(rec);
+    remove(idx);
+    CHECK(fillHistoryStore(base, 5000));
+    CHECK(countHistoryStore(base) == 5000);
+
+    patchFile(idx, 0, NULL, 0);
+    CHECK(countHistoryStore(base) == 5000);
+    unsigned short badKey = 0xFFFF;
+    patchFile(idx, 0, &badKey, sizeof(badKey));
+    CHECK(countHistoryStore(base) == 5000);
+    unsigned int oldBlockSize = 1024;
+    patchFile(rec, (long)offsetof(HistoryFileHeader, blockSize), &oldBlockSize, sizeof(oldBlockSize));
+    CHECK(countHistoryStore(base) == 5000);
+    CHECK(fillHistoryStore(base, 10));
+    CHECK(countHistoryStore(base) == 5010);
+
+    // "<base>.rec" perime a cote d'un index plus recent : aucun posting au-dela des enregistrements
+    FILE* stale = fopen(rec, "rb");
+    HistoryFileHeader staleHeader;
+    CHECK(stale != NULL && fread(&staleHeader, sizeof(staleHeader), 1, stale) == 1);
+    if (stale != NULL) fclose(stale);
+    CHECK(fillHistoryStore(base, 1000));
+    patchFile(rec, 0, &staleHeader, sizeof(staleHeader));
+    CHECK(countHistoryStore(base) == 5010);
+    // Arret entre le compte et les postings d'un enregistrement : index reconstruit
+    unsigned long long oneMore = staleHeader.recordCount + 1;
+    patchFile(rec, (long)offsetof(HistoryFileHeader, recordCount), &oneMore, sizeof(oneMore));
+    CHECK(countHistoryStore(base) == 5011);
+
+    unsigned int otherRecordSize = sizeof(HistoryRecord) + 4;
+    patchFile(rec, (long)offsetof(HistoryFileHeader, recordSize), &otherRecordSize, sizeof(otherRecordSize));
+    CHECK(countHistoryStore(base) == -1);
+    unsigned int recordSize = sizeof(HistoryRecord);
+    patchFile(rec, (long)offsetof(HistoryFileHeader, recordSize), &recordSize, sizeof(recordSize));
+    unsigned int futureVersion = HISTORY_STORE_VERSION + 1;
+    patchFile(rec, (long)offsetof(HistoryFileHeader, version), &futureVersion, sizeof(futureVersion));
+    CHECK(countHistoryStore(base) == -1);
+    remove(rec);
+    remove(idx);
+}
+
+// Le debit des replications Monte Carlo est celui des feux : bien au-dela de ce que contiennent
+// les voies de retour (4 x QUEUE_CAPACITY) et variable d'une replication a l'autre
+void testMonteCarloThroughputNotExitCapped() {
+    ScenarioConfig config = activeScenario;
+    config.replications = 10;
+    ReplicationResult results[10];
+    runReplications(&config, results, 2);
+    Estimate total = estimateLaneMetric(results, config.replications, INTERSECTION_TOTAL,
+                                        offsetof(LaneSample, throughput));
+    double exitCapacity = 4.0 * config.queueCapacity * 3600.0 / config.replicationDuration;
+    CHECK(total.mean > 10.0 * exitCapacity);
+    CHECK(total.halfWidth > 0.0);
+}
+
+// Un parametre entier refuse les valeurs non entieres ou hors d'un int ; les pourcentages sont bornes
+void testScenarioRejectsInvalidValues() {
+    ScenarioConfig config = activeScenario;
+    const ScenarioParam* replications = findScenarioParam("MONTE_CARLO_REPLICATIONS");
+    CHECK(!setScenarioValue(&config, replications, 2.9));
+    CHECK(!setScenarioValue(&config, replications, 1e12));
+    CHECK(config.replications == activeScenario.replications);
+    CHECK(setScenarioValue(&config, replications, 3) && config.replications == 3);
+    CHECK(setScenarioValue(&config, findScenarioParam("TRAFFIC_JAM_THRESHOLD"), 0.25));
+
+    config = activeScenario;
+    config.vehicleGenProb = -50;
+    CHECK(!validateScenario(&config));
+    config.vehicleGenProb = 101;
+    CHECK(!validateScenario(&config));
+    config.vehicleGenProb = 100;
+    config.emergencyChance = 101;
+    CHECK(!validateScenario(&config));
+    config.emergencyChance = 0;
+    CHECK(validateScenario(&config));
+    config.historyMemoryLimit = 0;
+    CHECK(!validateScenario(&config));
+    CHECK(setScenarioValue(&config, findScenarioParam("HISTORY_MEMORY_LIMIT"), 4096));
+    CHECK(config.historyMemoryLimit == 4096 && validateScenario(&config));
+}
+
+typedef struct {
+    const char* name;
+    void (*run)();
+} TestCase;
+
+static const TestCase testCases[] = {
+    {"bus_at_head_leaves_each_green", testBusAtHeadLeavesEachGreen},
+    {"headway_shortfall_delays_next_vehicle", testHeadwayShortfallDelaysNextVehicle},
+    {"corridor_throughput", testCorridorThroughput},
+    {"downstream_wait_excludes_travel", testDownstreamWaitExcludesTravel},
+    {"partition_covers_all_intersections", testPartitionCoversAllIntersections},
+    {"partition_matches_sequential", testPartitionMatchesSequential},
+    {"traffic_log_records_dropped", testTrafficLogRecordsDropped},
+    {"meso_rejects_unsupported_controllers", testMesoRejectsUnsupportedControllers},
+    {"optimizer_reports_missing_warm_state", testOptimizerReportsMissingWarmState},
+    {"history_store_validates_on_reopen", testHistoryStoreValidatesOnReopen},
+    {"montecarlo_throughput_not_exit_capped", testMonteCarloThroughputNotExitCapped},
+    {"scenario_rejects_invalid_values", testScenarioRejectsInvalidValues},
+};
+
+int main() {
+    consoleOutput = 0;
+    int failed = 0;
+    int count = (int)(sizeof(testCases) / sizeof(testCases[0]));
+    for (int i = 0; i < count; i++) {
+        checkFailures = 0;
+        testCases[i].run();
+        printf("%-44s %s\n", testCases[i].name, checkFailures ? "ECHEC" : "ok");
+        failed += checkFailures != 0;
+    }
+    printf("%d/%d tests reussis\n", count - failed, count);
+    return failed;
+}
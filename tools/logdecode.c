@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../libraries/queue.h"
+
+/* --- Decodeur du journal binaire : restitue le format texte de traffic_simulation.log --- */
+// Usage : logdecode [--at T] [journal.bin] [sortie.log]   (par defaut traffic_simulation.bin -> stdout)
+// Avec --at, les files sont reconstruites a l'instant T depuis l'image cle precedente et les
+// differences qui la suivent ; chaque image cle rencontree sert aussi a verifier la reconstruction.
+
+// Ecrit l'horodatage d'un enregistrement au format du journal texte
+void printTimestamp(FILE* out, long long wallTime) {
+    time_t t = (time_t)wallTime;
+    char timestamp[20];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&t));
+    fprintf(out, "[%s] ", timestamp);
+}
+
+// Restitue un enregistrement en texte
+void renderLogRecord(FILE* out, const LogRecord* r) {
+    switch (r->kind) {
+        case LOG_MESSAGE:
+            printTimestamp(out, r->wallTime);
+            fprintf(out, "%s\n", logMessageText(r->code));
+            break;
+        case LOG_QUEUE_STATE: {
+            int flags = r->args[2];
+            fprintf(out, "\n=== File %s (%s) ===\n", dirToString((Direction)r->code),
+                    (flags & 4) ? "Retour" : "Aller");
+            fprintf(out, "Taille: %d/%d | Feu: %s | Embouteillage: %s | Vert: %ds, Rouge: %ds\n",
+                    r->args[0], r->args[1], (flags & 1) ? "VERT" : "ROUGE", (flags & 2) ? "Oui" : "Non",
+                    r->args[3] >> 16, (short)(r->args[3] & 0xFFFF));
+            break;
+        }
+        case LOG_QUEUE_ADDED:
+            fprintf(out, "t=%u Vehicule %d (Type: %s, Tourne: %s) ajoute %s de la file %s (%s)\n", r->simTime,
+                    r->args[0], typeToString((VehiculeType)r->args[1]), turnToString((TurnDirection)r->args[2]),
+                    (r->args[3] & LOG_FLAG_FRONT) ? "en tete" : "en queue", dirToString((Direction)r->code),
+                    (r->args[3] & LOG_FLAG_RETURN) ? "Retour" : "Aller");
+            break;
+        case LOG_QUEUE_REMOVED:
+            if (r->args[1] > 1) {
+                fprintf(out, "t=%u Vehicules %d et suivants (%d) retires de la file %s (%s)\n", r->simTime,
+                        r->args[0], r->args[1], dirToString((Direction)r->code),
+                        (r->args[3] & LOG_FLAG_RETURN) ? "Retour" : "Aller");
+                break;
+            }
+            fprintf(out, "t=%u Vehicule %d retire de la file %s (%s)\n", r->simTime, r->args[0],
+                    dirToString((Direction)r->code), (r->args[3] & LOG_FLAG_RETURN) ? "Retour" : "Aller");
+            break;
+        case LOG_QUEUE_SIGNAL: {
+            int flags = r->args[3];
+            fprintf(out, "t=%u File %s (%s) | Taille: %d | Feu: %s | Embouteillage: %s | Vert: %ds, Rouge: %ds\n",
+                    r->simTime, dirToString((Direction)r->code), (flags & LOG_FLAG_RETURN) ? "Retour" : "Aller",
+                    r->args[0], (flags & LOG_FLAG_GREEN) ? "VERT" : "ROUGE", (flags & LOG_FLAG_JAM) ? "Oui" : "Non",
+                    r->args[2] >> 16, (short)(r->args[2] & 0xFFFF));
+            break;
+        }
+        case LOG_QUEUE_VEHICLE:
+            fprintf(out, "Vehicule %d (Type: %s, Tourne: %s)\n", r->args[0],
+                    typeToString((VehiculeType)r->args[1]), turnToString((TurnDirection)r->args[2]));
+            break;
+        case LOG_VEHICLE_MOVED:
+            fprintf(out, "Vehicle %d moved to %s return lane\n", r->args[0], dirToString((Direction)r->code));
+            break;
+        case LOG_VEHICLE_LOST:
+            fprintf(out, "Vehicle %d lost (return lane full)\n", r->args[0]);
+            break;
+        case LOG_VEHICLE_INVALID:
+            fprintf(out, "Donnees vehicule invalides: ID=%d, Temps=%u\n", r->args[0], (unsigned int)r->args[1]);
+            break;
+        case LOG_CREATE_FAILED:
+            fprintf(out, "Erreur: Impossible de creer le vehicule %d\n", r->args[0]);
+            break;
+        default:
+            fprintf(out, "Enregistrement inconnu (nature %u)\n", r->kind);
+    }
+}
+
+/* --- Reconstruction de l'etat des files (--at) --- */
+
+// Vehicule tel que le journal le decrit
+typedef struct {
+    int id;
+    int type;
+    int turn;
+} LoggedVehicle;
+
+// File reconstruite : anneau de "capacity" cases, connu apres sa premiere image cle
+typedef struct {
+    int known;
+    int capacity;
+    int head;
+    int size;
+    int flags;
+    int durations;
+    LoggedVehicle* slots;
+} RebuiltQueue;
+
+// Huit files d'une intersection : 4 directions x (aller, retour)
+typedef struct {
+    RebuiltQueue queues[8];
+    RebuiltQueue keyframe;   // Image cle en cours de lecture (comparee a la reconstruction)
+    int keyframeIndex;       // File decrite par l'image cle en cours (-1 : aucune)
+    long keyframes;          // Images cles verifiees
+    long mismatches;         // Images cles differentes de la reconstruction
+    long orphans;            // Differences incoherentes avec l'etat reconstruit (enregistrements perdus)
+} RebuiltState;
+
+int rebuiltIndex(int direction, int flags) {
+    return (direction & 3) * 2 + ((flags & LOG_FLAG_RETURN) ? 1 : 0);
+}
+
+LoggedVehicle* rebuiltAt(RebuiltQueue* q, int i) {
+    return &q->slots[(q->head + i) % q->capacity];
+}
+
+void resetRebuiltQueue(RebuiltQueue* q, int capacity) {
+    if (capacity < 1) capacity = 1;
+    if (q->capacity != capacity) {
+        free(q->slots);
+        q->slots = (LoggedVehicle*)malloc(sizeof(LoggedVehicle) * capacity);
+        q->capacity = capacity;
+    }
+    q->head = 0;
+    q->size = 0;
+    q->known = 1;
+}
+
+// Compare les vehicules de deux files (les feux d'une image cle ne sont pas journalises a part)
+int sameRebuiltQueue(RebuiltQueue* a, RebuiltQueue* b) {
+    if (a->size != b->size) return 0;
+    for (int i = 0; i < a->size; i++) {
+        if (rebuiltAt(a, i)->id != rebuiltAt(b, i)->id) return 0;
+    }
+    return 1;
+}
+
+// Termine l'image cle en cours : elle devient l'etat de sa file apres verification
+void closeKeyframe(RebuiltState* s) {
+    if (s->keyframeIndex < 0) return;
+    RebuiltQueue* q = &s->queues[s->keyframeIndex];
+    if (q->known) {
+        s->keyframes++;
+        if (!sameRebuiltQueue(q, &s->keyframe)) s->mismatches++;
+    }
+    RebuiltQueue swap = *q;
+    *q = s->keyframe;
+    s->keyframe = swap;
+    s->keyframeIndex = -1;
+}
+
+// Applique un enregistrement a l'etat reconstruit
+void applyLogRecord(RebuiltState* s, const LogRecord* r) {
+    if (r->kind != LOG_QUEUE_VEHICLE) closeKeyframe(s);
+    switch (r->kind) {
+        case LOG_QUEUE_STATE: {
+            s->keyframeIndex = rebuiltIndex(r->code, r->args[2]);
+            resetRebuiltQueue(&s->keyframe, r->args[1]);
+            s->keyframe.flags = r->args[2];
+            s->keyframe.durations = r->args[3];
+            break;
+        }
+        case LOG_QUEUE_VEHICLE: {
+            RebuiltQueue* k = &s->keyframe;
+            if (s->keyframeIndex < 0 || k->size >= k->capacity) break;
+            LoggedVehicle* v = rebuiltAt(k, k->size++);
+            v->id = r->args[0];
+            v->type = r->args[1];
+            v->turn = r->args[2];
+            break;
+        }
+        case LOG_QUEUE_ADDED: {
+            RebuiltQueue* q = &s->queues[rebuiltIndex(r->code, r->args[3])];
+            if (!q->known) break; // avant la premiere image cle de la file
+            if (q->size >= q->capacity) {
+                s->orphans++;
+                break;
+            }
+            LoggedVehicle* v;
+            if (r->args[3] & LOG_FLAG_FRONT) {
+                q->head = (q->head + q->capacity - 1) % q->capacity;
+                q->size++;
+                v = rebuiltAt(q, 0);
+            } else {
+                v = rebuiltAt(q, q->size++);
+            }
+            v->id = r->args[0];
+            v->type = r->args[1];
+            v->turn = r->args[2];
+            break;
+        }
+        case LOG_QUEUE_REMOVED: {
+            RebuiltQueue* q = &s->queues[rebuiltIndex(r->code, r->args[3])];
+            if (!q->known) break;
+            int count = (r->args[1] > 0) ? r->args[1] : 1; // lot de vehicules de tete
+            if (q->size < count || rebuiltAt(q, 0)->id != r->args[0]) {
+                s->orphans++;
+                break;
+            }
+            q->head = (q->head + count) % q->capacity;
+            q->size -= count;
+            break;
+        }
+        case LOG_QUEUE_SIGNAL: {
+            RebuiltQueue* q = &s->queues[rebuiltIndex(r->code, r->args[3])];
+            q->flags = r->args[3];
+            q->durations = r->args[2];
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Affiche les files reconstruites au format des images cles
+void printRebuiltState(FILE* out, RebuiltState* s, unsigned int at) {
+    fprintf(out, "Etat des files a t=%u\n", at);
+    for (int i = 0; i < 8; i++) {
+        RebuiltQueue* q = &s->queues[i];
+        if (!q->known) continue;
+        fprintf(out, "\n=== File %s (%s) ===\n", dirToString((Direction)(i / 2)), (i & 1) ? "Retour" : "Aller");
+        fprintf(out, "Taille: %d/%d | Feu: %s | Embouteillage: %s | Vert: %ds, Rouge: %ds\n",
+                q->size, q->capacity, (q->flags & LOG_FLAG_GREEN) ? "VERT" : "ROUGE",
+                (q->flags & LOG_FLAG_JAM) ? "Oui" : "Non", q->durations >> 16, (short)(q->durations & 0xFFFF));
+        for (int k = 0; k < q->size; k++) {
+            LoggedVehicle* v = rebuiltAt(q, k);
+            fprintf(out, "Vehicule %d (Type: %s, Tourne: %s)\n", v->id,
+                    typeToString((VehiculeType)v->type), turnToString((TurnDirection)v->turn));
+        }
+    }
+    fprintf(out, "\n%ld images cles verifiees, %ld differentes de la reconstruction, %ld differences incoherentes\n",
+            s->keyframes, s->mismatches, s->orphans);
+}
+
+int main(int argc, char** argv) {
+    // --at T : reconstruction des files a l'instant T au lieu de la restitution du journal
+    long at = -1;
+    if (argc > 2 && strcmp(argv[1], "--at") == 0) {
+        at = atol(argv[2]);
+        argv += 2;
+        argc -= 2;
+    }
+    const char* inputPath = (argc > 1) ? argv[1] : TRAFFIC_LOG_PATH;
+    FILE* in = fopen(inputPath, "rb");
+    if (in == NULL) {
+        perror("Erreur ouverture journal binaire");
+        return EXIT_FAILURE;
+    }
+    FILE* out = stdout;
+    if (argc > 2) {
+        out = fopen(argv[2], "w");
+        if (out == NULL) {
+            perror("Erreur creation fichier texte");
+            fclose(in);
+            return EXIT_FAILURE;
+        }
+    }
+
+    LogFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != TRAFFIC_LOG_MAGIC
+        || header.recordSize != sizeof(LogRecord)) {
+        fprintf(stderr, "Format de journal invalide: %s\n", inputPath);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+    if (header.version != TRAFFIC_LOG_VERSION) {
+        fprintf(stderr, "Version de journal %u non prise en charge (attendue : %u): %s\n",
+                header.version, TRAFFIC_LOG_VERSION, inputPath);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+    // Un retrait ou un ajout perdu fausse la reconstruction jusqu'a l'image cle suivante
+    if (header.dropped > 0) {
+        fprintf(stderr, "Attention : %u enregistrements perdus a l'ecriture (anneau plein)%s\n",
+                header.dropped, (at >= 0) ? ", les files reconstruites peuvent etre fausses" : "");
+    }
+
+    LogRecord batch[1024];
+    size_t n;
+    if (at >= 0) {
+        // Les images cles d'un pas suivent ses differences : l'etat a T est complet au premier
+        // enregistrement d'un pas ulterieur
+        RebuiltState state;
+        memset(&state, 0, sizeof(state));
+        state.keyframeIndex = -1;
+        int done = 0;
+        while (!done && (n = fread(batch, sizeof(LogRecord), 1024, in)) > 0) {
+            for (size_t i = 0; i < n && !done; i++) {
+                if (batch[i].simTime > (unsigned int)at) done = 1;
+                else applyLogRecord(&state, &batch[i]);
+            }
+        }
+        closeKeyframe(&state);
+        printRebuiltState(out, &state, (unsigned int)at);
+        for (int i = 0; i < 8; i++) free(state.queues[i].slots);
+        free(state.keyframe.slots);
+    } else {
+        while ((n = fread(batch, sizeof(LogRecord), 1024, in)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                renderLogRecord(out, &batch[i]);
+            }
+        }
+    }
+
+    fclose(in);
+    if (out != stdout) fclose(out);
+    return EXIT_SUCCESS;
+}